@@ -37,10 +37,32 @@
 #include "gemdosif.h"
 
 #include "asm.h"
+#include "tosvars.h"
+#include "xbiosbind.h"
 
 #define KEYMASK 0xffff0000L             /* for comparing data to KEYSTOP */
 #define KEYSTOP 0x2b1c0000L             /* control-backslash */
 
+/*
+ * while idle, the keyboard is only polled via the VDI when the keyboard
+ * buffer or the shift keys change, or every KBD_POLL_TICKS 200Hz ticks
+ * for the console drivers that don't use the keyboard IOREC
+ */
+#define KBD_POLL_TICKS  4
+
+/* the start of the keyboard IOREC returned by Iorec(1) */
+typedef struct
+{
+    UBYTE *buf;
+    WORD size;
+    volatile WORD head;
+    volatile WORD tail;
+} KBDIOREC;
+
+static KBDIOREC *kbd_iorec;
+static volatile UBYTE *kbd_shift;
+static ULONG kbd_polltime;              /* hz_200 at the last poll */
+
 
 /*
  * forkq(): put an FPD (containing a function address and a parameter) into the fork ring
@@ -178,9 +200,39 @@ void chkkbd(void)
 }
 
 
+void disp_init(void)
+{
+    kbd_iorec = (KBDIOREC *)Iorec(1);
+    kbd_shift = sysbase->os_kbshift;
+    kbd_polltime = hz_200;
+}
+
+
+/*
+ * return TRUE if chkkbd() may have something to do
+ */
+static BOOL kbd_pending(void)
+{
+    if (gl_play)
+        return FALSE;
+
+    if ((*kbd_shift & 0x0f) != kstate)
+        return TRUE;
+
+    if ((kbd_iorec->head != kbd_iorec->tail)
+     && (gl_mowner->p_cda->c_q.c_cnt < KBD_SIZE))
+        return TRUE;
+
+    return (hz_200 - kbd_polltime) >= KBD_POLL_TICKS;
+}
+
+
 static void schedule(void)
 {
     AESPD *p;
+#if USE_STOP_INSN_TO_FREE_HOST_CPU
+    WORD old_sr;
+#endif
 
     /* run through lists until someone is on the rlr
      * or the fork list
@@ -188,7 +240,11 @@ static void schedule(void)
     for (;;)
     {
         /* poll the keyboard    */
-        chkkbd();
+        if (kbd_pending())
+        {
+            kbd_polltime = hz_200;
+            chkkbd();
+        }
         /* now move drl processes to rlr */
         while (drl)
         {
@@ -199,7 +255,18 @@ static void schedule(void)
         if (rlr || fpcnt)
             break;
 #if USE_STOP_INSN_TO_FREE_HOST_CPU
-        stop_until_interrupt();
+        /*
+         * nothing to do until an interrupt: the mouse and timer events
+         * are queued by interrupt routines via forkq(), the keys arrive
+         * in the keyboard buffer.  we check again with interrupts off,
+         * so that one which has just happened doesn't make us wait for
+         * the next one.
+         */
+        old_sr = set_sr(0x2700);
+        if (!fpcnt && !kbd_pending())
+            stop_with_sr(old_sr);
+        else
+            set_sr(old_sr);
 #endif
     }
 }
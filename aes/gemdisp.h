@@ -12,6 +12,7 @@
 
 #include "struct.h"
 
+void disp_init(void);
 WORD forkq(FCODE fcode, LONG fdata);
 void forker(void);
 void chkkbd(void);
@@ -36,6 +36,7 @@
 #include "gemgsxif.h"
 #include "gemdosif.h"
 #include "gemctrl.h"
+#include "gemdisp.h"
 #include "gemshlib.h"
 #include "gempd.h"
 #include "gemrslib.h"
@@ -746,6 +747,7 @@ void gem_main(void)
     }
 
     /* initialise AES libraries */
+    disp_init();
     fm_init();
     mn_init();
 
@@ -29,9 +29,11 @@
 #include "time.h"
 #include "gemerror.h"
 #include "biosbind.h"
+#include "biosext.h"
 #include "string.h"
 #include "bdosstub.h"
 #include "tosvars.h"
+#include "cookie.h"
 
 /*
 **  externals
@@ -56,10 +58,23 @@ static long xgetver(void);
 /*
  *  defines for some standard GEMDOS calls
  */
+#define GEMDOS_DFREE    0x36
+#define GEMDOS_DCREATE  0x39
+#define GEMDOS_DDELETE  0x3a
+#define GEMDOS_DSETPATH 0x3b
 #define GEMDOS_FCREATE  0x3c
 #define GEMDOS_FOPEN    0x3d
+#define GEMDOS_FCLOSE   0x3e
 #define GEMDOS_FREAD    0x3f
 #define GEMDOS_FWRITE   0x40
+#define GEMDOS_FDELETE  0x41
+#define GEMDOS_FSEEK    0x42
+#define GEMDOS_FATTRIB  0x43
+#define GEMDOS_DGETPATH 0x47
+#define GEMDOS_FSFIRST  0x4e
+#define GEMDOS_FSNEXT   0x4f
+#define GEMDOS_FRENAME  0x56
+#define GEMDOS_FDATIME  0x57
 
 
 /*
@@ -80,6 +95,9 @@ static PD initial_basepage;
 /* initial environment string */
 static const char double_nul[2] __attribute__ ((aligned (2))) = { 0, 0 };
 
+/* EmuTOS statistics, pointed to by the ETST cookie */
+ETSTATS etstats;
+
 
 /*
  * SPECNAME - special name descriptor
@@ -275,8 +293,8 @@ static const FND funcs[] =
 
     { F(xsfirst),  0, 3 },      /* 0x4E */
     { F(xsnext),   0, 0 },      /* 0x4F */
+    { F(xsnextn),  0, 3 },      /* 0x50 - EmuTOS extension */
 
-    { NI, 0, 0 },               /* 0x50 */
     { NI, 0, 0 },
     { NI, 0, 0 },
     { NI, 0, 0 },
@@ -325,6 +343,10 @@ void osinit_before_xmaddalt(void)
      */
     old_trap2 = (PFVOID) Setexc(0x22, (long)bdos_trap2);
 
+    etstats.es_version = ETSTATS_VERSION;
+    etstats.es_size = sizeof(ETSTATS);
+    cookie_add(COOKIE_ETST, (ULONG)&etstats);
+
     bufl_init();    /* initialize BDOS buffer list */
 
     osmem_init();
@@ -374,6 +396,9 @@ static void freetree(DND *d)
             p->use = 0;
         }
     }
+#if CONF_WITH_BDOS_DIRHASH
+    dirhash_forget(d);
+#endif
     xmfreblk(d);
 }
 
@@ -408,7 +433,7 @@ static void offree(DMD *d)
 /*
  * mark_bcbs_invalid - mark the BCBs for the specified drive as invalid
  */
-static void mark_bcbs_invalid(int drv)
+void mark_bcbs_invalid(int drv)
 {
     BCB *bx;
     int i;
@@ -424,6 +449,43 @@ static void mark_bcbs_invalid(int drv)
 }
 
 
+#if CONF_WITH_BDOS_CACHE
+/*
+ *  is_fs_function - true for the GEMDOS calls which may access the disk
+ *
+ *  only these may do the timed flush of the buffer cache: an error while
+ *  writing back must not become the return value of a call which has
+ *  nothing to do with the file system, such as Malloc() or Pterm().
+ */
+static BOOL is_fs_function(int fn)
+{
+    switch(fn)
+    {
+    case GEMDOS_DFREE:
+    case GEMDOS_DCREATE:
+    case GEMDOS_DDELETE:
+    case GEMDOS_DSETPATH:
+    case GEMDOS_FCREATE:
+    case GEMDOS_FOPEN:
+    case GEMDOS_FCLOSE:
+    case GEMDOS_FREAD:
+    case GEMDOS_FWRITE:
+    case GEMDOS_FDELETE:
+    case GEMDOS_FSEEK:
+    case GEMDOS_FATTRIB:
+    case GEMDOS_DGETPATH:
+    case GEMDOS_FSFIRST:
+    case GEMDOS_FSNEXT:
+    case GEMDOS_FRENAME:
+    case GEMDOS_FDATIME:
+        return TRUE;
+    }
+
+    return FALSE;
+}
+#endif
+
+
 /*
  *  osif - C implementation of trap #1. Called by _enter.
  */
@@ -459,6 +521,15 @@ restrt:
             dmd = drvtbl[errdrv];
             dn = dmd->m_dtl;
             offree(dmd);
+#if CONF_WITH_BDOS_FREEMAP
+            freemap_release(dmd);
+#endif
+#if CONF_WITH_BDOS_EXTMAP
+            extmap_invalidate(dmd);
+#endif
+#if CONF_WITH_PGMCACHE
+            pgmcache_invalidate(dmd, 0);
+#endif
             xmfreblk(dmd);
             drvtbl[errdrv] = NULL;
 
@@ -492,6 +563,11 @@ restrt:
         return rc;
     }
 
+#if CONF_WITH_BDOS_CACHE
+    if (is_fs_function(fn))
+        bufl_timed_flush();
+#endif
+
     f = &funcs[fn];
     typ = f->stdio_typ;
 
@@ -625,15 +701,19 @@ restrt:
 
                 pb2 = *pb;      /* char * is buffer address */
 
-                for (n = 0; n < count; n++)
+                if (num == H_Console)
                 {
-                    if (num == H_Console)
-                        tabout(HXFORM(num), (unsigned char)*pb2++);
-                    else
-                    {           /* M01.01.1029.01 */
-                        if (Bconout(HXFORM(num), (unsigned char)*pb2++) == 0)
-                            return n;
-                    }
+                    tabout_buf(HXFORM(num), pb2, count);
+                    return count;
+                }
+
+                if (bconout_run(HXFORM(num), (const UBYTE *)pb2, count))
+                    return count;
+
+                for (n = 0; n < count; n++)
+                {               /* M01.01.1029.01 */
+                    if (Bconout(HXFORM(num), (unsigned char)*pb2++) == 0)
+                        return n;
                 }
 
                 return count;
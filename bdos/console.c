@@ -18,10 +18,12 @@
 /* #define ENABLE_KDEBUG */
 
 #include "emutos.h"
+#include "string.h"
 #include "fs.h"
 #include "proc.h"
 #include "console.h"
 #include "biosbind.h"
+#include "biosext.h"
 #include "bdosstub.h"
 
 /*
@@ -206,16 +208,36 @@ long xauxostat(void)
 static void conbrk(int h)
 {
     TYPEAHEAD *bufptr;
+    long keys[16];
     long ch;
-    int stop, c;
+    int stop, c, i, n, room;
 
     stop = 0;
     if (Bconstat(h))
     {
         bufptr = buffer[h];
+        i = n = 0;
         do
         {
-            c = LOBYTE(ch = Bconin(h));
+            /*
+             * take as many of the waiting characters as the typeahead
+             * buffer can hold in one go, if the BIOS lets us do so;
+             * otherwise, read them one by one
+             */
+            if (i == n)
+            {
+                i = 0;
+                room = KBBUFSZ - (bufptr->add - bufptr->remove);
+                if (room > (int)ARRAY_SIZE(keys))
+                    room = ARRAY_SIZE(keys);
+                n = (room > 0) ? bconin_run(h, keys, room) : -1;
+                if (n <= 0)
+                {
+                    keys[0] = Bconin(h);
+                    n = 1;
+                }
+            }
+            c = LOBYTE(ch = keys[i++]);
             switch(c) {
             case ctrlc:
                 /* comments for the following used to say: "flush BDOS
@@ -239,7 +261,7 @@ static void conbrk(int h)
                     Bconout(h, 7);
                 break;
             }
-        } while (stop);
+        } while (stop || (i < n));
     }
 }
 
@@ -303,6 +325,46 @@ void tabout(int h, int ch)
 }
 
 
+/*
+ * tabout_buf - output a buffer with tab expansion
+ *
+ * Same as calling tabout() for each character, but runs of printable
+ * characters are passed to the BIOS in one go when it can take them.
+ *
+ * @h - device handle
+ * @p - characters to output
+ * @count - number of characters
+ */
+void tabout_buf(int h, const char *p, long count)
+{
+    const char *start;
+    long n;
+
+    while (count > 0)
+    {
+        if ((unsigned char)*p < ' ')
+        {
+            tabout(h, (unsigned char)*p++);
+            count--;
+            continue;
+        }
+
+        for (start = p; count > 0 && (unsigned char)*p >= ' '; p++)
+            count--;
+        n = p - start;
+
+        conbrk(h);                  /* check for control-s break */
+        if (bconout_run(h, (const UBYTE *)start, n))
+            glbcolumn[h] += n;      /* keep track of screen column */
+        else
+        {
+            while (start < p)
+                conout(h, (unsigned char)*start++);
+        }
+    }
+}
+
+
 /*
  * cookdout - console output with tab and control character expansion
  *
@@ -363,6 +425,12 @@ static long getch(int h)
                 buflush(bufptr);
             return temp;
         }
+
+#if CONF_WITH_BDOS_CACHE
+        /* about to wait for a key: a good time to write back the cache */
+        if (!Bconstat(h))
+            bufl_idle_flush();
+#endif
     }
 
     return Bconin(h);
@@ -467,8 +535,7 @@ void xconws(char *p)
  */
 static void prt_line(int h, char *p)
 {
-    while(*p)
-        tabout(h, (unsigned char)*p++);
+    tabout_buf(h, p, strlen(p));
 }
 
 
@@ -86,7 +86,11 @@ typedef struct _dnd DND;
 typedef struct _dmd DMD;
 
 typedef UWORD FH;               /*  file handle    */
+#if CONF_WITH_FAT32
+typedef ULONG CLNO;             /*  cluster number */
+#else
 typedef UWORD CLNO;             /*  cluster number */
+#endif
 typedef ULONG RECNO;            /*  record number  */
 
 
@@ -105,7 +109,9 @@ typedef struct
  *  DFD - disk file data
  *
  *  this contains a copy of the data from the FCB on disk and is
- *  contained within the OFD.
+ *  contained within the OFD.  the starting cluster number is in
+ *  internal format, so fcb_getcl()/fcb_setcl() must be used to
+ *  convert it from/to the FCB.
  *
  *  note: only one copy of the data is maintained in memory, in the
  *  DFD in the first-opened OFD for a given file (the 'base OFD').
@@ -117,17 +123,20 @@ typedef struct
 {
     UWORD o_flag;       /* see below                            */
     WORD  o_usecnt;     /* count of open OFDs pointing here     */
-                    /* the following 3 items must be as in FCB: */
     DOSTIME o_td;       /* creation time/date: little-endian!   */
     CLNO  o_strtcl;     /* starting cluster number              */
     long  o_fileln;     /* length of file in bytes              */
 } DFD;
 
 
+#define DIR_FILE_LENGTH 0x7fffffffL     /* fake size for directories */
+
+
 /*
  * bit usage in o_flag 
  */
 #define O_DIRTY     1   /* contents have changed, FCB on disk must be updated */ 
+#define O_PREALLOC  2   /* clusters may be allocated beyond end of file */
 
 
 
@@ -186,10 +195,12 @@ typedef struct
     UBYTE f_attrib;
     UBYTE f_fill[10];
     DOSTIME f_td;           /* time, date */
-    CLNO f_clust;
+    UWORD f_clust;          /* cluster number (low word on FAT32) */
     long f_fileln;
 } FCB;
 
+#define FCB_CLUSTHI     8       /* FAT32: f_fill[] offset of cluster high word */
+
 #define ERASE_MARKER    '\xe5'  /* in f_name[0], indicates erased file */
 
 #define FA_NORM         (FA_ARCHIVE|FA_SYSTEM|FA_HIDDEN|FA_RO)
@@ -240,25 +251,35 @@ struct _dnd         /* directory node descriptor */
 struct _dmd         /* drive media block */
 {
     RECNO  m_recoff[3]; /*  record offsets for fat,dir,data     */
+                        /*   (FAT32: the 'dir' offset is that   */
+                        /*   of the FSInfo sector, or 0)        */
     WORD   m_drvnum;    /*  drive number for this media         */
-    WORD   m_fsiz;      /*  fat size in records M01.01.03       */
     WORD   m_clsiz;     /*  cluster size in records M01.01.03   */
     UWORD  m_clsizb;    /*  cluster size in bytes               */
     UWORD  m_recsiz;    /*  record size in bytes                */
+    RECNO  m_fsiz;      /*  fat size in records M01.01.03       */
 
     CLNO   m_numcl;     /*  total number of clusters in data    */
-    WORD   m_clrlog;    /* log (base 2) of clsiz in records     */
     WORD   m_clrm;      /* clsiz in rec, mask                   */
-    WORD   m_rblog;     /* log (base 2) of recsiz in bytes      */
     WORD   m_rbm;       /* recsiz in bytes, mask                */
-    WORD   m_clblog;    /* log (base 2) of clsiz in bytes       */
     WORD   m_clbm;      /* clsiz in bytes, mask                 */
+    UBYTE  m_clrlog;    /* log (base 2) of clsiz in records     */
+    UBYTE  m_rblog;     /* log (base 2) of recsiz in bytes      */
+    UBYTE  m_clblog;    /* log (base 2) of clsiz in bytes       */
+    UBYTE  m_16;        /* 16 bit fat ?                         */
+    UBYTE  m_1fat;      /* 1 FAT only ?                         */
+    UBYTE  m_32;        /* 32 bit fat ?                         */
     OFD    *m_fatofd;   /* OFD for 'fat file'                   */
 
     OFD    *m_ofl;      /*  list of open files                  */
     DND    *m_dtl;      /* root of directory tree list          */
-    UBYTE  m_16;        /* 16 bit fat ?                         */
-    UBYTE  m_1fat;      /* 1 FAT only ?                         */
+#if CONF_WITH_BDOS_FREEMAP
+    UBYTE  *m_freemap;  /* bitmap of free clusters, or NULL     */
+#endif
+#if CONF_WITH_BDOS_FREEMAP || CONF_WITH_FAT32
+    CLNO   m_nfree;     /* number of free clusters, if known    */
+    CLNO   m_nextfree;  /* no free cluster below this one       */
+#endif
 } ;
 
 
@@ -299,6 +320,26 @@ struct _bcb
     UBYTE   *b_bufr;    /*  pointer to buffer (API)     */
 } ;
 
+#if CONF_WITH_BDOS_CACHE
+/*
+ *  BCX - extended Buffer Control Block
+ *
+ *  the buffers allocated by the BDOS itself are BCXs.  the public BCB
+ *  comes first, so a BCX may be linked into the bufl[] chains like any
+ *  other BCB; the remaining fields are private to fsbuf.c.
+ */
+typedef struct _bcx BCX;
+struct _bcx
+{
+    BCB     x_bcb;      /*  public part, must be first  */
+    BCX     *x_prev;    /*  previous (more recently used) buffer in list */
+    BCX     *x_hnext;   /*  next buffer in the same hash bucket */
+    UWORD   x_bucket;   /*  hash bucket, or BC_NOBUCKET */
+} ;
+
+#define BC_NOBUCKET     0xffff
+#endif
+
 /*
  * FTAB - Open File Table Entry
  */
@@ -324,9 +365,11 @@ typedef struct
                                 /*   bits 4-0: drive id                 */
                                 /*   bits 31-5: if root, offset to next */
                                 /*    FCB, otherwise 0                  */
+                                /*   (FAT32: if subdir, high word of    */
+                                /*    current cluster number)           */
     UWORD dt_cloffset;          /*  if subdir, offset within cluster to */
                                 /*   next FCB, otherwise 0              */
-    CLNO  dt_clnum;             /*  if subdir, current cluster number,  */
+    UWORD dt_clnum;             /*  if subdir, current cluster number,  */
                                 /*   otherwise 0                        */
     char  dt_attr;              /*  attribute from Fsfirst()            */
                             /* public area, must not change             */
@@ -351,6 +394,7 @@ extern  DIRTBL_ENTRY dirtbl[];
 extern  DMD     *drvtbl[];
 extern  LONG    drvsel;
 extern  FTAB    sft[];
+extern  ETSTATS etstats;
 
 
 
@@ -409,8 +453,19 @@ BOOL contains_illegal_characters(const char *test);
 void bufl_init(void);
 /* ??? */
 void flush(BCB *b);
+/* write back the dirty buffers for a drive, or all drives if drv < 0 */
+void bufl_flush(int drv);
+#if CONF_WITH_BDOS_CACHE
+/* write back the dirty buffers if they have been dirty for long enough */
+void bufl_timed_flush(void);
+/* write back the dirty buffers before waiting for input */
+void bufl_idle_flush(void);
+#endif
+/* invalidate the buffers for a drive, after a hard error (in bdosmain.c) */
+void mark_bcbs_invalid(int drv);
 /* return the ptr to the buffer containing the desired record */
 UBYTE *getrec(RECNO recn, OFD *of, int wrtflg);
+UBYTE *getrectyp(DMD *dm, WORD buftype, RECNO recn, int wrtflg);
 BCB *getbcb(DMD *dmd,WORD buftype,RECNO recnum);
 
 /*
@@ -422,7 +477,22 @@ void clfix(CLNO cl, CLNO link, DMD *dm);
 CLNO getrealcl(CLNO cl, DMD *dm);
 CLNO getclnum(CLNO cl, OFD *of);
 int nextcl(OFD *p, int wrtflg);
+int nextcl_run(OFD *p, int wrtflg, CLNO want);
+void cltrim(OFD *p);
 long xgetfree(long *buf, int drv);
+#if CONF_WITH_BDOS_FREEMAP
+void freemap_release(DMD *dm);
+#endif
+CLNO fcb_getcl(const FCB *fcb, DMD *dm);
+void fcb_setcl(FCB *fcb, CLNO cl, DMD *dm);
+#if CONF_WITH_FAT32
+void fsinfo_init(DMD *dm);
+void fsinfo_update(DMD *dm);
+#endif
+#if CONF_WITH_BDOS_EXTMAP
+CLNO extmap_cluster(OFD *p, CLNO index);
+void extmap_invalidate(DMD *dm);
+#endif
 
 /*
  * in fsio.c
@@ -453,6 +523,7 @@ long xchmod(char *p, int wrt, UBYTE mod);
 long ixsfirst(char *name, WORD att, DTAINFO *addr);
 long xsfirst(char *name, int att);
 long xsnext(void);
+long xsnextn(DTAINFO *buf, int count);
 long xgsdtof(DOSTIME *buf, int h, int wrt);
 void builds(const char *s1 , char *s2 );
 long xrename(int n, char *p1, char *p2);
@@ -465,6 +536,11 @@ int incr_curdir_usage(DND *dnd);
 void decr_curdir_usage(int index);
 OFD *makofd(DND *p);
 WORD free_available_dnds(void);
+#if CONF_WITH_BDOS_DIRHASH
+void dirhash_insert(DND *dn, const char *name, LONG pos);
+void dirhash_remove(DND *dn, LONG pos);
+void dirhash_forget(DND *dn);
+#endif
 
 
 /*
@@ -476,13 +552,38 @@ long xsetdrv(int drv);
 long xgetdrv(void);
 OFD  *getofd(int h);
 
+#if CONF_WITH_PGMCACHE
+/*
+ * in kpgmld.c
+ */
+void pgmcache_invalidate(DMD *dm, CLNO strtcl);
+BOOL pgmcache_flush(void);
+#endif
+
 
 /*
  * FAT chain defines
  */
 #define FREECLUSTER     0x0000
+#if CONF_WITH_FAT32
+#define ENDOFCHAIN      0xffffffffUL            /* our end-of-chain marker */
+#define endofchain(a)   (((a)&0xfffffff8UL)==0xfffffff8UL)
+#define NFREE_UNKNOWN   0xffffffffUL            /* m_nfree value if not yet counted */
+#else
 #define ENDOFCHAIN      0xffff                  /* our end-of-chain marker */
 #define endofchain(a)   (((a)&0xfff8)==0xfff8)  /* in case file was created by someone else */
+#endif
+
+/*
+ * an OFD is 'fixed' if it is the FAT, or the root directory of a FAT12
+ * or FAT16 drive: its records are contiguous, and are addressed via
+ * pseudo-cluster numbers.  the FAT32 root directory is a cluster chain.
+ */
+#if CONF_WITH_FAT32
+#define fixedofd(of)    (!(of)->o_dnode && (!(of)->o_dmd->m_32 || ((of) == (of)->o_dmd->m_fatofd)))
+#else
+#define fixedofd(of)    (!(of)->o_dnode)
+#endif
 
 
 /* Misc. defines */
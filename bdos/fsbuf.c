@@ -22,27 +22,121 @@
 #include "string.h"
 #include "tosvars.h"
 #include "biosext.h"
+#include "intmath.h"
+#include "cookie.h"
+
+#if CONF_WITH_BDOS_CACHE
+
+#define MINBUFS 8       /* min buffers per list */
+#define MAXBUFS 128     /* max buffers per list */
+
+#define NUMBUFS bc_numbufs      /* decided at boot time */
+
+static WORD bc_numbufs;         /* buffers per list */
+
+/*
+ * the hash function must be cheap on a 68000: no 32-bit multiply.
+ * consecutive records of one drive land in consecutive buckets.
+ */
+#define BC_HASH(drv,typ,rec) \
+    ((((UWORD)(rec)) ^ ((UWORD)(drv) << 4) ^ ((UWORD)(typ) << 7)) & (bc_nbuckets-1))
+
+static BCX **bc_hash;           /* hash table */
+static UWORD bc_nbuckets;       /* number of buckets, a power of 2 */
+static BCX *bc_tail[2];         /* least recently used buffer in each list */
+static UBYTE *bc_pool[2];       /* start of the buffers for each list */
+static LONG bc_stride;          /* size of BCX + sector buffer */
+static BOOL bc_linear[2];       /* TRUE if list contains foreign BCBs */
+
+static BCSTATS bcstats;
+
+/*
+ * write-back support: dirty buffers are written by bufl_flush(), sorted
+ * by sector, with runs of consecutive sectors merged into one Rwabs()
+ * via a staging buffer of BC_STAGESIZE bytes (or one sector, if larger)
+ */
+#define BC_STAGESIZE    8192L
+
+static BCB **bc_sorted;         /* scratch array for sorting dirty buffers */
+static UBYTE *bc_stage;         /* staging buffer for merged writes */
+static LONG bc_stagesize;       /* size of staging buffer in bytes */
+static BOOL bc_anydirty;        /* TRUE if a buffer may be dirty */
+static ULONG bc_dirtytime;      /* value of hz_200 when it was dirtied */
+
+#define BCBSIZE sizeof(BCX)
+
+#else
 
 #define NUMBUFS 2       /* buffers per list */
 
-/* creates a chain of BCBs and corresponding buffers */
-static void *create_chain(UBYTE *p,LONG n)
+#define BCBSIZE sizeof(BCB)
+
+#endif /* CONF_WITH_BDOS_CACHE */
+
+/*
+ * creates a chain of BCBs and corresponding buffers
+ *
+ * with CONF_WITH_BDOS_CACHE, the chain is also linked backwards.  none
+ * of the buffers is entered in the hash table, since none is valid yet.
+ */
+static void *create_chain(UBYTE *p,LONG n,int li)
 {
     BCB *bcbptr;
     WORD i;
 
+#if CONF_WITH_BDOS_CACHE
+    BCX *prev = NULL;
+
+    bc_pool[li] = p;
+    bcstats.bs_nbufs[li] = NUMBUFS;
+#endif
+
     for (i = 0; i < NUMBUFS; i++, p += n) {
         bcbptr = (BCB *)p;
-        bzero(bcbptr,sizeof(BCB));
+        bzero(bcbptr,BCBSIZE);
         if (i < NUMBUFS-1)                  /* chain to next */
             bcbptr->b_link = (BCB *)(p + n);
         bcbptr->b_bufdrv = -1;              /* mark as invalid */
-        bcbptr->b_bufr = p + sizeof(BCB);
+        bcbptr->b_bufr = p + BCBSIZE;
+#if CONF_WITH_BDOS_CACHE
+        ((BCX *)bcbptr)->x_prev = prev;
+        ((BCX *)bcbptr)->x_bucket = BC_NOBUCKET;
+        prev = (BCX *)bcbptr;
+#endif
     }
 
+#if CONF_WITH_BDOS_CACHE
+    bc_tail[li] = prev;
+#endif
+
     return p;
 }
 
+#if CONF_WITH_BDOS_CACHE
+/*
+ * get the number of buffers per list
+ *
+ * the total number of buffers is the value of the ETBC cookie, if it is
+ * in the cookie jar when the BDOS starts (so it can be chosen at boot
+ * time by machine-specific code), or else CONF_BDOS_CACHE_BUFFERS.  it
+ * is clamped to the range 2*MINBUFS to 2*MAXBUFS.
+ */
+static WORD cache_buffers(void)
+{
+    ULONG total;
+
+    if (!cookie_get(COOKIE_ETBC, &total))
+        total = CONF_BDOS_CACHE_BUFFERS;
+
+    if (total < 2*MINBUFS)
+        total = 2*MINBUFS;
+    else if (total > 2*MAXBUFS)
+        total = 2*MAXBUFS;
+
+    return total / 2;
+}
+#endif
+
 /*
  * bufl_init - BDOS buffer list initialization
  *
@@ -52,24 +146,56 @@ static void *create_chain(UBYTE *p,LONG n)
  * doesn't, and some programs that are direct-booted from a disk may
  * therefore assume that all memory from membot upwards is available
  * (I'm looking at you, Dungeon Master).
+ *
+ * with CONF_WITH_BDOS_CACHE, the hash table, the array used to sort
+ * dirty buffers and the staging buffer for merged writes are allocated
+ * in the same block, immediately after the buffers.
  */
 void bufl_init(void)
 {
     UBYTE *p;
-    LONG n;
-
-    n = sizeof(BCB) + pun_ptr->max_sect_siz;
-    p = Balloc(FALSE, 2L*NUMBUFS*n);
+    LONG n, size;
+
+#if CONF_WITH_BDOS_CACHE
+    bc_numbufs = cache_buffers();
+#endif
+
+    n = BCBSIZE + pun_ptr->max_sect_siz;
+    size = 2L*NUMBUFS*n;
+#if CONF_WITH_BDOS_CACHE
+    /* smallest power of 2 >= total number of buffers */
+    for (bc_nbuckets = 1; bc_nbuckets < 2*NUMBUFS; bc_nbuckets <<= 1)
+        ;
+    size += bc_nbuckets*sizeof(BCX *);
+    size += 2L*NUMBUFS*sizeof(BCB *);
+    bc_stagesize = max(BC_STAGESIZE, pun_ptr->max_sect_siz);
+    size += bc_stagesize;
+    bc_stride = n;
+#endif
+
+    p = Balloc(FALSE, size);
     if (!p)
-        panic("bufl_init(%ld): no memory\n",2L*NUMBUFS*n);
+        panic("bufl_init(%ld): no memory\n",size);
 
     /* set up FAT chain */
     bufl[BI_FAT] = (BCB *)p;
-    p = create_chain(p,n);
+    p = create_chain(p,n,BI_FAT);
 
     /* set up dir/data chain */
     bufl[BI_DATA] = (BCB *)p;
-    create_chain(p,n);
+    p = create_chain(p,n,BI_DATA);
+
+#if CONF_WITH_BDOS_CACHE
+    bc_hash = (BCX **)p;
+    bzero(bc_hash,bc_nbuckets*sizeof(BCX *));
+    bc_sorted = (BCB **)(bc_hash + bc_nbuckets);
+    bc_stage = (UBYTE *)(bc_sorted + 2*NUMBUFS);
+
+    etstats.es_cache = &bcstats;
+
+    KDEBUG(("bufl_init(): %d buffers per list, %u hash buckets\n",
+            NUMBUFS,bc_nbuckets));
+#endif
 }
 
 
@@ -102,16 +228,208 @@ void flush(BCB *b)
     }
     b->b_bufdrv = d;                    /* re-validate */
     b->b_dirty = 0;
+#if CONF_WITH_BDOS_CACHE
+    bcstats.bs_writes++;
+#endif
 }
 
 
 
+#if CONF_WITH_BDOS_CACHE
+
 /*
- * getbcb - called by getrec() to get the BCB for the desired record
+ * abs_rec - return the absolute record number of a buffer
+ */
+#define abs_rec(b)  ((b)->b_bufrec + (b)->b_dm->m_recoff[(b)->b_buftyp])
+
+/*
+ * write_run - write a run of buffers for consecutive records
  *
- * buftype is BT_FAT, BT_ROOT, or BT_DATA
+ * all the buffers belong to the same drive and have the same type.
+ * a single buffer is written directly; otherwise the buffers are
+ * copied to the staging buffer and written with one Rwabs() call.
+ * FAT records are written to both FATs from the same memory.
+ *
+ * NOTE: longjmp_rwabs() is a macro that includes a longjmp() which is
+ *       executed if the BIOS returns an error.  the buffers of the run
+ *       are marked invalid until the write has completed.
  */
-BCB *getbcb(DMD *dmd,WORD buftype,RECNO recnum)
+static void write_run(BCB **run, int n)
+{
+    BCB *b = run[0];
+    DMD *dm = b->b_dm;
+    int i, d = b->b_bufdrv;
+    RECNO rec = abs_rec(b);
+    UBYTE *p;
+    long buf;
+
+    if (n == 1)
+        buf = (long)b->b_bufr;
+    else
+    {
+        for (i = 0, p = bc_stage; i < n; i++, p += dm->m_recsiz)
+            memcpy(p, run[i]->b_bufr, dm->m_recsiz);
+        buf = (long)bc_stage;
+    }
+
+    for (i = 0; i < n; i++)
+        run[i]->b_bufdrv = -1;  /* invalidate in case of error */
+
+    longjmp_rwabs(1, buf, n, rec, d);
+
+    /* flush to both fats */
+    if ((b->b_buftyp == BT_FAT) && !dm->m_1fat)
+    {
+        rec -= dm->m_fsiz;
+        longjmp_rwabs(1, buf, n, rec, d);
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        run[i]->b_bufdrv = d;   /* re-validate */
+        run[i]->b_dirty = 0;
+    }
+    bcstats.bs_writes += n;
+}
+
+/*
+ * bufl_flush - write all dirty buffers for drive 'drv' (all drives if -1)
+ *
+ * the dirty buffers from both lists are sorted by drive and absolute
+ * record number, and runs of consecutive records are written together.
+ */
+void bufl_flush(int drv)
+{
+    BCB *b, *t, **run;
+    int i, j, n, li, maxrun;
+
+    for (li = BI_FAT, n = 0; li <= BI_DATA; li++)
+    {
+        for (b = bufl[li]; b; b = b->b_link)
+        {
+            if ((b->b_bufdrv == -1) || !b->b_dirty)
+                continue;
+            if ((drv >= 0) && (b->b_bufdrv != drv))
+                continue;
+            if (n >= 2*NUMBUFS)     /* only possible with foreign BCBs */
+            {
+                flush(b);
+                continue;
+            }
+
+            /* insertion sort on (drive, absolute record) */
+            for (i = n++; i > 0; i--)
+            {
+                t = bc_sorted[i-1];
+                if ((t->b_bufdrv < b->b_bufdrv)
+                 || ((t->b_bufdrv == b->b_bufdrv) && (abs_rec(t) < abs_rec(b))))
+                    break;
+                bc_sorted[i] = t;
+            }
+            bc_sorted[i] = b;
+        }
+    }
+
+    for (i = 0; i < n; i += j)
+    {
+        run = &bc_sorted[i];
+        maxrun = bc_stagesize / run[0]->b_dm->m_recsiz;
+        for (j = 1; (i+j < n) && (j < maxrun); j++)
+        {
+            b = run[j];
+            if ((b->b_bufdrv != run[0]->b_bufdrv)
+             || (b->b_buftyp != run[0]->b_buftyp)
+             || (abs_rec(b) != abs_rec(run[0]) + j))
+                break;
+        }
+        write_run(run, j);
+    }
+
+    if (drv < 0)
+        bc_anydirty = FALSE;
+}
+
+/*
+ * bufl_timed_flush - write back the dirty buffers if they are old enough
+ *
+ * this is called by the GEMDOS dispatcher for file system functions, so
+ * that dirty FAT & directory records do not stay in memory indefinitely
+ * when no file is closed.
+ */
+void bufl_timed_flush(void)
+{
+    if (bc_anydirty && ((hz_200 - bc_dirtytime) >= CONF_BDOS_FLUSH_DELAY))
+        bufl_flush(-1);
+}
+
+/*
+ * bufl_idle_flush - write back the dirty buffers while waiting for input
+ *
+ * this is called by the console input functions before they wait for a
+ * key, so that the records dirtied by the last file system calls reach
+ * the disk while the machine is idle, rather than at the next one.
+ *
+ * since we are inside a call which has nothing to do with the file
+ * system, a write error must not become its return value: once the
+ * critical error handler has been called, the buffers of the drive are
+ * invalidated, as the dispatcher would do.  a media change is still
+ * passed on to the dispatcher, which logs the new media and restarts
+ * the call.
+ */
+void bufl_idle_flush(void)
+{
+    jmp_buf outer;
+
+    if (!bc_anydirty)
+        return;
+
+    memcpy(outer, errbuf, sizeof(jmp_buf));
+    if (setjmp(errbuf))
+    {
+        memcpy(errbuf, outer, sizeof(jmp_buf));
+        if (errcode == E_CHNG)
+            longjmp(errbuf, 1);
+        mark_bcbs_invalid(errdrv);
+        return;
+    }
+
+    bufl_flush(-1);
+    memcpy(errbuf, outer, sizeof(jmp_buf));
+}
+
+#else
+
+/*
+ * bufl_flush - write all dirty buffers for drive 'drv' (all drives if -1)
+ *
+ * this could in theory be improved by flushing all sectors for one
+ * drive before moving on to the next, reducing arm movement on
+ * partitioned hard disks.  however this would cost code space and,
+ * in practice, flushing usually takes place to one drive only.
+ */
+void bufl_flush(int drv)
+{
+    BCB *b;
+    int i;
+
+    for (i = BI_FAT; i <= BI_DATA; i++)
+        for (b = bufl[i]; b; b = b->b_link)
+            if ((b->b_bufdrv != -1) && b->b_dirty)
+                if ((drv < 0) || (b->b_bufdrv == drv))
+                    flush(b);
+}
+
+#endif /* CONF_WITH_BDOS_CACHE */
+
+
+
+/*
+ * getbcb_linear - get the BCB for the desired record by walking the list
+ *
+ * this is the original TOS algorithm.  with CONF_WITH_BDOS_CACHE, it is
+ * only used for a list to which a program has added its own BCBs.
+ */
+static BCB *getbcb_linear(DMD *dmd,WORD buftype,RECNO recnum)
 {
     BCB *b;
     BCB *p, *mtbuf, **q, **phdr;
@@ -203,13 +521,190 @@ doio:   for (p = *(q = phdr); p->b_link; p = *(q = &p->b_link))
 
 
 
+#if CONF_WITH_BDOS_CACHE
+
+/*
+ * bc_unhash - remove a buffer from the hash table
+ */
+static void bc_unhash(BCX *x)
+{
+    BCX **q;
+
+    if (x->x_bucket == BC_NOBUCKET)
+        return;
+
+    for (q = &bc_hash[x->x_bucket]; *q; q = &(*q)->x_hnext)
+    {
+        if (*q == x)
+        {
+            *q = x->x_hnext;
+            break;
+        }
+    }
+    x->x_bucket = BC_NOBUCKET;
+}
+
+/*
+ * bc_touch - make a buffer the most recently used one in its list
+ */
+static void bc_touch(BCX *x, int li)
+{
+    BCX *head = (BCX *)bufl[li];
+
+    if (x == head)
+        return;
+
+    /* unlink from current position (x cannot be the head) */
+    x->x_prev->x_bcb.b_link = x->x_bcb.b_link;
+    if (x->x_bcb.b_link)
+        ((BCX *)x->x_bcb.b_link)->x_prev = x->x_prev;
+    else
+        bc_tail[li] = x->x_prev;
+
+    /* insert at head */
+    x->x_prev = NULL;
+    x->x_bcb.b_link = &head->x_bcb;
+    head->x_prev = x;
+    bufl[li] = &x->x_bcb;
+}
+
+/*
+ * bc_is_own - return TRUE iff list 'li' only contains our own buffers
+ *
+ * programs such as CACHEnnn.PRG may add their own BCBs to the bufl[]
+ * chains, normally at the head.  those BCBs have no private fields, so
+ * when we detect them we stop using the hash table for that list, and
+ * fall back to the original linear algorithm.
+ */
+static BOOL bc_is_own(int li)
+{
+    UBYTE *head;
+    BCX *x;
+
+    if (bc_linear[li])
+        return FALSE;
+
+    head = (UBYTE *)bufl[li];
+    if ((head >= bc_pool[li]) && (head < bc_pool[li]+NUMBUFS*bc_stride)
+     && (bc_tail[li]->x_bcb.b_link == NULL))
+        return TRUE;
+
+    KDEBUG(("getbcb(): foreign BCBs in list %d, hashing disabled\n",li));
+    bc_linear[li] = TRUE;
+    for (head = bc_pool[li]; head < bc_pool[li]+NUMBUFS*bc_stride; head += bc_stride)
+    {
+        x = (BCX *)head;
+        bc_unhash(x);
+    }
+
+    return FALSE;
+}
+
+/*
+ * getbcb_hashed - get the BCB for the desired record via the hash table
+ *
+ * the semantics are the same as for getbcb_linear(), but both the
+ * lookup and the LRU update are constant time.
+ */
+static BCB *getbcb_hashed(DMD *dmd,WORD buftype,RECNO recnum,int li)
+{
+    BCX *x;
+    BCB *b;
+    WORD drv = dmd->m_drvnum;
+    UWORD h = BC_HASH(drv,buftype,recnum);
+    int err;
+
+    for (x = bc_hash[h]; x; x = x->x_hnext)
+    {
+        b = &x->x_bcb;
+        if ((b->b_bufrec == recnum) && (b->b_bufdrv == drv) && (b->b_buftyp == buftype))
+            break;
+    }
+
+    if (x)
+    {   /* use the buffer, but first validate media */
+        err = Mediach(drv);
+        if (err == 0)
+        {
+            bcstats.bs_hits++;
+            bc_touch(x,li);
+            return &x->x_bcb;
+        }
+        if (err == 2)
+        {   /* media definitely changed */
+            errdrv = drv;
+            rwerr = E_CHNG; /* media change */
+            errcode = rwerr;
+            longjmp(errbuf,1);
+        }
+        /* media may be changed: re-read into the same buffer */
+    }
+    else
+    {
+        /* not in memory: use the least recently used buffer */
+        x = bc_tail[li];
+    }
+
+    bcstats.bs_misses++;
+    b = &x->x_bcb;
+
+    /*
+     * if the buffer is dirty, write back all the dirty buffers for its
+     * drive in one batch, then read in the new record
+     */
+    if ((b->b_bufdrv != -1) && b->b_dirty)
+        bufl_flush(b->b_bufdrv);
+    bc_unhash(x);
+    b->b_bufdrv = -1;       /* in case longjmp_rwabs() fails */
+    longjmp_rwabs(0, (long)b->b_bufr, 1, recnum+dmd->m_recoff[buftype], drv);
+
+    /*
+     * make the new buffer current
+     */
+    b->b_bufrec = recnum;
+    b->b_dirty = 0;
+    b->b_buftyp = buftype;
+    b->b_bufdrv = drv;
+    b->b_dm = dmd;
+
+    x->x_bucket = h;
+    x->x_hnext = bc_hash[h];
+    bc_hash[h] = x;
+
+    bc_touch(x,li);
+
+    return b;
+}
+
+#endif /* CONF_WITH_BDOS_CACHE */
+
+
+
+/*
+ * getbcb - called by getrec() to get the BCB for the desired record
+ *
+ * buftype is BT_FAT, BT_ROOT, or BT_DATA
+ */
+BCB *getbcb(DMD *dmd,WORD buftype,RECNO recnum)
+{
+#if CONF_WITH_BDOS_CACHE
+    int li = (buftype==BT_FAT) ? BI_FAT : BI_DATA;
+
+    if (bc_is_own(li))
+        return getbcb_hashed(dmd,buftype,recnum,li);
+#endif
+
+    return getbcb_linear(dmd,buftype,recnum);
+}
+
+
+
 /*
  * getrec - return the ptr to the buffer containing the desired record
  */
 UBYTE *getrec(RECNO recn, OFD *of, int wrtflg)
 {
     DMD *dm = of->o_dmd;
-    BCB *b;
     int n;
 
     KDEBUG(("getrec 0x%lx, %p, 0x%x\n",recn,dm,wrtflg));
@@ -217,19 +712,40 @@ UBYTE *getrec(RECNO recn, OFD *of, int wrtflg)
     /* put bcb management here */
     if (of->o_dmd->m_fatofd == of)  /* is this the OFD for the 'FAT file'? */
         n = BT_FAT;                 /* yes, must be FAT access             */
-    else if (!of->o_dnode)          /* no - do we have a dir node?         */
-        n = BT_ROOT;                /* no, must be root                    */
-    else n = BT_DATA;               /* yes, must be normal dir/file        */
+    else if (fixedofd(of))          /* no - is it a fixed root directory?  */
+        n = BT_ROOT;                /* yes, must be root                   */
+    else n = BT_DATA;               /* no, must be normal dir/file         */
+
+    return getrectyp(dm,n,recn,wrtflg);
+}
+
+
+/*
+ * getrectyp - return the ptr to the buffer containing the desired record
+ * of the specified type
+ */
+UBYTE *getrectyp(DMD *dm, WORD buftype, RECNO recn, int wrtflg)
+{
+    BCB *b;
 
-    KDEBUG(("n=%i, dm->m_recoff[n]=0x%lx\n",n,dm->m_recoff[n]));
+    KDEBUG(("n=%i, dm->m_recoff[n]=0x%lx\n",buftype,dm->m_recoff[buftype]));
 
-    b = getbcb(dm,n,recn);          /* get BCB for buffer */
+    b = getbcb(dm,buftype,recn);    /* get BCB for buffer */
 
     /*
      * if we are writing to the buffer, dirty it
      */
     if (wrtflg)
+    {
         b->b_dirty = 1;
+#if CONF_WITH_BDOS_CACHE
+        if (!bc_anydirty)
+        {
+            bc_anydirty = TRUE;
+            bc_dirtytime = hz_200;
+        }
+#endif
+    }
 
     return b->b_bufr;
 }
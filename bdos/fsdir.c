@@ -136,7 +136,6 @@
 
 #define ROOT_PSEUDO_CLUSTER 1   /* see comments in xrename() */
 
-#define DIR_FILE_LENGTH 0x7fffffffL     /* fake size for directories */
 
 /*
  * forward prototypes
@@ -172,6 +171,298 @@ static const char dots[22] = ".          ";
 static LONG freed_dnds, freed_ofds; /* count of DNDs & OFDs made available */
 
 
+#if CONF_WITH_BDOS_DIRHASH
+
+#define DIRHASH_SLOTS   64      /* initial slots per folder (a power of 2) */
+#define DIRHASH_MAXSLOTS 4096   /* largest table (a power of 2) */
+#define DIRHASH_MAXUSED(n) ((n)-(n)/4)  /* keep some slots empty to end probes */
+#define DH_EMPTY        0xffff  /* h_index of a never-used slot */
+#define DH_DELETED      0xfffe  /* h_index of a slot whose entry was deleted */
+
+/*
+ * a directory hash maps the name of each entry in the folder described
+ * by DND h_dnd to the entry's position (in units of FCBs).  it is filled
+ * as the folder is scanned from the start, and kept up to date by
+ * ixcreat(), ixdel() and xrename().  if h_complete is set, every entry
+ * in the folder is in the table, so a name that is not found there does
+ * not exist.  a hit is always checked against the actual entry, so a
+ * stale slot can only cost a disk read, never a wrong result.
+ *
+ * the slots start out in h_small[]; when that fills up, the table is
+ * doubled in size (up to DIRHASH_MAXSLOTS) in memory from xmalloc_os(),
+ * which is released when the table is reused for another folder.
+ */
+typedef struct
+{
+    UWORD h_key;                /* hash of the (upper-case) packed name */
+    UWORD h_index;              /* position of entry, or DH_EMPTY/DH_DELETED */
+} DHSLOT;
+
+typedef struct
+{
+    DND    *h_dnd;              /* folder, or NULL if table is unused */
+    UWORD  h_age;               /* for LRU replacement */
+    UWORD  h_used;              /* number of slots not DH_EMPTY */
+    BOOL   h_complete;          /* all entries in the folder are present */
+    BOOL   h_full;              /* some entries did not fit */
+    UWORD  h_size;              /* number of slots (a power of 2) */
+    DHSLOT *h_slot;             /* h_small[], or a larger table */
+    DHSLOT h_small[DIRHASH_SLOTS];
+} DIRHASH;
+
+static DIRHASH dirhash[CONF_BDOS_DIRHASH_DIRS];
+static UWORD dirhash_clock;
+
+/*
+ * dirhash_key - hash a packed (11-character) name, ignoring case
+ */
+static UWORD dirhash_key(const char *name)
+{
+    UWORD key = 0;
+    int i;
+
+    for (i = 0; i < FNAMELEN; i++)
+        key = key * 31 + toupper((UBYTE)name[i]);
+
+    return key;
+}
+
+/*
+ * dirhash_find - find the table for a folder, or NULL if there is none
+ */
+static DIRHASH *dirhash_find(DND *dn)
+{
+    DIRHASH *dh;
+
+    for (dh = dirhash; dh < dirhash+CONF_BDOS_DIRHASH_DIRS; dh++)
+    {
+        if (dh->h_dnd == dn)
+        {
+            dh->h_age = ++dirhash_clock;
+            return dh;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * dirhash_get - find the table for a folder, or reuse the least recently
+ * used one
+ */
+static DIRHASH *dirhash_get(DND *dn)
+{
+    DIRHASH *dh, *victim;
+    int i;
+
+    if ((dh = dirhash_find(dn)))
+        return dh;
+
+    victim = dirhash;
+    for (dh = dirhash; dh < dirhash+CONF_BDOS_DIRHASH_DIRS; dh++)
+    {
+        if (!dh->h_dnd)
+        {
+            victim = dh;
+            break;
+        }
+        if ((UWORD)(dirhash_clock - dh->h_age) > (UWORD)(dirhash_clock - victim->h_age))
+            victim = dh;
+    }
+
+    dh = victim;
+    if (dh->h_size > DIRHASH_SLOTS)
+        xmfree(dh->h_slot);
+    dh->h_slot = dh->h_small;
+    dh->h_size = DIRHASH_SLOTS;
+    dh->h_dnd = dn;
+    dh->h_age = ++dirhash_clock;
+    dh->h_used = 0;
+    dh->h_complete = FALSE;
+    dh->h_full = FALSE;
+    for (i = 0; i < DIRHASH_SLOTS; i++)
+        dh->h_slot[i].h_index = DH_EMPTY;
+
+    return dh;
+}
+
+/*
+ * dirhash_grow - double the number of slots in a table
+ *
+ * returns FALSE if the table is already as large as allowed, or if
+ * there is not enough memory
+ */
+static BOOL dirhash_grow(DIRHASH *dh)
+{
+    DHSLOT *old, *new, *s;
+    UWORD oldsize, size, i, j;
+
+    oldsize = dh->h_size;
+    if (oldsize >= DIRHASH_MAXSLOTS)
+        return FALSE;
+
+    size = oldsize * 2;
+    new = xmalloc_os((LONG)size*sizeof(DHSLOT));
+    if (!new)
+        return FALSE;
+    for (i = 0; i < size; i++)
+        new[i].h_index = DH_EMPTY;
+
+    /* rehash the live entries, dropping the deleted ones */
+    old = dh->h_slot;
+    dh->h_used = 0;
+    for (i = 0; i < oldsize; i++)
+    {
+        if (old[i].h_index >= DH_DELETED)
+            continue;
+        for (j = old[i].h_key; ; j++)
+        {
+            s = &new[j&(size-1)];
+            if (s->h_index == DH_EMPTY)
+                break;
+        }
+        *s = old[i];
+        dh->h_used++;
+    }
+
+    if (oldsize > DIRHASH_SLOTS)
+        xmfree(old);
+    dh->h_slot = new;
+    dh->h_size = size;
+
+    KDEBUG(("dirhash_grow(): %u slots for DND %p\n",size,dh->h_dnd));
+
+    return TRUE;
+}
+
+/*
+ * dirhash_add - record that the entry at byte offset 'pos' is called 'name'
+ */
+static void dirhash_add(DIRHASH *dh, const char *name, LONG pos)
+{
+    DHSLOT *s, *avail;
+    UWORD key, index, i;
+
+    if (pos / sizeof(FCB) >= DH_DELETED)    /* can't be recorded */
+    {
+        dh->h_full = TRUE;
+        dh->h_complete = FALSE;
+        return;
+    }
+    index = pos / sizeof(FCB);
+    key = dirhash_key(name);
+
+    avail = NULL;
+    for (i = key; ; i++)
+    {
+        s = &dh->h_slot[i&(dh->h_size-1)];
+        if (s->h_index == DH_EMPTY)
+            break;
+        if (s->h_index == index)            /* already present */
+        {
+            s->h_key = key;
+            return;
+        }
+        if ((s->h_index == DH_DELETED) && !avail)
+            avail = s;
+    }
+
+    if (!avail)
+    {
+        if (dh->h_used >= DIRHASH_MAXUSED(dh->h_size))
+        {
+            if (dirhash_grow(dh))
+                dirhash_add(dh,name,pos);   /* probe the larger table */
+            else
+            {
+                dh->h_full = TRUE;
+                dh->h_complete = FALSE;
+            }
+            return;
+        }
+        dh->h_used++;
+        avail = s;
+    }
+    avail->h_key = key;
+    avail->h_index = index;
+}
+
+/*
+ * dirhash_lookup - look up an exact name (in scan() format, i.e. with
+ * the attribute byte appended)
+ *
+ * returns a pointer to the matching FCB, leaving the directory positioned
+ * after it, or NULL if the table has no matching entry
+ */
+static FCB *dirhash_lookup(DIRHASH *dh, OFD *fd, char *name)
+{
+    DHSLOT *s;
+    FCB *fcb;
+    UWORD key, i;
+
+    key = dirhash_key(name);
+
+    for (i = key; ; i++)
+    {
+        s = &dh->h_slot[i&(dh->h_size-1)];
+        if (s->h_index == DH_EMPTY)
+            break;
+        if ((s->h_index == DH_DELETED) || (s->h_key != key))
+            continue;
+        ixlseek(fd,(LONG)s->h_index*sizeof(FCB));
+        fcb = ixgetfcb(fd);
+        if (fcb && match(name,fcb->f_name))
+            return fcb;
+    }
+
+    return NULL;
+}
+
+/*
+ * dirhash_insert - note a new entry created at byte offset 'pos'
+ */
+void dirhash_insert(DND *dn, const char *name, LONG pos)
+{
+    DIRHASH *dh;
+
+    if ((dh = dirhash_find(dn)))
+        dirhash_add(dh,name,pos);
+}
+
+/*
+ * dirhash_remove - note that the entry at byte offset 'pos' was deleted
+ */
+void dirhash_remove(DND *dn, LONG pos)
+{
+    DIRHASH *dh;
+    UWORD index;
+    int i;
+
+    if (!(dh = dirhash_find(dn)))
+        return;
+
+    if (pos / sizeof(FCB) >= DH_DELETED)
+        return;
+    index = pos / sizeof(FCB);
+    for (i = 0; i < dh->h_size; i++)
+        if (dh->h_slot[i].h_index == index)
+            dh->h_slot[i].h_index = DH_DELETED;
+}
+
+/*
+ * dirhash_forget - discard the table for a DND that is being freed or reused
+ */
+void dirhash_forget(DND *dn)
+{
+    DIRHASH *dh;
+
+    for (dh = dirhash; dh < dirhash+CONF_BDOS_DIRHASH_DIRS; dh++)
+        if (dh->h_dnd == dn)
+            dh->h_dnd = NULL;
+}
+#endif /* CONF_WITH_BDOS_DIRHASH */
+
+
 /*
  *  namlen - parameter points to a character string of FNAMELEN bytes max
  */
@@ -205,7 +496,7 @@ long xmkdir(char *s)
     DFD *dfd;
     FCB *fcb1,*fcb2;
     DND *dn;
-    int h,cl,plen;
+    int h,plen;
     long rc;
 
     if ((h = rc = ixcreat(s,FA_SUBDIR)) < 0)
@@ -249,9 +540,7 @@ long xmkdir(char *s)
     fcb2->f_attrib = FA_SUBDIR;
     dfd = f0->o_dfd;
     fcb2->f_td = dfd->o_td;         /* time/date are little-endian */
-    cl = dfd->o_strtcl;
-    swpw(cl);
-    fcb2->f_clust = cl;
+    fcb_setcl(fcb2,dfd->o_strtcl,f0->o_dmd);
     fcb2->f_fileln = 0;
     fcb2++;
 
@@ -270,8 +559,7 @@ long xmkdir(char *s)
     {
         dfd = f->o_dirfil->o_dfd;
         fcb2->f_td = dfd->o_td;     /* time/date are little-endian */
-        fcb2->f_clust = dfd->o_strtcl;
-        swpw(fcb2->f_clust);
+        fcb_setcl(fcb2,dfd->o_strtcl,f0->o_dmd);
     }
     fcb2->f_fileln = 0;
     memcpy(f, f0, sizeof(OFD));
@@ -366,6 +654,9 @@ long xrmdir(char *p)
         xmfreblk(d->d_ofd);
 
     d1 = d->d_parent;
+#if CONF_WITH_BDOS_DIRHASH
+    dirhash_forget(d);
+#endif
     xmfreblk(d);
 
     /*
@@ -474,7 +765,7 @@ long ixsfirst(char *name, WORD att, DTAINFO *addr)
     {
         OFD *ofd = dn->d_ofd;
         memcpy(addr->dt_name, s, FNAMELEN+1);   /* filename + attr */
-        if (!ofd->o_dnode)              /* i.e. root directory */
+        if (fixedofd(ofd))              /* i.e. FAT12/16 root directory */
         {
             addr->dt_offset_drive = pos;
             addr->dt_cloffset = 0;
@@ -482,9 +773,9 @@ long ixsfirst(char *name, WORD att, DTAINFO *addr)
         }
         else
         {
-            addr->dt_offset_drive = 0L;
+            addr->dt_offset_drive = (LONG)HIWORD(ofd->o_curcl) << 5;
             addr->dt_cloffset = ofd->o_curbyt;
-            addr->dt_clnum = ofd->o_curcl;
+            addr->dt_clnum = LOWORD(ofd->o_curcl);
         }
         addr->dt_offset_drive |= dn->d_drv->m_drvnum & DTA_DRIVEMASK;
         addr->dt_attr = att;
@@ -551,7 +842,7 @@ static FCB *ixsnext(DTAINFO *dt)
     FCB *fcb;
     LONG offset, recnum;
     WORD drive, buftype, rootdirlen, found;
-    CLNO cluster = 0;
+    CLNO cluster;
 
     drive = dt->dt_offset_drive & DTA_DRIVEMASK;
     if (drive >= BLKDEVNUM)
@@ -565,7 +856,12 @@ static FCB *ixsnext(DTAINFO *dt)
     /*
      * determine starting point
      */
-    if ((dt->dt_cloffset == 0) && (dt->dt_clnum == 0))
+    cluster = dt->dt_clnum;
+#if CONF_WITH_FAT32
+    if (dmd->m_32)
+        cluster |= (CLNO)(((ULONG)dt->dt_offset_drive >> 5) & 0xffffUL) << 16;
+#endif
+    if ((dt->dt_cloffset == 0) && (cluster == 0))
     {
         buftype = BT_ROOT;
         offset = dt->dt_offset_drive & ~DTA_DRIVEMASK;
@@ -577,7 +873,6 @@ static FCB *ixsnext(DTAINFO *dt)
     {
         buftype = BT_DATA;
         offset = dt->dt_cloffset;       /* within cluster */
-        cluster = dt->dt_clnum;
         recnum = cl2rec(cluster,dmd) + (offset >> dmd->m_rblog);
         offset &= dmd->m_rbm;           /* within record */
     }
@@ -637,7 +932,8 @@ static FCB *ixsnext(DTAINFO *dt)
     else
     {
         dt->dt_cloffset = ((recnum&dmd->m_clrm) << dmd->m_rblog) + offset;
-        dt->dt_clnum = cluster;
+        dt->dt_clnum = LOWORD(cluster);
+        dt->dt_offset_drive = ((LONG)HIWORD(cluster) << 5) | dmd->m_drvnum;
     }
 
     return fcb;
@@ -676,6 +972,51 @@ long xsnext(void)
 }
 
 
+/*
+ *  xsnextn - search next, returning several entries at once
+ *
+ *  Function 0x50   Fsnextn (EmuTOS extension)
+ *
+ *  This is equivalent to calling Fsnext() up to 'count' times, copying
+ *  the DTA to buf[0], buf[1], ... after each successful call.  The DTA
+ *  is left as after the last call, so the search may be continued with
+ *  Fsnext() or Fsnextn().  Since everything is done in one call, each
+ *  directory record is normally read from the buffer cache just once.
+ *
+ *  Returns:        number of entries returned (1 to 'count')
+ *  Error returns:  ENMFIL, ERANGE
+ */
+long xsnextn(DTAINFO *buf, int count)
+{
+    FCB *fcb;
+    DTAINFO *dt;
+    int n;
+
+    if (count <= 0)
+        return ERANGE;
+
+    dt = (DTAINFO *)run->p_xdta;
+
+    /* has the DTA been initialized? */
+    if (dt->dt_offset_drive < 0L)
+        return ENMFIL;
+
+    for (n = 0; n < count; n++, buf++)
+    {
+        fcb = ixsnext(dt);
+        if (fcb == NULL)                    /* end of directory */
+        {
+            dt->dt_offset_drive = -1L;
+            break;
+        }
+        makbuf(fcb,dt);
+        memcpy(buf,dt,sizeof(DTAINFO));
+    }
+
+    return n ? n : ENMFIL;
+}
+
+
 /*
  *  xgsdtof - get/set date/time of file into or from buffer
  *
@@ -900,6 +1241,7 @@ long xrename(int n, char *p1, char *p2)
     DND *dn1, *dn2;
     DMD *dmd1, *dmd2;
     CLNO strtcl1, strtcl2, temp;
+    UWORD cl16;
     const char *s1, *s2;
     char buf[FNAMELEN];
     UBYTE att;
@@ -957,8 +1299,7 @@ long xrename(int n, char *p1, char *p2)
     swpw(filetime);             /* convert from little-endian format */
     filedate = fcb->f_td.date;
     swpw(filedate);
-    clust = fcb->f_clust;
-    swpw(clust);
+    clust = fcb_getcl(fcb,dn1->d_drv);
     fileln = fcb->f_fileln;
     swpl(fileln);
 
@@ -1025,6 +1366,9 @@ long xrename(int n, char *p1, char *p2)
             KDEBUG(("xrename(): can't erase old entry\n"));
             return EACCDN;
         }
+#if CONF_WITH_BDOS_DIRHASH
+        dirhash_remove(dn1,posp);
+#endif
 
         /* copy the time/date/cluster/length to the OFD */
         dfd = fd2->o_dfd;
@@ -1049,12 +1393,22 @@ long xrename(int n, char *p1, char *p2)
             if (!fd2->o_dnode->d_name[0])   /* empty name means root */
                 temp = 0;
             else temp = fdparent->o_dfd->o_strtcl;  /* else real start cluster */
-            swpw(temp);                     /* convert to disk format */
-            if (update_fcb(fd2,sizeof(FCB)+26,2L,(UBYTE *)&temp) < 0)
+            cl16 = LOWORD(temp);
+            swpw(cl16);                     /* convert to disk format */
+            if (update_fcb(fd2,sizeof(FCB)+26,2L,(UBYTE *)&cl16) < 0)
             {
                 KDEBUG(("xrename(): can't update .. entry\n"));
                 return EINTRN;
             }
+#if CONF_WITH_FAT32
+            cl16 = HIWORD(temp);            /* FAT32: high word too */
+            swpw(cl16);
+            if (dmd2->m_32 && (update_fcb(fd2,sizeof(FCB)+12+FCB_CLUSTHI,2L,(UBYTE *)&cl16) < 0))
+            {
+                KDEBUG(("xrename(): can't update .. entry\n"));
+                return EINTRN;
+            }
+#endif
 
             /* set attribute for this file in parent directory */
             if (update_fcb(fdparent,fd2->o_dirbyt+FNAMELEN,1L,&att) < 0)
@@ -1080,6 +1434,10 @@ long xrename(int n, char *p1, char *p2)
             KDEBUG(("xrename(): can't update FCB with new name\n"));
             return EACCDN;
         }
+#if CONF_WITH_BDOS_DIRHASH
+        dirhash_remove(dn1,posp);
+        dirhash_insert(dn1,buf,posp);
+#endif
     }
 
     /*
@@ -1529,6 +1887,10 @@ FCB *scan(DND *dnd, const char *n, WORD att, LONG *posp)
     OFD *fd;
     DND *dnd1;
     BOOL m;                 /*  T: found a matching FCB             */
+#if CONF_WITH_BDOS_DIRHASH
+    DIRHASH *dh;
+    int i;
+#endif
 
     KDEBUG(("scan(%p,'%s',0x%x,%p)\n",dnd,n,att,posp));
 
@@ -1551,11 +1913,56 @@ FCB *scan(DND *dnd, const char *n, WORD att, LONG *posp)
      */
     ixlseek(fd, (*posp == -1) ? 0L : *posp);
 
+#if CONF_WITH_BDOS_DIRHASH
+    /*
+     *  if we are starting at the beginning, try the folder's hash table
+     *  for an exact name; otherwise, fill the table as we scan
+     */
+    dh = NULL;
+    fcb = NULL;
+    if ((*posp == -1) || (*posp == 0))
+    {
+        for (i = 0; i < FNAMELEN; i++)
+            if (name[i] == '?')
+                break;
+        if ((i == FNAMELEN) && (name[0] != ERASE_MARKER) && (dh = dirhash_find(dnd)))
+        {
+            fcb = dirhash_lookup(dh, fd, name);
+            if (!fcb && dh->h_complete)
+            {
+                KDEBUG(("\n   scan(): '%s' not in complete hash\n",name));
+                return (FCB *)NULL;
+            }
+        }
+        if (!fcb)
+        {
+            dh = dirhash_get(dnd);
+            ixlseek(fd, 0L);
+        }
+    }
+
+    if (fcb)        /* found via the hash table */
+    {
+        if ((fcb->f_attrib & FA_SUBDIR) && (fcb->f_name[0] != '.'))
+        {
+            dnd1 = getdnd(&fcb->f_name[0], dnd);
+            if (!dnd1)
+                dnd1 = makdnd(dnd,fcb);
+        }
+        m = 1;
+    }
+    else
+#endif
     /*
      *  scan thru the directory file, looking for a match
      */
     while ((fcb = ixgetfcb(fd)) && (fcb->f_name[0]))
     {
+#if CONF_WITH_BDOS_DIRHASH
+        if (dh && (fcb->f_name[0] != ERASE_MARKER) && (fcb->f_attrib != FA_LFN))
+            dirhash_add(dh, fcb->f_name, fd->o_bytnum - sizeof(FCB));
+#endif
+
         /*
          *  Add New DND.
          *  ( iff after scan ptr && not a .
@@ -1574,6 +1981,12 @@ FCB *scan(DND *dnd, const char *n, WORD att, LONG *posp)
              break;
     }
 
+#if CONF_WITH_BDOS_DIRHASH
+    /* if we have seen every entry, a later miss can be trusted */
+    if (dh && !m && (!fcb || !fcb->f_name[0]))
+        dh->h_complete = !dh->h_full;
+#endif
+
     KDEBUG(("\n   scan(pos=%ld DND=%p DNDfoundFile=%p name=%s name=%s, %d)",
             (long)fd->o_bytnum,dnd,dnd1,fcb?fcb->f_name:"(null)",name,m));
 
@@ -1645,6 +2058,9 @@ static DND *makdnd(DND *p, FCB *fcb)
                 p1->d_files = (OFD *) 0;
                 if (p1->d_ofd)
                     xmfreblk(p1->d_ofd);
+#if CONF_WITH_BDOS_DIRHASH
+                dirhash_forget(p1);
+#endif
                 break;
             }
         }
@@ -1667,8 +2083,7 @@ static DND *makdnd(DND *p, FCB *fcb)
     /* complete the initialization */
 
     p1->d_ofd = (OFD *) 0;
-    p1->d_strtcl = fcb->f_clust;
-    swpw(p1->d_strtcl);
+    p1->d_strtcl = fcb_getcl(fcb,p->d_drv);
     p1->d_drv = p->d_drv;
     p1->d_dirfil = fd;
     p1->d_dirpos = fd->o_bytnum - sizeof(FCB);
@@ -1907,6 +2322,9 @@ static void freednd(DND *dn)                    /* M01.01.1031.02 */
     while (dn->d_left) {            /* is this step really necessary? */
         freednd(dn->d_left);
     }
+#if CONF_WITH_BDOS_DIRHASH
+    dirhash_forget(dn);
+#endif
     xmfreblk(dn);                   /* finally free this DND */
 }
 
@@ -2038,6 +2456,9 @@ static void process_dnd_tree(DND *dndstart)
             xmfreblk(dnd->d_ofd);
             freed_ofds++;
         }
+#if CONF_WITH_BDOS_DIRHASH
+        dirhash_forget(dnd);
+#endif
         xmfreblk(dnd);
         freed_dnds++;
     }
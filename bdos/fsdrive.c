@@ -187,12 +187,33 @@ WORD log_media(BPB *b, int drv)
     DFD *dfd;
     DND *d;
     DMD *dm;
-    unsigned long rsiz, cs, n, fs;
+    unsigned long rsiz, cs, n, fs, numcl, fatrec, datrec;
+#if CONF_WITH_FAT32
+    const BPB32 *b32 = (b->b_flags & B_32) ? (const BPB32 *)(b+1) : NULL;
+#endif
 
     rsiz = b->recsiz;
     cs = b->clsiz;
     n = b->rdlen;
     fs = b->fsiz;
+    numcl = b->numcl;
+    fatrec = b->fatrec;
+    datrec = b->datrec;
+
+#if CONF_WITH_FAT32
+    /*
+     * for FAT32, the 16-bit fields of the BPB are zero, and the real
+     * values are in the extension that follows it
+     */
+    if (b32)
+    {
+        n = 0;
+        fs = b32->l_fsiz;
+        numcl = b32->l_numcl;
+        fatrec = b32->l_fatrec;
+        datrec = b32->l_datrec;
+    }
+#endif
 
     KDEBUG(("log_media(%p,%i) rsiz=0x%lx, cs=0x%lx, n=0x%lx, fs=0x%lx\n",
             b,drv,rsiz,cs,n,fs));
@@ -220,7 +241,7 @@ WORD log_media(BPB *b, int drv)
     dm->m_clsiz = cs;                   /*  set cluster size in sectors */
     dm->m_clsizb = b->clsizb;           /*    and in bytes              */
     dm->m_recsiz = rsiz;                /*  set record (sector) size    */
-    dm->m_numcl = b->numcl;             /*  set cluster size in records */
+    dm->m_numcl = numcl;                /*  set number of clusters      */
     dm->m_clrlog = log2ul(cs);          /*    and log of it             */
     dm->m_clrm = (1L<<dm->m_clrlog)-1;  /*      and mask of it          */
     dm->m_rblog = log2ul(rsiz);         /*  set log of bytes/record     */
@@ -231,6 +252,14 @@ WORD log_media(BPB *b, int drv)
     f->o_dfd = dfd = &f->o_disk;
     dfd->o_fileln = n * rsiz;           /*  size of file (root dir)     */
     d->d_strtcl = dfd->o_strtcl = 2;    /*  root start pseudo-cluster   */
+#if CONF_WITH_FAT32
+    if (b32)
+    {
+        dm->m_32 = 1;                   /*  32 bit fat                  */
+        dfd->o_fileln = DIR_FILE_LENGTH;/*  root dir is a cluster chain */
+        d->d_strtcl = dfd->o_strtcl = b32->l_rootcl;
+    }
+#endif
 
     fo = dm->m_fatofd;                  /*  OFD for 'fat file'          */
     fo->o_dmd = dm;                     /*  link with DMD               */
@@ -238,12 +267,24 @@ WORD log_media(BPB *b, int drv)
     dfd->o_fileln = fs * rsiz;          /*  FAT size                    */
     dfd->o_strtcl = 2;                  /*  FAT start pseudo-cluster    */
 
-    dm->m_recoff[BT_FAT] = (RECNO)b->fatrec;
-    dm->m_recoff[BT_ROOT] = (RECNO)b->fatrec + fs;
-    dm->m_recoff[BT_DATA] = (RECNO)b->datrec;
+    dm->m_recoff[BT_FAT] = (RECNO)fatrec;
+    dm->m_recoff[BT_ROOT] = (RECNO)fatrec + fs;
+    dm->m_recoff[BT_DATA] = (RECNO)datrec;
 
     KDEBUG(("log_media(%i) dm->m_recoff[0-2] = 0x%lx/0x%lx/0x%lx\n",
             drv, dm->m_recoff[0],dm->m_recoff[1],dm->m_recoff[2]));
 
+#if CONF_WITH_FAT32
+    /*
+     * there is no fixed root directory, so the 'root' buffer type is
+     * used to access the FSInfo sector instead
+     */
+    if (b32)
+    {
+        dm->m_recoff[BT_ROOT] = b32->l_fsinfo;
+        fsinfo_init(dm);
+    }
+#endif
+
     return E_OK;
 }
@@ -15,6 +15,8 @@
 #include "fs.h"
 #include "gemerror.h"
 #include "bdosstub.h"
+#include "mem.h"
+#include "string.h"
 
 /*
 **  cl2rec -
@@ -26,6 +28,51 @@ RECNO cl2rec(CLNO cl, DMD *dm)
 }
 
 
+#if CONF_WITH_BDOS_FREEMAP
+
+/*
+ * the free cluster bitmap has one bit per data cluster, starting with
+ * cluster 2 in bit 0 of byte 0.  a bit is set iff the cluster is free.
+ * bits beyond the last cluster are always zero.
+ */
+#define FREEMAP_SIZE(dm)    ((((ULONG)(dm)->m_numcl + 31) >> 5) << 2)
+
+/*
+ * freemap_update - record the new FAT entry for cluster 'cl'
+ */
+static void freemap_update(CLNO cl, CLNO link, DMD *dm)
+{
+    UBYTE *p, mask;
+    ULONG n;
+
+    n = (ULONG)cl - 2;
+    if (n >= dm->m_numcl)
+        return;
+
+    p = dm->m_freemap + (n >> 3);
+    mask = 1 << (n & 7);
+
+    if (link == FREECLUSTER)
+    {
+        if (!(*p & mask))
+        {
+            *p |= mask;
+            dm->m_nfree++;
+            if (cl < dm->m_nextfree)
+                dm->m_nextfree = cl;
+        }
+    }
+    else if (*p & mask)
+    {
+        *p &= ~mask;
+        dm->m_nfree--;
+        if (cl == dm->m_nextfree)
+            dm->m_nextfree++;
+    }
+}
+#endif /* CONF_WITH_BDOS_FREEMAP */
+
+
 /*
 **  clfix -
 **      replace the contents of the fat entry indexed by 'cl' with the value
@@ -36,10 +83,62 @@ RECNO cl2rec(CLNO cl, DMD *dm)
 void clfix(CLNO cl, CLNO link, DMD *dm)
 {
     int spans;
-    CLNO f, mask;
+    UWORD f, mask;
     LONG offset, recnum;
     UBYTE *buf;
 
+#if CONF_WITH_BDOS_FREEMAP
+    if (dm->m_freemap)
+        freemap_update(cl,link,dm);
+#endif
+#if CONF_WITH_BDOS_EXTMAP
+    if (link == FREECLUSTER)
+        extmap_invalidate(dm);      /* a chain is being shortened */
+#endif
+#if CONF_WITH_PGMCACHE
+    if (link == FREECLUSTER)
+        pgmcache_invalidate(dm, cl);    /* maybe a file is being deleted */
+#endif
+
+#if CONF_WITH_FAT32
+    /*
+     * handle 32-bit FAT
+     * the top 4 bits of each entry are reserved, and must be preserved
+     */
+    if (dm->m_32)
+    {
+        ULONG old;
+
+        offset = (LONG)cl << 2;
+        recnum = offset >> dm->m_rblog;
+        offset &= dm->m_rbm;
+        buf = getrec(recnum,dm->m_fatofd,1) + offset;
+        old = *(ULONG *)buf;
+        swpl(old);
+
+        /* keep the free count & next free hint up to date */
+        if (dm->m_nfree != NFREE_UNKNOWN)
+        {
+            if (!(old & 0x0fffffffUL) && (link != FREECLUSTER))
+                dm->m_nfree--;
+            else if ((old & 0x0fffffffUL) && (link == FREECLUSTER))
+                dm->m_nfree++;
+        }
+        if (link == FREECLUSTER)
+        {
+            if (cl < dm->m_nextfree)
+                dm->m_nextfree = cl;
+        }
+        else if (cl == dm->m_nextfree)
+            dm->m_nextfree++;
+
+        link = (old & 0xf0000000UL) | (link & 0x0fffffffUL);
+        swpl(link);
+        *(ULONG *)buf = link;
+        return;
+    }
+#endif
+
     offset = dm->m_16 ? (LONG)cl << 1 : ((LONG)cl + (cl >> 1));
     recnum = offset >> dm->m_rblog;
     offset &= dm->m_rbm;
@@ -51,8 +150,9 @@ void clfix(CLNO cl, CLNO link, DMD *dm)
     if (dm->m_16)
     {
         buf = getrec(recnum,dm->m_fatofd,1);
-        swpw(link);
-        *(CLNO *)(buf+offset) = link;
+        f = link;
+        swpw(f);
+        *(UWORD *)(buf+offset) = f;
         return;
     }
 
@@ -61,7 +161,7 @@ void clfix(CLNO cl, CLNO link, DMD *dm)
      */
     if (IS_ODD(cl))
     {
-        link = link << 4;
+        link = (link << 4) & 0xfff0;
         mask = 0x000f;
     }
     else
@@ -97,19 +197,37 @@ void clfix(CLNO cl, CLNO link, DMD *dm)
 **  getrealcl -
 **      get the contents of the fat entry indexed by 'cl'.
 **
-**  returns 16-bit value
-**      for FAT12: 0xffff if entry contains the end of file marker
-**                 otherwise, the contents of the entry
-**      for FAT16: the contents of the entry
+**  returns
+**      ENDOFCHAIN if entry contains the end of file marker
+**      otherwise, the contents of the entry
 **
 **      M01.0.1.03
 */
 CLNO getrealcl(CLNO cl, DMD *dm)
 {
-    CLNO f;
+    UWORD f;
     LONG offset, recnum;
     UBYTE *buf;
 
+#if CONF_WITH_FAT32
+    /*
+     * handle 32-bit FAT
+     */
+    if (dm->m_32)
+    {
+        offset = (LONG)cl << 2;
+        recnum = offset >> dm->m_rblog;
+        offset &= dm->m_rbm;
+        buf = getrec(recnum,dm->m_fatofd,0) + offset;
+        cl = *(ULONG *)buf;
+        swpl(cl);
+        cl &= 0x0fffffffUL;
+        if (cl >= 0x0ffffff8UL)     /* handle end of chain */
+            cl = ENDOFCHAIN;
+        return cl;
+    }
+#endif
+
     offset = dm->m_16 ? (LONG)cl << 1 : ((LONG)cl + (cl >> 1));
     recnum = offset >> dm->m_rblog;
     offset &= dm->m_rbm;
@@ -121,8 +239,10 @@ CLNO getrealcl(CLNO cl, DMD *dm)
      */
     if (dm->m_16)
     {
-        f = *(CLNO *)buf;
+        f = *(UWORD *)buf;
         swpw(f);
+        if (f >= 0xfff8)            /* handle end of chain */
+            return ENDOFCHAIN;
         return f;
     }
 
@@ -159,13 +279,483 @@ CLNO getrealcl(CLNO cl, DMD *dm)
 */
 CLNO getclnum(CLNO cl, OFD *of)
 {
-    if (!of->o_dnode)           /* if no dir node, must be FAT/root */
+    if (fixedofd(of))           /* FAT or FAT12/16 root */
         return cl+1;
 
     return getrealcl(cl,of->o_dmd);
 }
 
 
+/*
+ * fcb_getcl - get the starting cluster number from a directory entry
+ *
+ * on FAT32, the high word of the cluster number is stored in a field
+ * that is reserved on FAT12/16, so it is ignored on those drives.
+ */
+CLNO fcb_getcl(const FCB *fcb, DMD *dm)
+{
+    UWORD w;
+    CLNO cl;
+
+    w = fcb->f_clust;
+    swpw(w);
+    cl = w;
+
+#if CONF_WITH_FAT32
+    if (dm->m_32)
+    {
+        w = *(const UWORD *)(fcb->f_fill+FCB_CLUSTHI);
+        swpw(w);
+        cl |= (CLNO)w << 16;
+    }
+#endif
+
+    return cl;
+}
+
+/*
+ * fcb_setcl - set the starting cluster number in a directory entry
+ */
+void fcb_setcl(FCB *fcb, CLNO cl, DMD *dm)
+{
+    UWORD w;
+
+    w = LOWORD(cl);
+    swpw(w);
+    fcb->f_clust = w;
+
+#if CONF_WITH_FAT32
+    if (dm->m_32)
+    {
+        w = HIWORD(cl);
+        swpw(w);
+        *(UWORD *)(fcb->f_fill+FCB_CLUSTHI) = w;
+    }
+#endif
+}
+
+
+#if CONF_WITH_FAT32
+
+/*
+ * FSInfo sector layout (all values are little-endian)
+ */
+#define FSI_LEADSIG     0       /* 'RRaA' */
+#define FSI_STRUCSIG    484     /* 'rrAa' */
+#define FSI_FREECOUNT   488     /* free cluster count, or 0xffffffff */
+#define FSI_NEXTFREE    492     /* next free cluster hint, or 0xffffffff */
+
+/*
+ * fsinfo_valid - check the signatures of an FSInfo sector
+ */
+static BOOL fsinfo_valid(const UBYTE *buf)
+{
+    return (buf[FSI_LEADSIG] == 'R') && (buf[FSI_LEADSIG+1] == 'R')
+        && (buf[FSI_LEADSIG+2] == 'a') && (buf[FSI_LEADSIG+3] == 'A')
+        && (buf[FSI_STRUCSIG] == 'r') && (buf[FSI_STRUCSIG+1] == 'r')
+        && (buf[FSI_STRUCSIG+2] == 'A') && (buf[FSI_STRUCSIG+3] == 'a');
+}
+
+/*
+ * fsinfo_init - get the free cluster count & next free cluster hint
+ * from the FSInfo sector of a newly-logged-in FAT32 drive
+ *
+ * values that are missing or out of range are ignored
+ */
+void fsinfo_init(DMD *dm)
+{
+    UBYTE *buf;
+    ULONG n;
+
+    dm->m_nfree = NFREE_UNKNOWN;
+    dm->m_nextfree = 2;
+
+    if (!dm->m_recoff[BT_ROOT])
+        return;
+
+    buf = getrectyp(dm,BT_ROOT,0,0);
+    if (!fsinfo_valid(buf))
+    {
+        KDEBUG(("fsinfo_init(%d): no valid FSInfo sector\n",dm->m_drvnum));
+        dm->m_recoff[BT_ROOT] = 0;
+        return;
+    }
+
+    n = *(ULONG *)(buf+FSI_FREECOUNT);
+    swpl(n);
+    if (n <= dm->m_numcl)
+        dm->m_nfree = n;
+
+    n = *(ULONG *)(buf+FSI_NEXTFREE);
+    swpl(n);
+    if ((n >= 2) && (n < dm->m_numcl+2))
+        dm->m_nextfree = n;
+
+    KDEBUG(("fsinfo_init(%d): free=%lu, next=%lu\n",dm->m_drvnum,dm->m_nfree,dm->m_nextfree));
+}
+
+/*
+ * fsinfo_update - write the current free cluster count & next free
+ * cluster hint to the FSInfo sector, if they have changed
+ */
+void fsinfo_update(DMD *dm)
+{
+    UBYTE *buf;
+    ULONG nfree, next;
+
+    if (!dm->m_32 || !dm->m_recoff[BT_ROOT])
+        return;
+
+    nfree = dm->m_nfree;
+    swpl(nfree);
+    next = dm->m_nextfree;
+    swpl(next);
+
+    buf = getrectyp(dm,BT_ROOT,0,0);
+    if ((*(ULONG *)(buf+FSI_FREECOUNT) == nfree) && (*(ULONG *)(buf+FSI_NEXTFREE) == next))
+        return;
+
+    buf = getrectyp(dm,BT_ROOT,0,1);
+    *(ULONG *)(buf+FSI_FREECOUNT) = nfree;
+    *(ULONG *)(buf+FSI_NEXTFREE) = next;
+}
+#endif /* CONF_WITH_FAT32 */
+
+
+#if CONF_WITH_BDOS_EXTMAP
+
+#define EXTMAP_EXTENTS  16      /* extents per cached chain */
+
+/*
+ * an extent map describes the first x_ncl clusters of the chain starting
+ * at x_strtcl on drive x_dmd, as a list of runs of contiguous clusters.
+ * extending a chain does not affect the map; whenever any cluster is
+ * freed, all the maps for that drive are discarded.
+ */
+typedef struct
+{
+    CLNO e_start;               /* first cluster of run */
+    CLNO e_len;                 /* number of clusters in run */
+} EXTENT;
+
+typedef struct
+{
+    DMD    *x_dmd;              /* drive, or NULL if map is unused */
+    CLNO   x_strtcl;            /* first cluster of chain */
+    CLNO   x_ncl;               /* number of clusters described */
+    UWORD  x_count;             /* number of extents in use */
+    UWORD  x_age;               /* for LRU replacement */
+    EXTENT x_ext[EXTMAP_EXTENTS];
+} EXTMAP;
+
+static EXTMAP extmap[CONF_BDOS_EXTMAP_FILES];
+static UWORD extmap_clock;
+
+/*
+ * extmap_invalidate - discard all the cached chains for a drive
+ */
+void extmap_invalidate(DMD *dm)
+{
+    EXTMAP *x;
+
+    for (x = extmap; x < extmap+CONF_BDOS_EXTMAP_FILES; x++)
+        if (x->x_dmd == dm)
+            x->x_dmd = NULL;
+}
+
+/*
+ * extmap_get - find the map for the chain starting at 'strtcl', or
+ * reuse the least recently used one
+ */
+static EXTMAP *extmap_get(DMD *dm, CLNO strtcl)
+{
+    EXTMAP *x, *victim;
+
+    victim = extmap;
+    for (x = extmap; x < extmap+CONF_BDOS_EXTMAP_FILES; x++)
+    {
+        if ((x->x_dmd == dm) && (x->x_strtcl == strtcl))
+            break;
+        if (!x->x_dmd)
+            victim = x;
+        else if (victim->x_dmd && ((UWORD)(extmap_clock - x->x_age) > (UWORD)(extmap_clock - victim->x_age)))
+            victim = x;
+    }
+
+    if (x == extmap+CONF_BDOS_EXTMAP_FILES)
+    {
+        x = victim;
+        x->x_dmd = dm;
+        x->x_strtcl = strtcl;
+        x->x_ncl = 1;
+        x->x_count = 1;
+        x->x_ext[0].e_start = strtcl;
+        x->x_ext[0].e_len = 1;
+    }
+    x->x_age = ++extmap_clock;
+
+    return x;
+}
+
+/*
+ * extmap_cluster - get the cluster number at position 'index' (counting
+ * from 0) in the chain of the file open on OFD 'p'
+ *
+ * the map is extended by following the FAT as far as necessary.
+ *
+ * returns 0 if the chain is shorter than that, or if the position is
+ * beyond what a full map can describe; the caller must then follow the
+ * FAT itself
+ */
+CLNO extmap_cluster(OFD *p, CLNO index)
+{
+    DMD *dm = p->o_dmd;
+    EXTMAP *x;
+    EXTENT *e;
+    CLNO cl, cl2;
+
+    x = extmap_get(dm,p->o_dfd->o_strtcl);
+
+    if (index < x->x_ncl)
+    {
+        for (e = x->x_ext; index >= e->e_len; e++)
+            index -= e->e_len;
+        return e->e_start + index;
+    }
+
+    e = &x->x_ext[x->x_count-1];
+    cl = e->e_start + e->e_len - 1;
+
+    while (index >= x->x_ncl)
+    {
+        cl2 = getrealcl(cl,dm);
+        if (endofchain(cl2) || (cl2 < 2))
+            return 0;
+
+        if (cl2 == cl + 1)
+            e->e_len++;
+        else if (x->x_count < EXTMAP_EXTENTS)
+        {
+            e++;
+            e->e_start = cl2;
+            e->e_len = 1;
+            x->x_count++;
+        }
+        else
+            return 0;               /* map is full */
+        x->x_ncl++;
+        cl = cl2;
+    }
+
+    return cl;
+}
+#endif /* CONF_WITH_BDOS_EXTMAP */
+
+
+#if CONF_WITH_BDOS_FREEMAP
+
+/*
+ * freemap_build - build the free cluster bitmap for a drive
+ *
+ * the FAT is scanned once; afterwards the bitmap is maintained by clfix().
+ *
+ * returns FALSE if there is not enough memory for the bitmap
+ */
+static BOOL freemap_build(DMD *dm)
+{
+    UBYTE *map, *buf;
+    ULONG size, n;
+    int recnum, offset;
+    CLNO clnum;
+
+    size = FREEMAP_SIZE(dm);
+    map = xmalloc_os(size);
+    if (!map)
+        return FALSE;
+    bzero(map,size);
+
+    dm->m_nfree = 0;
+    if (dm->m_16)
+    {
+        /* fast scan of FAT16, one FAT record at a time */
+        for (clnum = 2; clnum < dm->m_numcl+2; )
+        {
+            recnum = (clnum * sizeof(UWORD)) >> dm->m_rblog;
+            offset = (clnum * sizeof(UWORD)) & dm->m_rbm;
+            buf = getrec(recnum, dm->m_fatofd, 0);
+
+            for ( ; (offset < dm->m_recsiz) && (clnum < (dm->m_numcl+2)); offset += sizeof(UWORD), clnum++)
+            {
+                if (*(UWORD *)(buf+offset) == 0)
+                {
+                    n = clnum - 2;
+                    map[n>>3] |= 1 << (n & 7);
+                    dm->m_nfree++;
+                }
+            }
+        }
+    }
+    else
+    {
+        for (n = 0; n < dm->m_numcl; n++)
+        {
+            if (!getrealcl(n+2,dm))
+            {
+                map[n>>3] |= 1 << (n & 7);
+                dm->m_nfree++;
+            }
+        }
+    }
+
+    dm->m_nextfree = 2;
+    dm->m_freemap = map;
+    KDEBUG(("freemap_build(%d): %lu free clusters\n",dm->m_drvnum,(ULONG)dm->m_nfree));
+
+    return TRUE;
+}
+
+/*
+ * freemap_avail - check if the bitmap is available, building it if necessary
+ *
+ * FAT32 drives do not use a bitmap: it would be too large, and building
+ * it would mean reading the whole FAT.  they use the free cluster count
+ * and next free cluster hint from the FSInfo sector instead.
+ */
+static BOOL freemap_avail(DMD *dm)
+{
+    if (dm->m_32)
+        return FALSE;
+
+    return dm->m_freemap || freemap_build(dm);
+}
+
+/*
+ * freemap_find - find the first free cluster at or after 'cl'
+ *
+ * the search wraps at the end of the drive.  whole bytes of allocated
+ * clusters are skipped at once.
+ *
+ * returns cluster number, or 0 if no free clusters
+ */
+static CLNO freemap_find(CLNO cl, DMD *dm)
+{
+    UBYTE *map = dm->m_freemap;
+    ULONG n, count;
+
+    if (dm->m_nfree == 0)
+        return 0;
+
+    if (cl < dm->m_nextfree)
+        cl = dm->m_nextfree;
+    n = (ULONG)cl - 2;
+    if (n >= dm->m_numcl)
+        n = 0;
+
+    for (count = 0; count < dm->m_numcl; )
+    {
+        if (((n & 7) == 0) && (map[n>>3] == 0))
+        {
+            n += 8;
+            count += 8;
+        }
+        else
+        {
+            if (map[n>>3] & (1 << (n & 7)))
+                return n + 2;
+            n++;
+            count++;
+        }
+        if (n >= dm->m_numcl)
+            n = 0;
+    }
+
+    return 0;
+}
+
+/*
+ * freemap_findrun - find a run of up to 'want' free clusters for a file
+ * whose last cluster is 'cl'
+ *
+ * if the cluster following 'cl' is free, the file is extended in place.
+ * otherwise the first run of at least 'want' clusters is used; if there
+ * is no such run, the longest run on the drive is used instead.
+ *
+ * returns the first cluster of the run & its length in *len, or 0 if
+ * no free clusters
+ */
+static CLNO freemap_findrun(CLNO cl, CLNO want, DMD *dm, CLNO *len)
+{
+    UBYTE *map = dm->m_freemap;
+    ULONG n, start, run, beststart, bestrun;
+
+    if (dm->m_nfree == 0)
+        return 0;
+
+    /* first try to extend the file in place */
+    if (cl >= 2)
+    {
+        for (n = cl - 1, run = 0; (run < want) && (n < dm->m_numcl); n++, run++)
+            if (!(map[n>>3] & (1 << (n & 7))))
+                break;
+        if (run)
+        {
+            *len = run;
+            return cl + 1;
+        }
+    }
+
+    beststart = bestrun = 0;
+    start = run = 0;
+    for (n = dm->m_nextfree - 2; n < dm->m_numcl; )
+    {
+        if (((n & 7) == 0) && (map[n>>3] == 0))
+        {
+            run = 0;
+            n += 8;
+            continue;
+        }
+
+        if (map[n>>3] & (1 << (n & 7)))
+        {
+            if (run++ == 0)
+                start = n;
+            if (run >= want)
+            {
+                *len = want;
+                return start + 2;
+            }
+            if (run > bestrun)
+            {
+                beststart = start;
+                bestrun = run;
+            }
+        }
+        else
+            run = 0;
+        n++;
+    }
+
+    if (bestrun == 0)
+        return 0;
+
+    *len = bestrun;
+    return beststart + 2;
+}
+
+/*
+ * freemap_release - free the bitmap when a drive is logged out
+ */
+void freemap_release(DMD *dm)
+{
+    if (dm->m_freemap)
+    {
+        xmfree(dm->m_freemap);
+        dm->m_freemap = NULL;
+    }
+}
+#endif /* CONF_WITH_BDOS_FREEMAP */
+
+
 /*
  * findfree16 - fast scan of FAT16 filesystem to find first free cluster
  *
@@ -182,16 +772,16 @@ static CLNO findfree16(DMD *dm)
         /*
          * get the next FAT record
          */
-        recnum = (clnum * sizeof(CLNO)) >> dm->m_rblog;
-        offset = (clnum * sizeof(CLNO)) & dm->m_rbm;
+        recnum = (clnum * sizeof(UWORD)) >> dm->m_rblog;
+        offset = (clnum * sizeof(UWORD)) & dm->m_rbm;
         buf = getrec(recnum, dm->m_fatofd, 0);
 
         /*
          * scan the FAT record, looking for a free slot
          */
-        for ( ; (offset < dm->m_recsiz) && (clnum < (dm->m_numcl+2)); offset += sizeof(CLNO), clnum++)
+        for ( ; (offset < dm->m_recsiz) && (clnum < (dm->m_numcl+2)); offset += sizeof(UWORD), clnum++)
         {
-            if (*(CLNO *)(buf+offset) == 0)
+            if (*(UWORD *)(buf+offset) == 0)
                 return clnum;
         }
     }
@@ -200,6 +790,88 @@ static CLNO findfree16(DMD *dm)
 }
 
 
+#if CONF_WITH_FAT32
+/*
+ * findfree32 - scan FAT32 filesystem to find the first free cluster at
+ * or after 'cl', or after the next free cluster hint if that is higher
+ *
+ * the search wraps at the end of the drive.
+ *
+ * returns cluster number, or 0 if no free clusters
+ */
+static CLNO findfree32(CLNO cl, DMD *dm)
+{
+    RECNO recnum;
+    UWORD offset;
+    CLNO count;
+    ULONG entry;
+    UBYTE *buf;
+
+    if (dm->m_nfree == 0)
+        return 0;
+
+    if (cl < dm->m_nextfree)
+        cl = dm->m_nextfree;
+    if ((cl < 2) || (cl >= dm->m_numcl+2))
+        cl = 2;
+
+    for (count = 0; count < dm->m_numcl; )
+    {
+        /*
+         * get the next FAT record
+         */
+        recnum = (cl << 2) >> dm->m_rblog;
+        offset = (cl << 2) & dm->m_rbm;
+        buf = getrec(recnum, dm->m_fatofd, 0);
+
+        /*
+         * scan the FAT record, looking for a free slot
+         */
+        for ( ; (offset < dm->m_recsiz) && (count < dm->m_numcl); offset += sizeof(ULONG), count++)
+        {
+            entry = *(ULONG *)(buf+offset);
+            if (!(entry & 0xffffff0fUL))    /* little-endian 0x0fffffff */
+                return cl;
+            if (++cl == dm->m_numcl+2)      /* wrap at max cluster num */
+            {
+                cl = 2;
+                count++;
+                break;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * countfree32 - scan FAT32 filesystem to count free clusters
+ */
+static CLNO countfree32(DMD *dm)
+{
+    RECNO recnum;
+    UWORD offset;
+    CLNO free, clnum;
+    UBYTE *buf;
+
+    for (clnum = 2, free = 0; clnum < dm->m_numcl+2; )
+    {
+        recnum = (clnum << 2) >> dm->m_rblog;
+        offset = (clnum << 2) & dm->m_rbm;
+        buf = getrec(recnum, dm->m_fatofd, 0);
+
+        for ( ; (offset < dm->m_recsiz) && (clnum < (dm->m_numcl+2)); offset += sizeof(ULONG), clnum++)
+        {
+            if (!(*(ULONG *)(buf+offset) & 0xffffff0fUL))
+                free++;
+        }
+    }
+
+    return free;
+}
+#endif /* CONF_WITH_FAT32 */
+
+
 /*
  * findfree - scan filesystem to find next free cluster
  *
@@ -209,6 +881,16 @@ static CLNO findfree(CLNO cl, DMD *dm)
 {
     CLNO i;
 
+#if CONF_WITH_BDOS_FREEMAP
+    if (freemap_avail(dm))
+        return freemap_find(cl,dm);
+#endif
+
+#if CONF_WITH_FAT32
+    if (dm->m_32)
+        return findfree32(cl,dm);
+#endif
+
     /*
      * fast scan for first free cluster on FAT16 filesystem
      */
@@ -234,6 +916,88 @@ static CLNO findfree(CLNO cl, DMD *dm)
 }
 
 
+/*
+ * findrun - find a run of up to 'want' contiguous free clusters to
+ * follow cluster 'cl'
+ *
+ * returns first cluster number & length of run in *len, or 0 if no
+ * free clusters
+ */
+static CLNO findrun(CLNO cl, CLNO want, DMD *dm, CLNO *len)
+{
+    CLNO start, n;
+
+#if CONF_WITH_BDOS_FREEMAP
+    if (freemap_avail(dm))
+        return freemap_findrun(cl,want,dm,len);
+#endif
+
+    start = findfree(cl,dm);
+    if (start == 0)
+        return 0;
+
+    /* extend the run as far as the following clusters are free */
+    for (n = 1; (n < want) && (start+n < dm->m_numcl+2); n++)
+        if (getrealcl(start+n,dm))
+            break;
+
+    *len = n;
+    return start;
+}
+
+
+/*
+ * cltrim - free any clusters beyond the end of the file
+ *
+ * this removes clusters preallocated by nextcl_run() that were never
+ * written, e.g. because the write was aborted by a disk error.
+ */
+void cltrim(OFD *p)
+{
+    DMD *dm = p->o_dmd;
+    DFD *dfd = p->o_dfd;
+    CLNO cl, cl2;
+    ULONG n;
+
+    dfd->o_flag &= ~O_PREALLOC;
+
+    cl = dfd->o_strtcl;
+    if (!cl)
+        return;
+
+    n = (dfd->o_fileln + dm->m_clbm) >> dm->m_clblog;
+    if (n == 0)
+    {
+        dfd->o_strtcl = 0;
+        dfd->o_flag |= O_DIRTY;
+    }
+    else
+    {
+        /* find last cluster containing data */
+        while(--n)
+        {
+            cl = getrealcl(cl,dm);
+            if (endofchain(cl) || (cl < 2))
+                return;
+        }
+        cl2 = getrealcl(cl,dm);
+        if (endofchain(cl2) || (cl2 < 2))
+            return;
+        clfix(cl,ENDOFCHAIN,dm);
+        cl = cl2;
+    }
+
+    while (cl && !endofchain(cl))
+    {
+        cl2 = getrealcl(cl,dm);
+        clfix(cl,FREECLUSTER,dm);
+        cl = cl2;
+    }
+
+    KDEBUG(("cltrim(%d): file length %ld\n",dm->m_drvnum,dfd->o_fileln));
+}
+
+
 /*
 **  nextcl -
 **      get the cluster number which follows the cluster indicated in the curcl
@@ -245,10 +1009,24 @@ static CLNO findfree(CLNO cl, DMD *dm)
 **
 */
 int nextcl(OFD *p, int wrtflg)
+{
+    return nextcl_run(p,wrtflg,1);
+}
+
+
+/*
+**  nextcl_run -
+**      like nextcl(), but when the end of the chain is reached while
+**      writing, allocate a contiguous run of up to 'want' clusters at
+**      once, so that the clusters required for the remainder of a write
+**      request are adjacent on disk.  the extra clusters are linked into
+**      the chain and picked up by subsequent calls.
+*/
+int nextcl_run(OFD *p, int wrtflg, CLNO want)
 {
     DMD     *dm;
     DFD     *dfd = p->o_dfd;
-    CLNO    cl, cl2;                                /*  M01.01.03   */
+    CLNO    cl, cl2, n, len;                        /*  M01.01.03   */
 
     cl = p->o_curcl;
     dm = p->o_dmd;
@@ -257,7 +1035,7 @@ int nextcl(OFD *p, int wrtflg)
     {
         cl2 = (dfd->o_strtcl ? dfd->o_strtcl : ENDOFCHAIN );
     }
-    else if (!p->o_dnode)       /* if no dir node, must be FAT/root */
+    else if (fixedofd(p))       /* FAT or FAT12/16 root */
     {
         cl2 = cl + 1;
     }
@@ -268,11 +1046,23 @@ int nextcl(OFD *p, int wrtflg)
 
     if (wrtflg && endofchain(cl2))  /* end of file, allocate new clusters */
     {
-        cl2 = findfree(cl,dm);
+        if (want > 1)
+            cl2 = findrun(cl,want,dm,&len);
+        else
+        {
+            cl2 = findfree(cl,dm);
+            len = 1;
+        }
         if (cl2 == 0)
             return -1;
 
-        clfix(cl2,ENDOFCHAIN,dm);
+        /* link the run from its end, so the chain is never left open */
+        clfix(cl2+len-1,ENDOFCHAIN,dm);
+        for (n = len-1; n > 0; n--)
+            clfix(cl2+n-1,cl2+n,dm);
+        if (len > 1)
+            dfd->o_flag |= O_PREALLOC;
+
         if (cl)
             clfix(cl,cl2,dm);
         else
@@ -307,16 +1097,16 @@ static CLNO countfree16(DMD *dm)
         /*
          * get the next FAT record
          */
-        recnum = (clnum * sizeof(CLNO)) >> dm->m_rblog;
-        offset = (clnum * sizeof(CLNO)) & dm->m_rbm;
+        recnum = (clnum * sizeof(UWORD)) >> dm->m_rblog;
+        offset = (clnum * sizeof(UWORD)) & dm->m_rbm;
         buf = getrec(recnum, dm->m_fatofd, 0);
 
         /*
          * scan the FAT record, counting free slots
          */
-        for ( ; (offset < dm->m_recsiz) && (clnum < (dm->m_numcl+2)); offset += sizeof(CLNO), clnum++)
+        for ( ; (offset < dm->m_recsiz) && (clnum < (dm->m_numcl+2)); offset += sizeof(UWORD), clnum++)
         {
-            if (*(CLNO *)(buf+offset) == 0)
+            if (*(UWORD *)(buf+offset) == 0)
                 free++;
         }
     }
@@ -345,7 +1135,27 @@ long xgetfree(long *buf, int drv)
     if ((n = ckdrv(drv, TRUE)) < 0)
         return ERR;
 
+    bufl_flush(n);                      /* write back pending updates */
+
     dm = drvtbl[n];
+#if CONF_WITH_BDOS_FREEMAP
+    if (freemap_avail(dm))
+    {
+        free = dm->m_nfree;
+    }
+    else
+#endif
+#if CONF_WITH_FAT32
+    if (dm->m_32)
+    {
+        /* count once if FSInfo didn't tell us; clfix() maintains it */
+        if (dm->m_nfree == NFREE_UNKNOWN)
+            dm->m_nfree = countfree32(dm);
+        free = dm->m_nfree;
+        fsinfo_update(dm);
+    }
+    else
+#endif
     if (dm->m_16)
     {
         free = countfree16(dm);
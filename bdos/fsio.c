@@ -77,15 +77,18 @@ static void usrio(int rwflg, int num, long strt, char *ubuf, DMD *dm)
 /*
  * read/write records on behalf of xrw()
  *
+ * 'lentail' is the number of bytes that xrw() will transfer after these
+ * records; it is used to size the cluster allocation when writing.
+ *
  * returns
  *      NULL if end of cluster chain was reached
  *      otherwise, updated buffer ptr
  */
-static char *xrw_recs(WORD wrtflg, OFD *p, RECNO startrec, RECNO numrecs, char *ubufr)
+static char *xrw_recs(WORD wrtflg, OFD *p, RECNO startrec, RECNO numrecs, char *ubufr, WORD lentail)
 {
     DMD *dm;
     RECNO hdrrec, tailrec, last, nrecs;
-    CLNO numclus;
+    CLNO numclus, lastclus;
     LONG nbytes;
     WORD rc;
     BOOL first_time;
@@ -123,14 +126,20 @@ static char *xrw_recs(WORD wrtflg, OFD *p, RECNO startrec, RECNO numrecs, char *
      * do whole (middle) clusters
      */
     numclus = numrecs >> dm->m_clrlog;
+    lastclus = (tailrec || lentail) ? 1 : 0;
     last = nrecs = 0L;
     rc = 0;
     first_time = TRUE;
 
     while(TRUE)
     {
+        /*
+         * when writing, any clusters that must be allocated are allocated
+         * as one contiguous run sized to the rest of the request, so that
+         * the transfers below can be merged
+         */
         if (numclus)
-            rc = nextcl(p,wrtflg);
+            rc = nextcl_run(p,wrtflg,numclus+lastclus);
 
         if (first_time)
         {
@@ -252,7 +261,7 @@ static long xrw(int wrtflg, OFD *p, long len, char *ubufr)
 
     if (numrecs)
     {
-        ubufr = xrw_recs(wrtflg,p,recn,numrecs,ubufr);
+        ubufr = xrw_recs(wrtflg,p,recn,numrecs,ubufr,lentail);
         if (!ubufr)                         /* end of cluster chain reached */
             goto eof;
     }
@@ -278,6 +287,13 @@ static long xrw(int wrtflg, OFD *p, long len, char *ubufr)
     }
 
 eof:
+    /*
+     * clusters preallocated by nextcl_run() are now in use, so there
+     * is nothing for ixclose() to trim unless we were interrupted
+     */
+    if (wrtflg)
+        p->o_dfd->o_flag &= ~O_PREALLOC;
+
     rc = p->o_bytnum - bytpos;
 
     return(rc);
@@ -371,6 +387,22 @@ long ixlseek(OFD *p,long n)
      */
     clnum = n >> dm->m_clblog;
 
+#if CONF_WITH_BDOS_EXTMAP
+    /*
+     * for files & subdirectories, look up the cluster in the cached
+     * extent map of the chain, rather than following the FAT (see the
+     * note below for why we may need the cluster before the one that
+     * contains the desired position).  if the map can't provide it,
+     * follow the FAT as usual.
+     */
+    if (!fixedofd(p) && dfd->o_strtcl)
+    {
+        clx = extmap_cluster(p,((n&dm->m_clbm) == 0) ? clnum-1 : clnum);
+        if (clx)
+            goto found;
+    }
+#endif
+
     /*
      * if that's beyond where we are, we can chain forward;
      * otherwise, we need to start from the beginning
@@ -417,6 +449,9 @@ long ixlseek(OFD *p,long n)
             return EINTRN;      /* FAT chain is shorter than filesize says ... */
     }
 
+#if CONF_WITH_BDOS_EXTMAP
+found:
+#endif
     p->o_curcl = clx;
     p->o_currec = cl2rec(clx,dm);
     p->o_bytnum = n;
@@ -553,5 +588,10 @@ long xwrite(int h, long len, void *ubufr)
 
 long ixwrite(OFD *p, long len, void *ubufr)
 {
+#if CONF_WITH_PGMCACHE
+    if (p->o_dfd && p->o_dfd->o_strtcl)
+        pgmcache_invalidate(p->o_dmd, p->o_dfd->o_strtcl);
+#endif
+
     return(xrw(1,p,len,ubufr));
 }
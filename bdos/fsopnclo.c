@@ -172,7 +172,7 @@ long ixcreat(char *name, UBYTE attr)
     while( !( fcb = scan(dn,n,0xff,&pos) ) )
     {
         /*  not in current dir, need to grow  */
-        if (!fd->o_dnode)           /*  but can't grow root  */
+        if (fixedofd(fd))           /*  but can't grow FAT12/16 root  */
             return EACCDN;
 
         if ( nextcl(fd,1) )
@@ -195,6 +195,9 @@ long ixcreat(char *name, UBYTE attr)
     fcb->f_fileln = 0;
     ixlseek(fd,pos);
     ixwrite(fd,FNAMELEN,a);         /* write name, set dirty flag */
+#if CONF_WITH_BDOS_DIRHASH
+    dirhash_insert(dn,a,pos);
+#endif
     ixclose(fd,CL_DIR);             /* partial close to flush */
     ixlseek(fd,pos);
     s = (char *)ixgetfcb(fd);
@@ -312,8 +315,7 @@ static long makopn(FCB *f, DND *dn, int h, int mod)
         dfd->o_usecnt = 1;              /* only OFD using this DFD */
         dfd->o_td.date = f->f_td.date;  /* note: OFD time/date are  */
         dfd->o_td.time = f->f_td.time;  /*  actually little-endian! */
-        dfd->o_strtcl = f->f_clust;     /* 1st cluster of file */
-        swpw(dfd->o_strtcl);
+        dfd->o_strtcl = fcb_getcl(f,dn->d_drv); /* 1st cluster of file */
         dfd->o_fileln = f->f_fileln;    /* init length of file */
         swpl(dfd->o_fileln);
     }
@@ -511,8 +513,6 @@ long xclose(int h)
 long ixclose(OFD *fd, int part)
 {                                   /*  M01.01.03                   */
     OFD *p, **q;
-    int i;                          /*  M01.01.03                   */
-    BCB *b;
     DFD *dfd = fd->o_dfd;
 
     /*
@@ -526,7 +526,13 @@ long ixclose(OFD *fd, int part)
      * FCB, and updating it directly.  We must do an ixwrite() at the
      * end so that the buffer is marked as dirty and is subsequently
      * written.
+     *
+     * First, free any clusters that were preallocated by a write that
+     * did not complete: this may update the starting cluster.
      */
+    if ((dfd->o_flag & O_PREALLOC) && !(part & CL_DIR))
+        cltrim(fd);
+
     if (dfd->o_flag & O_DIRTY)
     {
         FCB *fcb;
@@ -535,8 +541,9 @@ long ixclose(OFD *fd, int part)
         ixlseek(fd->o_dirfil,fd->o_dirbyt); /* start of dir entry */
         fcb = ixgetfcb(fd->o_dirfil);
         attr = fcb->f_attrib;               /* get attributes */
-        memcpy(&fcb->f_td,&dfd->o_td,10);   /* copy date/time, start, length */
-        swpw(fcb->f_clust);                 /*  & fixup byte order */
+        fcb->f_td = dfd->o_td;              /* copy date/time, start, length */
+        fcb_setcl(fcb,dfd->o_strtcl,fd->o_dmd); /*  & fixup byte order */
+        fcb->f_fileln = dfd->o_fileln;
         swpl(fcb->f_fileln);
 
         if (part & CL_DIR)
@@ -565,18 +572,14 @@ long ixclose(OFD *fd, int part)
             return EINTRN;  /* some kind of internal error */
     }
 
+#if CONF_WITH_FAT32
+    fsinfo_update(fd->o_dmd);           /* record free space changes */
+#endif
+
     /*
      * flush all drives
-     *
-     * this could in theory be improved by flushing all sectors for one
-     * drive before moving on to the next, reducing arm movement on
-     * partitioned hard disks.  however this would cost code space and,
-     * in practice, flushing usually takes place to one drive only.
      */
-    for (i = BI_FAT; i <= BI_DATA; i++)
-        for (b = bufl[i]; b; b = b->b_link)
-            if ((b->b_bufdrv != -1) && b->b_dirty)
-                flush(b);
+    bufl_flush(-1);
 
     return E_OK;
 }
@@ -653,7 +656,7 @@ long ixdel(DND *dn, FCB *f, long pos)
 {
     OFD *fd;
     DMD *dm;
-    int n2;
+    CLNO cl, cl2;
     int n;
     char c;
 
@@ -672,20 +675,22 @@ long ixdel(DND *dn, FCB *f, long pos)
      * Traverse this file's chain of allocated clusters, freeing them.
      */
     dm = dn->d_drv;
-    n = f->f_clust;
-    swpw(n);
+    cl = fcb_getcl(f,dm);
 
-    while (n && !endofchain(n))
+    while (cl && !endofchain(cl))
     {
-        n2 = getrealcl(n,dm);
-        clfix(n,FREECLUSTER,dm);
-        n = n2;
+        cl2 = getrealcl(cl,dm);
+        clfix(cl,FREECLUSTER,dm);
+        cl = cl2;
     }
 
     /*
      * Mark the directory entry as erased.
      */
     fd = dn->d_ofd;
+#if CONF_WITH_BDOS_DIRHASH
+    dirhash_remove(dn,pos);
+#endif
     ixlseek(fd,pos);
     c = ERASE_MARKER;
     ixwrite(fd,1L,&c);
@@ -29,12 +29,59 @@ long ccfreeit;
 #endif
 
 
+/*
+ *  takeit - allocate the first 'amount' bytes of free block q
+ *
+ *  p is the free block preceding q (or the MEMORY_PARTITION_BLOCK itself)
+ */
+static MEMORY_DESCRIPTOR *takeit(MEMORY_DESCRIPTOR *p, MEMORY_DESCRIPTOR *q, long amount, MEMORY_PARTITION_BLOCK *mp)
+{
+    MEMORY_DESCRIPTOR *p1;
+
+    if (q->m_length == amount)
+        p->m_link = q->m_link;  /* take the whole thing */
+    else
+    {
+        /* break it up - 1st allocate a new MEMORY_DESCRIPTOR to describe the remainder */
+
+        /*********** TBD **********
+         * Nicer Handling of This *
+         *        Situation       *
+         **************************/
+        if ((p1=xmgetmd()) == NULL)
+        {
+            KDEBUG(("BDOS takeit: null MGET\n"));
+            return NULL;
+        }
+
+        /* init new MEMORY_DESCRIPTOR for remaining memory on free chain */
+        p1->m_length = q->m_length - amount;
+        p1->m_start = q->m_start + amount;
+        p1->m_link = q->m_link;
+        p->m_link = p1;
+
+        /* adjust old MEMORY_DESCRIPTOR for allocated memory on allocated chain */
+        q->m_length = amount;
+    }
+
+    /*
+     * link allocated block into allocated list & mark owner of block
+     */
+    q->m_link = mp->mp_mal;
+    mp->mp_mal = q;
+    q->m_own = run;
+
+    KDEBUG(("BDOS takeit: start=%p, length=%ld\n",q->m_start,q->m_length));
+    return q;
+}
+
+
 /*
  *  ffit - find first fit for requested memory in ospool
  */
 MEMORY_DESCRIPTOR *ffit(long amount, MEMORY_PARTITION_BLOCK *mp)
 {
-    MEMORY_DESCRIPTOR *p, *q, *p1;     /* free list is composed of MEMORY_DESCRIPTOR's */
+    MEMORY_DESCRIPTOR *p, *q;          /* free list is composed of MEMORY_DESCRIPTOR's */
     LONG maxval;
 
 #ifdef ENABLE_KDEBUG
@@ -100,42 +147,83 @@ MEMORY_DESCRIPTOR *ffit(long amount, MEMORY_PARTITION_BLOCK *mp)
         return NULL;
     }
 
-    if (q->m_length == amount)
-        p->m_link = q->m_link;  /* take the whole thing */
+    return takeit(p, q, amount, mp);
+}
+
+
+#if CONF_WITH_BDOS_FREEMAP || CONF_WITH_BDOS_OSMEM_GROWTH || CONF_WITH_BDOS_DIRHASH || CONF_WITH_PGMCACHE
+/*
+ *  lfit - allocate requested memory from the top of the highest free
+ *  block that is large enough
+ *
+ *  this keeps long-lived allocations away from the low end of the pool,
+ *  where programs are loaded
+ */
+MEMORY_DESCRIPTOR *lfit(long amount, MEMORY_PARTITION_BLOCK *mp)
+{
+    MEMORY_DESCRIPTOR *p, *q, *f, *fp, *m;
+
+    KDEBUG(("BDOS lfit: requested=%ld\n",amount));
+
+    if (mp == &pmd)
+        amount = (amount + malloc_align_stram) & ~malloc_align_stram;
     else
+        amount = (amount + MALLOC_ALIGN_ALTRAM) & ~MALLOC_ALIGN_ALTRAM;
+
+    /*
+     * get the new MEMORY_DESCRIPTOR first, since this may itself
+     * allocate memory (see osmem.c)
+     */
+    m = xmgetmd();
+    if (!m)
     {
-        /* break it up - 1st allocate a new MEMORY_DESCRIPTOR to describe the remainder */
+        KDEBUG(("BDOS lfit: null MGET\n"));
+        return NULL;
+    }
 
-        /*********** TBD **********
-         * Nicer Handling of This *
-         *        Situation       *
-         **************************/
-        if ((p1=xmgetmd()) == NULL)
+    /*
+     * look for the last free space that's large enough
+     */
+    f = fp = NULL;
+    for (p = (MEMORY_DESCRIPTOR *)mp, q = mp->mp_mfl; q; p = q, q = p->m_link)
+    {
+        if (q->m_length >= amount)
         {
-            KDEBUG(("BDOS ffit: null MGET\n"));
-            return NULL;
+            fp = p;
+            f = q;
         }
+    }
+    if (!f)
+    {
+        KDEBUG(("BDOS lfit: Not enough contiguous memory\n"));
+        xmfremd(m);
+        return NULL;
+    }
 
-        /* init new MEMORY_DESCRIPTOR for remaining memory on free chain */
-        p1->m_length = q->m_length - amount;
-        p1->m_start = q->m_start + amount;
-        p1->m_link = q->m_link;
-        p->m_link = p1;
-
-        /* adjust old MEMORY_DESCRIPTOR for allocated memory on allocated chain */
-        q->m_length = amount;
+    if (f->m_length == amount)
+    {
+        fp->m_link = f->m_link;     /* take the whole thing */
+        xmfremd(m);
+        m = f;
+    }
+    else
+    {
+        f->m_length -= amount;      /* take the top of it */
+        m->m_start = f->m_start + f->m_length;
+        m->m_length = amount;
     }
 
     /*
      * link allocated block into allocated list & mark owner of block
      */
-    q->m_link = mp->mp_mal;
-    mp->mp_mal = q;
-    q->m_own = run;
+    m->m_link = mp->mp_mal;
+    mp->mp_mal = m;
+    m->m_own = run;
 
-    KDEBUG(("BDOS ffit: start=%p, length=%ld\n",q->m_start,q->m_length));
-    return q;
+    KDEBUG(("BDOS lfit: start=%p, length=%ld\n",m->m_start,m->m_length));
+    return m;
 }
+#endif
 
 
 /*
@@ -261,3 +349,350 @@ WORD shrinkit(MEMORY_DESCRIPTOR *m, MEMORY_PARTITION_BLOCK *mp, LONG newlen)
 
     return 0;
 }
+
+
+#if CONF_WITH_BDOS_SIZE_CLASSES
+
+/*
+ * size-class allocator for small blocks
+ *
+ * Requests of up to SC_MAXSIZE bytes are rounded up to a power of 2 and
+ * served from slabs: SC_SLABSIZE-byte blocks, aligned on their size and
+ * allocated from the same memory partition via ffit(), that are cut into
+ * blocks of a single size class.  A slab starts with a header, followed
+ * by the owner of each block (NULL if the block is free), followed by
+ * the blocks themselves.  The free blocks of a slab are chained through
+ * their first longword.
+ *
+ * This way, allocating or freeing a small block takes constant time and
+ * uses no MEMORY_DESCRIPTOR: the ordinary lists only hold the slabs
+ * themselves, which are owned by nobody.  A slab is given back to the
+ * partition when it becomes empty, unless it is the only slab of its
+ * size class with free blocks.
+ */
+#define SC_MINSHIFT     4       /* smallest class: 16 bytes */
+#define SC_SLABSIZE     2048L
+#define SC_RESERVED     ((PD *)1L)  /* owner of blocks kept by Ptermres() */
+#define SLAB_MAGIC      0x534c4142L /* 'SLAB' */
+
+typedef struct _slab SLAB;
+struct _slab
+{
+    SLAB    *s_self;    /* points to the slab itself, and ... */
+    ULONG   s_magic;    /* ... SLAB_MAGIC ^ s_self: identify a slab */
+    SLAB    *s_link;    /* next slab of the pool */
+    SLAB    *s_next;    /* next slab of the same class with free blocks */
+    UBYTE   *s_free;    /* first free block */
+    UBYTE   *s_first;   /* first block */
+    UWORD   s_nblocks;  /* number of blocks */
+    UWORD   s_nfree;    /* number of free blocks */
+    WORD    s_class;    /* size class */
+    WORD    s_shift;    /* block size is (1 << s_shift) */
+};
+
+#define SLAB_OWN(s)     ((PD **)((s)+1))
+
+typedef struct
+{
+    SLAB    *sp_all;                    /* all the slabs of the pool */
+    SLAB    *sp_avail[SC_NCLASSES];     /* slabs with free blocks, by class */
+    UBYTE   *sp_low, *sp_high;          /* address range covered by slabs */
+} SLABPOOL;
+
+#if CONF_WITH_ALT_RAM
+static SLABPOOL slabpool[2];
+#define POOL(mp)    (&slabpool[(mp) != &pmd])
+#else
+static SLABPOOL slabpool[1];
+#define POOL(mp)    (&slabpool[0])
+#endif
+
+
+/*
+ *  newslab - allocate a slab for the specified class & put it on the pool
+ *
+ *  the slab is aligned on SC_SLABSIZE, so that the slab holding a block
+ *  can be found from the block address.  returns NULL if no memory.
+ */
+static SLAB *newslab(WORD class, MEMORY_PARTITION_BLOCK *mp)
+{
+    MEMORY_DESCRIPTOR *p, *q, *p1;
+    SLABPOOL *pool = POOL(mp);
+    SLAB *s;
+    UBYTE *start, *b;
+    WORD shift = class + SC_MINSHIFT;
+    UWORD i;
+
+    /* look for the first free space that holds an aligned slab */
+    for (p = (MEMORY_DESCRIPTOR *)mp, q = mp->mp_mfl; q; p = q, q = p->m_link)
+    {
+        start = (UBYTE *)(((ULONG)q->m_start + SC_SLABSIZE - 1) & ~(SC_SLABSIZE - 1));
+        if (start + SC_SLABSIZE <= q->m_start + q->m_length)
+            break;
+    }
+    if (!q)
+        return NULL;
+
+    /* leave the space below the slab on the free list */
+    if (start != q->m_start)
+    {
+        if ((p1=xmgetmd()) == NULL)
+            return NULL;
+        p1->m_start = start;
+        p1->m_length = q->m_start + q->m_length - start;
+        p1->m_link = q->m_link;
+        q->m_length = start - q->m_start;
+        q->m_link = p1;
+        p = q;
+        q = p1;
+    }
+
+    q = takeit(p, q, SC_SLABSIZE, mp);
+    if (!q)
+        return NULL;
+    q->m_own = NULL;
+
+    s = (SLAB *)q->m_start;
+    s->s_self = s;
+    s->s_magic = SLAB_MAGIC ^ (ULONG)s;
+    s->s_nblocks = (SC_SLABSIZE - sizeof(SLAB)) / ((1L << shift) + sizeof(PD *));
+    s->s_nfree = s->s_nblocks;
+    s->s_first = (UBYTE *)s + SC_SLABSIZE - ((ULONG)s->s_nblocks << shift);
+    s->s_class = class;
+    s->s_shift = shift;
+
+    /* chain the free blocks */
+    s->s_free = NULL;
+    for (i = s->s_nblocks, b = (UBYTE *)s + SC_SLABSIZE; i > 0; i--)
+    {
+        b -= 1L << shift;
+        *(UBYTE **)b = s->s_free;
+        s->s_free = b;
+        SLAB_OWN(s)[i-1] = NULL;
+    }
+
+    s->s_link = pool->sp_all;
+    pool->sp_all = s;
+    s->s_next = pool->sp_avail[class];
+    pool->sp_avail[class] = s;
+
+    if (!pool->sp_low || ((UBYTE *)s < pool->sp_low))
+        pool->sp_low = (UBYTE *)s;
+    if ((UBYTE *)s + SC_SLABSIZE > pool->sp_high)
+        pool->sp_high = (UBYTE *)s + SC_SLABSIZE;
+
+    KDEBUG(("BDOS newslab: class=%d, slab=%p, %u blocks\n",class,s,s->s_nblocks));
+    return s;
+}
+
+
+/*
+ *  dropslab - give an empty slab back to the partition
+ */
+static void dropslab(SLAB *s, MEMORY_PARTITION_BLOCK *mp)
+{
+    SLABPOOL *pool = POOL(mp);
+    SLAB **ps;
+    MEMORY_DESCRIPTOR *m;
+
+    for (ps = &pool->sp_avail[s->s_class]; *ps; ps = &(*ps)->s_next)
+        if (*ps == s)
+        {
+            *ps = s->s_next;
+            break;
+        }
+    for (ps = &pool->sp_all; *ps; ps = &(*ps)->s_link)
+        if (*ps == s)
+        {
+            *ps = s->s_link;
+            break;
+        }
+    s->s_self = NULL;
+    s->s_magic = 0L;
+
+    for (m = mp->mp_mal; m; m = m->m_link)
+        if (m->m_start == (UBYTE *)s)
+        {
+            freeit(m, mp);
+            break;
+        }
+
+    KDEBUG(("BDOS dropslab: slab=%p\n",s));
+}
+
+
+/*
+ *  findslab - find the slab holding an address
+ *
+ *  returns NULL if the address is not within a slab
+ */
+static SLAB *findslab(UBYTE *addr, MEMORY_PARTITION_BLOCK *mp)
+{
+    SLABPOOL *pool = POOL(mp);
+    SLAB *s;
+
+    if ((addr < pool->sp_low) || (addr >= pool->sp_high))
+        return NULL;
+
+    s = (SLAB *)((ULONG)addr & ~(SC_SLABSIZE - 1));
+    if ((s->s_self != s) || (s->s_magic != (SLAB_MAGIC ^ (ULONG)s)))
+        return NULL;
+
+    return s;
+}
+
+
+/*
+ *  scalloc - allocate a small block
+ *
+ *  returns NULL if amount is larger than SC_MAXSIZE or if there is not
+ *  enough memory for a new slab
+ */
+void *scalloc(long amount, MEMORY_PARTITION_BLOCK *mp)
+{
+    SLABPOOL *pool = POOL(mp);
+    SLAB *s;
+    UBYTE *b;
+    WORD class;
+
+    if (amount > SC_MAXSIZE)
+        return NULL;
+
+    for (class = 0; (1L << (class + SC_MINSHIFT)) < amount; class++)
+        ;
+
+    s = pool->sp_avail[class];
+    if (!s)
+    {
+        s = newslab(class, mp);
+        if (!s)
+            return NULL;
+    }
+
+    b = s->s_free;
+    s->s_free = *(UBYTE **)b;
+    SLAB_OWN(s)[(b - s->s_first) >> s->s_shift] = run;
+    if (--s->s_nfree == 0)
+        pool->sp_avail[class] = s->s_next;  /* slab is full */
+
+    KDEBUG(("BDOS scalloc: amount=%ld, block=%p\n",amount,b));
+    return b;
+}
+
+
+/*
+ *  scowner - find the owner field of an allocated small block
+ *
+ *  returns NULL if addr is not in a slab, SC_NOTBLOCK if it is in a slab
+ *  but is not the start of an allocated block
+ */
+PD **scowner(void *addr, MEMORY_PARTITION_BLOCK *mp)
+{
+    SLAB *s;
+    ULONG offset;
+    PD **own;
+
+    s = findslab(addr, mp);
+    if (!s)
+        return NULL;
+
+    if ((UBYTE *)addr < s->s_first)     /* in the slab header */
+        return SC_NOTBLOCK;
+    offset = (UBYTE *)addr - s->s_first;
+    if (offset & ((1L << s->s_shift) - 1))
+        return SC_NOTBLOCK;
+
+    own = &SLAB_OWN(s)[offset >> s->s_shift];
+    if ((*own == NULL) || (*own == SC_RESERVED))
+        return SC_NOTBLOCK;
+
+    return own;
+}
+
+
+/*
+ *  scsize - return the size of the small block at addr
+ */
+LONG scsize(void *addr)
+{
+    SLAB *s = (SLAB *)((ULONG)addr & ~(SC_SLABSIZE - 1));
+
+    return 1L << s->s_shift;
+}
+
+
+/*
+ *  freeblk - put a small block back on its slab's free list
+ *
+ *  returns TRUE iff the slab is now empty
+ */
+static BOOL freeblk(SLAB *s, UBYTE *b, MEMORY_PARTITION_BLOCK *mp)
+{
+    SLABPOOL *pool = POOL(mp);
+
+    SLAB_OWN(s)[(b - s->s_first) >> s->s_shift] = NULL;
+    *(UBYTE **)b = s->s_free;
+    s->s_free = b;
+    if (s->s_nfree++ == 0)
+    {
+        /* slab was full, make its blocks available again */
+        s->s_next = pool->sp_avail[s->s_class];
+        pool->sp_avail[s->s_class] = s;
+    }
+
+    return s->s_nfree == s->s_nblocks;
+}
+
+
+/*
+ *  scfree - free a small block
+ *
+ *  addr must have been validated by scowner()
+ */
+void scfree(void *addr, MEMORY_PARTITION_BLOCK *mp)
+{
+    SLAB *s = (SLAB *)((ULONG)addr & ~(SC_SLABSIZE - 1));
+
+    KDEBUG(("BDOS scfree: block=%p\n",addr));
+
+    if (freeblk(s, addr, mp))
+    {
+        /* keep the slab if it's the only one of its class with free blocks */
+        if ((POOL(mp)->sp_avail[s->s_class] != s) || s->s_next)
+            dropslab(s, mp);
+    }
+}
+
+
+/*
+ *  scfreeall - free or reserve all the small blocks owned by a process
+ *
+ *  when 'reserve' is TRUE, the blocks remain permanently allocated (this
+ *  is used by Ptermres()).  when blocks are freed, all the slabs that
+ *  become empty are given back, so that the whole of the memory freed
+ *  by a terminating process can be reused by the next one.
+ */
+void scfreeall(PD *p, MEMORY_PARTITION_BLOCK *mp, BOOL reserve)
+{
+    SLAB *s, *next;
+    PD **own;
+    UWORD i;
+
+    for (s = POOL(mp)->sp_all; s; s = next)
+    {
+        next = s->s_link;
+        for (i = 0, own = SLAB_OWN(s); i < s->s_nblocks; i++, own++)
+        {
+            if (*own != p)
+                continue;
+            if (reserve)
+                *own = SC_RESERVED;
+            else
+                freeblk(s, s->s_first + ((ULONG)i << s->s_shift), mp);
+        }
+        if (!reserve && (s->s_nfree == s->s_nblocks))
+            dropslab(s, mp);
+    }
+}
+
+#endif /* CONF_WITH_BDOS_SIZE_CLASSES */
@@ -20,6 +20,8 @@
 #include "gemerror.h"
 #include "pghdr.h"
 #include "string.h"
+#include "mem.h"
+#include "has.h"
 
 
 /*
@@ -27,7 +29,197 @@
  */
 
 static LONG pgmld01(FH h, PD *pdptr, PGMHDR01 *hd);
-static LONG pgfix01(UBYTE *lastcp, LONG nrelbytes, PGMINFO *pi);
+static LONG pgfix01(UBYTE **cpp, const UBYTE *rp, LONG nrelbytes, UBYTE *bbase, LONG delta);
+static LONG pgminfo(PD *p, PGMHDR01 *hd, PGMINFO *pi);
+static void pgmclear(PD *p, PGMHDR01 *hd, PGMINFO *pi);
+
+
+#if CONF_WITH_PGMCACHE
+/*
+ * resident program image cache
+ *
+ * After a program has been loaded from disk, a copy of its relocated
+ * text & data segments, followed by its relocation info, is kept in
+ * Alt-RAM.  When the same file is loaded again, the image is copied
+ * from there: if the new TPA is at the same address, there is nothing
+ * else to do, otherwise the relocation info is replayed with the
+ * difference between the old & new addresses.
+ *
+ * Files are identified by drive, starting cluster, length and time/date.
+ * An entry is discarded when the file is written to, when its first
+ * cluster is freed, and on media change.  When there is not enough room,
+ * the least recently used entries are discarded.
+ */
+#define PGMCACHE_MAXSIZE    (CONF_PGMCACHE_KB*1024L)
+
+typedef struct
+{
+    UBYTE   *pc_image;      /* text+data, then relocation info; NULL => unused */
+    DMD     *pc_dmd;        /* the file: drive, */
+    CLNO    pc_strtcl;      /* starting cluster, */
+    LONG    pc_fileln;      /* length */
+    DOSTIME pc_td;          /* and time/date */
+    PGMHDR01 pc_hdr;        /* program header */
+    UBYTE   *pc_tbase;      /* address the image is relocated for */
+    LONG    pc_relst;       /* offset of the first fixup, 0 => none */
+    LONG    pc_rellen;      /* length of the relocation info */
+    UWORD   pc_age;         /* for LRU replacement */
+} PGMCACHE;
+
+static PGMCACHE pgmcache[CONF_PGMCACHE_PROGRAMS];
+static LONG pgmcache_used;  /* total size of the images */
+static UWORD pgmcache_clock;
+
+
+/*
+ * pgmcache_find - find the cache entry for an open file, or NULL
+ */
+static PGMCACHE *pgmcache_find(FH h)
+{
+    OFD *f;
+    DFD *d;
+    PGMCACHE *pc;
+
+    if (!(f = getofd(h)))
+        return NULL;
+    d = f->o_dfd;
+
+    for (pc = pgmcache; pc < pgmcache+CONF_PGMCACHE_PROGRAMS; pc++)
+    {
+        if (pc->pc_image && (pc->pc_dmd == f->o_dmd)
+         && (pc->pc_strtcl == d->o_strtcl) && (pc->pc_fileln == d->o_fileln)
+         && (pc->pc_td.time == d->o_td.time) && (pc->pc_td.date == d->o_td.date))
+        {
+            pc->pc_age = ++pgmcache_clock;
+            return pc;
+        }
+    }
+
+    return NULL;
+}
+
+
+/*
+ * pgmcache_drop - discard a cache entry
+ */
+static void pgmcache_drop(PGMCACHE *pc)
+{
+    KDEBUG(("BDOS pgmcache_drop: image=%p\n",pc->pc_image));
+    xmfree(pc->pc_image);
+    pgmcache_used -= pc->pc_hdr.h01_tlen + pc->pc_hdr.h01_dlen + pc->pc_rellen;
+    pc->pc_image = NULL;
+}
+
+
+/*
+ * pgmcache_invalidate - discard the entries for files starting at
+ * cluster 'strtcl' of the specified drive (or all its files if 0)
+ */
+void pgmcache_invalidate(DMD *dm, CLNO strtcl)
+{
+    PGMCACHE *pc;
+
+    for (pc = pgmcache; pc < pgmcache+CONF_PGMCACHE_PROGRAMS; pc++)
+        if (pc->pc_image && (pc->pc_dmd == dm) && (!strtcl || (pc->pc_strtcl == strtcl)))
+            pgmcache_drop(pc);
+}
+
+
+/*
+ * pgmcache_flush - discard all the entries, to make memory available
+ *
+ * returns TRUE iff any memory was freed
+ */
+BOOL pgmcache_flush(void)
+{
+    PGMCACHE *pc;
+    BOOL freed = FALSE;
+
+    for (pc = pgmcache; pc < pgmcache+CONF_PGMCACHE_PROGRAMS; pc++)
+    {
+        if (pc->pc_image)
+        {
+            pgmcache_drop(pc);
+            freed = TRUE;
+        }
+    }
+
+    return freed;
+}
+
+
+/*
+ * pgmcache_add - keep a copy of a program that has just been loaded
+ *
+ * the image is not cached if it is too large, or if there is not enough
+ * Alt-RAM for it
+ */
+static void pgmcache_add(FH h, PGMHDR01 *hd, PGMINFO *pi, LONG relst, LONG rellen)
+{
+    OFD *f;
+    PGMCACHE *pc, *victim;
+    MEMORY_DESCRIPTOR *m;
+    LONG flen, size;
+
+    if (!has_alt_ram || !(f = getofd(h)))
+        return;
+
+    flen = pi->pi_tlen + pi->pi_dlen;
+    size = flen + rellen;
+    if ((size == 0) || (size > PGMCACHE_MAXSIZE))
+        return;
+
+    /* find a free slot, discarding the least recently used entries */
+    for ( ; ; )
+    {
+        victim = NULL;
+        for (pc = pgmcache; pc < pgmcache+CONF_PGMCACHE_PROGRAMS; pc++)
+        {
+            if (!pc->pc_image)
+            {
+                if (pgmcache_used + size <= PGMCACHE_MAXSIZE)
+                {
+                    victim = pc;
+                    break;
+                }
+            }
+            else if (!victim || ((UWORD)(pgmcache_clock - pc->pc_age) > (UWORD)(pgmcache_clock - victim->pc_age)))
+                victim = pc;
+        }
+        if (!victim)            /* "can't happen" */
+            return;
+        if (!victim->pc_image)
+            break;
+        pgmcache_drop(victim);
+    }
+
+    /* take it from the top of Alt-RAM, away from where programs are loaded */
+    m = lfit(size, &pmdalt);
+    if (!m)
+        return;
+    m->m_own = NULL;
+
+    pc = victim;
+    pc->pc_image = m->m_start;
+    memcpy(pc->pc_image, pi->pi_tbase, flen);
+    memcpy(pc->pc_image+flen, pi->pi_bbase, rellen);
+    pgmcache_used += size;
+
+    pc->pc_dmd = f->o_dmd;
+    pc->pc_strtcl = f->o_dfd->o_strtcl;
+    pc->pc_fileln = f->o_dfd->o_fileln;
+    pc->pc_td = f->o_dfd->o_td;
+    pc->pc_hdr = *hd;
+    pc->pc_tbase = pi->pi_tbase;
+    pc->pc_relst = relst;
+    pc->pc_rellen = rellen;
+    pc->pc_age = ++pgmcache_clock;
+
+    KDEBUG(("BDOS pgmcache_add: image=%p, size=%ld\n",pc->pc_image,size));
+}
+
+static LONG pgmldcache(PGMCACHE *pc, PD *p, PGMHDR01 *hd);
+#endif /* CONF_WITH_PGMCACHE */
 
 /*
  * kpgmhdrld - load program header
@@ -42,6 +234,18 @@ LONG kpgmhdrld(FH h, PGMHDR01 *hd)
     LONG r;
     WORD magic;
 
+#if CONF_WITH_PGMCACHE
+    {
+        PGMCACHE *pc = pgmcache_find(h);
+
+        if (pc)
+        {
+            *hd = pc->pc_hdr;   /* no need to read the file */
+            return 0;
+        }
+    }
+#endif
+
     r = xread(h, 2L, &magic);   /* read magic number */
     if (r < 0L)
         return r;
@@ -80,7 +284,21 @@ LONG kpgmld(PD *p, FH h, PGMHDR01 *hd)
 {
     LONG r;
 
+#if CONF_WITH_PGMCACHE
+    PGMCACHE *pc = pgmcache_find(h);
+
+    if (pc)
+        r = pgmldcache(pc, p, hd);
+    else
+    {
+        /* the header may have come from an entry that has just gone */
+        r = xlseek(2+sizeof(PGMHDR01),h,0);
+        if (r >= 0L)
+            r = pgmld01(h, p, hd);
+    }
+#else
     r = pgmld01(h, p, hd);
+#endif
 
     KDEBUG(("BDOS pgmld01: return code=0x%lx\n",r));
 
@@ -90,6 +308,70 @@ LONG kpgmld(PD *p, FH h, PGMHDR01 *hd)
 
 extern long os_header;
 
+/*
+ * pgminfo - calculate program load info & initialise the PD fields
+ */
+static LONG pgminfo(PD *p, PGMHDR01 *hd, PGMINFO *pi)
+{
+    LONG flen;
+
+    pi->pi_tlen=hd->h01_tlen;
+    pi->pi_dlen=hd->h01_dlen;
+    flen = pi->pi_tlen + pi->pi_dlen;
+
+    pi->pi_blen = hd->h01_blen;
+    pi->pi_slen = hd->h01_slen;
+    pi->pi_tpalen = p->p_hitpa - p->p_lowtpa - sizeof(PD);
+    pi->pi_tbase = (UBYTE *) (p+1);     /*  1st byte after PD   */
+    pi->pi_bbase = pi->pi_tbase + flen;
+    pi->pi_dbase = pi->pi_tbase + pi->pi_tlen;
+
+
+    /*
+     * see if there is enough room to load in the file, then see if
+     * the requested bss space is larger than the space we have to offer
+     */
+
+    if ((flen > pi->pi_tpalen) || (pi->pi_tpalen-flen < pi->pi_blen))
+        return ENSMEM;
+
+    /* initialize PD fields */
+
+    memcpy(&p->p_tbase, &pi->pi_tbase, 6 * sizeof(long));
+
+    return 0;
+}
+
+/*
+ * pgmclear - clear the bss or the whole heap
+ */
+static void pgmclear(PD *p, PGMHDR01 *hd, PGMINFO *pi)
+{
+    LONG flen;
+
+    if (hd->h01_flags & PF_FASTLOAD)
+    {
+        flen =  pi->pi_blen;                            /* clear only the bss */
+    }
+#if CONF_PEXEC_HEAP_CLEAR_KB
+    else if ((long)p->p_hitpa - (long)pi->pi_bbase > pi->pi_blen + CONF_PEXEC_HEAP_CLEAR_KB*1024L)
+    {
+        flen = pi->pi_blen + CONF_PEXEC_HEAP_CLEAR_KB*1024L;   /* bss + guard zone */
+    }
+#endif
+    else
+    {
+        // FIXME: Dirty hack, when we directly upload the OS in RAM for debug purposes,
+        // we don't want it to be overwritten accidentaly when clearing the BSS.
+        // This should be improved somehow so we don't need this. We should see how emutos.prg
+        // is produce and how it's located in RAM and somehow do the same.
+        long maxtop = (long)(&os_header) < (long)p->p_hitpa ? (long)&os_header : (long)p->p_hitpa;
+        flen = maxtop - (long)pi->pi_bbase;   /* clear the whole heap */
+    }
+    if (flen > 0)
+        bzero(pi->pi_bbase, flen);
+}
+
 /*
  * pgmld01 - oldest known gemdos load format
  * It is very similar to cp/m 68k load in the (open) program file with
@@ -101,9 +383,10 @@ extern long os_header;
  *   it is a longword instead of a byte).
  * - make the first adjustment until we run out of relocation info or
  *   we have an error
- * - read in relocation info into the bss area
+ * - read in relocation info into the bss area, in one go if there is
+ *   enough room
  * - call pgfix01() to fix up the code using that info
- * - zero out the bss
+ * - zero out the bss (and the heap)
  */
 static LONG pgmld01(FH h, PD *pdptr, PGMHDR01 *hd)
 {
@@ -111,40 +394,23 @@ static LONG pgmld01(FH h, PD *pdptr, PGMHDR01 *hd)
     PD      *p;
     PGMINFO pinfo;
     UBYTE   *cp;
-    LONG    relst;
+    LONG    relst = 0;
     LONG    flen;
     LONG    r;
+#if CONF_WITH_PGMCACHE
+    LONG    rellen = 0L;    /* length of relocation info, -1 => don't cache */
+#endif
 
     pi = &pinfo;
     p = pdptr;
-    relst = 0;
 
     /* calculate program load info */
 
-    pi->pi_tlen=hd->h01_tlen;
-    pi->pi_dlen=hd->h01_dlen;
+    r = pgminfo(p, hd, pi);
+    if (r < 0)
+        return r;
     flen = pi->pi_tlen + pi->pi_dlen;
 
-    pi->pi_blen = hd->h01_blen;
-    pi->pi_slen = hd->h01_slen;
-    pi->pi_tpalen = p->p_hitpa - p->p_lowtpa - sizeof(PD);
-    pi->pi_tbase = (UBYTE *) (p+1);     /*  1st byte after PD   */
-    pi->pi_bbase = pi->pi_tbase + flen;
-    pi->pi_dbase = pi->pi_tbase + pi->pi_tlen;
-
-
-    /*
-     * see if there is enough room to load in the file, then see if
-     * the requested bss space is larger than the space we have to offer
-     */
-
-    if ((flen > pi->pi_tpalen) || (pi->pi_tpalen-flen < pi->pi_blen))
-        return ENSMEM;
-
-    /* initialize PD fields */
-
-    memcpy(&p->p_tbase, &pi->pi_tbase, 6 * sizeof(long));
-
     /*
      * read in the program file (text and data)
      */
@@ -197,87 +463,133 @@ static LONG pgmld01(FH h, PD *pdptr, PGMHDR01 *hd)
                     break;
 
                 /*  do fixups using that info  */
-                r = pgfix01(cp, r, pi);
+                r = pgfix01(&cp, pi->pi_bbase, r, pi->pi_bbase, (LONG)pi->pi_tbase);
                 if (r <= 0)
+                {
+#if CONF_WITH_PGMCACHE
+                    /* all the info was read at once: it ends with a zero byte */
+                    if ((r == 0) && (rellen == 0L))
+                    {
+                        for (cp = pi->pi_bbase; *cp; cp++)
+                            ;
+                        rellen = cp + 1 - pi->pi_bbase;
+                    }
+#endif
                     break;
+                }
+#if CONF_WITH_PGMCACHE
+                rellen = -1L;       /* info did not fit, don't cache */
+#endif
             }
 
             if (r < 0)                      /* M01.01.1023.01 */
                 return r;
         }
-
+        else
+        {
+#if CONF_WITH_PGMCACHE
+            /* the relocation info could not be read, don't cache the image */
+            if (r <= 0)
+                rellen = -1L;
+#endif
+            relst = 0;
+        }
     }
 
+#if CONF_WITH_PGMCACHE
+    if (rellen >= 0L)
+        pgmcache_add(h, hd, pi, relst, rellen);
+#endif
+
     /* clear the bss or the whole heap */
 
-    if (hd->h01_flags & PF_FASTLOAD)
-    {
-        flen =  pi->pi_blen;                            /* clear only the bss */
-    }
-    else
+    pgmclear(p, hd, pi);
+
+    return 0;
+}
+
+
+#if CONF_WITH_PGMCACHE
+/*
+ * pgmldcache - load a program from the cache
+ */
+static LONG pgmldcache(PGMCACHE *pc, PD *p, PGMHDR01 *hd)
+{
+    PGMINFO pinfo;
+    PGMINFO *pi = &pinfo;
+    UBYTE *cp;
+    LONG flen, delta, r;
+
+    r = pgminfo(p, hd, pi);
+    if (r < 0)
+        return r;
+    flen = pi->pi_tlen + pi->pi_dlen;
+
+    KDEBUG(("BDOS pgmldcache: image=%p, tbase=%p, cached for %p\n",
+            pc->pc_image,pi->pi_tbase,pc->pc_tbase));
+
+    memcpy(pi->pi_tbase, pc->pc_image, flen);
+
+    /* replay the relocation if the program is not at the same address */
+    delta = pi->pi_tbase - pc->pc_tbase;
+    if (pc->pc_relst && delta)
     {
-        // FIXME: Dirty hack, when we directly upload the OS in RAM for debug purposes,
-        // we don't want it to be overwritten accidentaly when clearing the BSS.
-        // This should be improved somehow so we don't need this. We should see how emutos.prg
-        // is produce and how it's located in RAM and somehow do the same.
-        long maxtop = (long)(&os_header) < (long)p->p_hitpa ? (long)&os_header : (long)p->p_hitpa;
-        flen = maxtop - (long)pi->pi_bbase;   /* clear the whole heap */
+        cp = pi->pi_tbase + pc->pc_relst;
+        *((long *)(cp)) += delta;               /*  1st fixup     */
+        pgfix01(&cp, pc->pc_image+flen, pc->pc_rellen, pi->pi_bbase, delta);
     }
-    if (flen > 0)
-        bzero(pi->pi_bbase, flen);
+
+    pgmclear(p, hd, pi);
 
     return 0;
 }
+#endif
 
 
 /*
  * pgfix01 - do the next set of fixups
  *
  *  returns:
- *      addr of last modified longword in code segment (cp)
- *      0 if error or done
- *      stat01:
- *              >0: all offsets in bss used up, read in more
- *              =0: offset of 0 encountered, no more fixups
- *              <0: EPLFMT (load file format error)
+ *      >0: all offsets in bss used up, read in more
+ *      =0: offset of 0 encountered, no more fixups
+ *      <0: EPLFMT (load file format error)
  *
  * Arguments:
+ *  cpp       - ptr to addr of last modified longword in code segment,
+ *              updated so that fixups can resume after the next read
+ *  rp        - relocation info
  *  nrelbytes - number of avail rel values
- *  pi        - program info pointer
+ *  bbase     - base addr of bss segment (end of the area to fix up)
+ *  delta     - value to add to each longword
  */
 
-static LONG pgfix01(UBYTE *lastcp, LONG nrelbytes, PGMINFO *pi)
+static LONG pgfix01(UBYTE **cpp, const UBYTE *rp, LONG nrelbytes, UBYTE *bbase, LONG delta)
 {
     UBYTE *cp;              /*  code pointer                */
-    UBYTE *rp;              /*  relocation info pointer     */
-    LONG  n;                /*  nbr of relocation bytes     */
-    UBYTE *bbase;           /*  base addr of bss segment    */
-    LONG  tbase;            /*  base addr of text segment   */
-
-    cp = lastcp;
-    rp = pi->pi_bbase;
-    n = nrelbytes;
-    tbase = (LONG)pi->pi_tbase;
-    bbase = pi->pi_bbase;
-
-    while(n-- && (*rp != 0))
+    const UBYTE *rend;      /*  end of relocation info      */
+    UBYTE offset;
+
+    cp = *cpp;
+    rend = rp + nrelbytes;
+
+    while (rp < rend)
     {
-        if (*rp == 1)
-            cp += 0xfe;
-        else
+        offset = *rp++;
+        if (offset > 1)     /* the usual case: fix up a longword */
         {
-            cp += *rp;  /* add the byte at rp to cp, don't sign ext */
-
-            if (cp >= bbase)
+            cp += offset;   /* don't sign ext */
+            if ((cp >= bbase) || (((LONG)cp) & 1))
                 return EPLFMT;
-            if (((LONG)cp) & 1)
-                return EPLFMT;
-            *((long *)cp) += tbase;
+            *((long *)cp) += delta;
         }
-        ++rp;
+        else if (offset == 1)
+            cp += 0xfe;
+        else return 0;      /* end of relocation info */
     }
 
-    return (++n == 0) ? 1 : 0;
+    *cpp = cp;
+
+    return 1;
 }
 
 
@@ -352,7 +664,7 @@ LONG kpgm_relocate(PD *p, long length)
             memmove(pi->pi_bbase, rp, length);
 
             /* fixup with the reloc information available */
-            pgfix01(cp, length, pi);
+            pgfix01(&cp, pi->pi_bbase, length, pi->pi_bbase, (LONG)pi->pi_tbase);
         }
     }
 
@@ -80,6 +80,11 @@ void umem_init(void);
 /* set memory ownership */
 void set_owner(void *addr, PD *p);
 
+#if CONF_WITH_BDOS_FREEMAP || CONF_WITH_BDOS_OSMEM_GROWTH || CONF_WITH_BDOS_DIRHASH
+/* allocate memory owned by the BDOS itself */
+void *xmalloc_os(long amount);
+#endif
+
 
 /*
  * in iumem.c
@@ -87,10 +92,31 @@ void set_owner(void *addr, PD *p);
 
 /* find first fit for requested memory in ospool */
 MEMORY_DESCRIPTOR *ffit(long amount, MEMORY_PARTITION_BLOCK *mp);
+#if CONF_WITH_BDOS_FREEMAP || CONF_WITH_BDOS_OSMEM_GROWTH || CONF_WITH_BDOS_DIRHASH || CONF_WITH_PGMCACHE
+/* allocate requested memory from the top of ospool */
+MEMORY_DESCRIPTOR *lfit(long amount, MEMORY_PARTITION_BLOCK *mp);
+#endif
 /* Free up a memory descriptor */
 void freeit(MEMORY_DESCRIPTOR *m, MEMORY_PARTITION_BLOCK *mp);
 /* shrink a memory descriptor */
 WORD shrinkit(MEMORY_DESCRIPTOR *m, MEMORY_PARTITION_BLOCK *mp, LONG newlen);
 
+#if CONF_WITH_BDOS_SIZE_CLASSES
+#define SC_NCLASSES     5       /* size classes: 16, 32, 64, 128, 256 bytes */
+#define SC_MAXSIZE      256L    /* largest request served by size classes */
+#define SC_NOTBLOCK     ((PD **)1L) /* returned by scowner() for invalid blocks */
+
+/* allocate a small block */
+void *scalloc(long amount, MEMORY_PARTITION_BLOCK *mp);
+/* find the owner of a small block */
+PD **scowner(void *addr, MEMORY_PARTITION_BLOCK *mp);
+/* get the size of a small block */
+LONG scsize(void *addr);
+/* free a small block */
+void scfree(void *addr, MEMORY_PARTITION_BLOCK *mp);
+/* free or reserve all the small blocks owned by a process */
+void scfreeall(PD *p, MEMORY_PARTITION_BLOCK *mp, BOOL reserve);
+#endif
+
 
 #endif /* MEM_H */
@@ -29,6 +29,7 @@
 #include "mem.h"
 #include "bdosstub.h"
 #include "biosext.h"
+#include "string.h"
 
 /*
  *  local constants
@@ -38,6 +39,11 @@
 /* size of os memory pool, in words: */
 #define LENOSM          (LEN_OSM_BLOCK*NUM_OSM_BLOCKS/sizeof(WORD))
 
+#if CONF_WITH_BDOS_OSMEM_GROWTH
+#define OSM_CHUNK_BLOCKS    32      /* blocks added each time the pool grows */
+#define OSM_RESERVE         (2*LEN_OSM_BLOCK/sizeof(WORD))  /* words kept for growing */
+#endif
+
 
 /*
  *  local typedefs
@@ -59,10 +65,15 @@ struct _mdb {
 /*
  *  internal variables
  */
-static WORD osmptr;
+static WORD *osmptr;
 static WORD osmlen;
 static WORD osmem[LENOSM];
 
+#if CONF_WITH_BDOS_OSMEM_GROWTH
+static OSMSTATS osmstats;   /* pointed to by etstats.es_osmem */
+static BOOL osm_growing;    /* TRUE while osm_grow() is getting memory */
+#endif
+
 
 /*
  *  root - root array for 'quick' pool
@@ -108,13 +119,60 @@ static WORD *getosm(WORD n)
         return 0;
     }
 
-    m = &osmem[osmptr];         /*  start at base               */
+    m = osmptr;                 /*  start at base               */
     osmptr += n;                /*  new base                    */
     osmlen -= n;                /*  new length of free block    */
     return m;                   /*  allocated memory            */
 }
 
 
+#if CONF_WITH_BDOS_OSMEM_GROWTH
+/*
+ * osm_grow - add a chunk of user memory to the o/s memory pool
+ *
+ * The chunk is obtained via xmalloc_os(), i.e. preferably from Alt-RAM,
+ * and is never given back.  What remains of the current pool is first
+ * moved to the free chain, so that it is not lost.
+ *
+ * This is called while the pool still holds a couple of blocks, since
+ * allocating the chunk may itself require a new MDBLOCK.
+ *
+ * returns -1 iff no memory is available
+ */
+static WORD osm_grow(void)
+{
+    WORD *m;
+
+    if (osm_growing)
+        return -1;
+
+    osm_growing = TRUE;
+    m = xmalloc_os(OSM_CHUNK_BLOCKS*LEN_OSM_BLOCK);
+    osm_growing = FALSE;
+    if (!m)
+    {
+        KDEBUG(("osm_grow(): no memory\n"));
+        return -1;
+    }
+
+    while (osmlen >= LEN_OSM_BLOCK/sizeof(WORD))
+    {
+        WORD *b = getosm(LEN_OSM_BLOCK/sizeof(WORD));
+        *b++ = 4;                   /* put size in control word */
+        *((WORD **) b) = root[4];
+        root[4] = b;
+    }
+
+    osmptr = m;
+    osmlen = OSM_CHUNK_BLOCKS*LEN_OSM_BLOCK/sizeof(WORD);
+    osmstats.os_chunks++;
+    KDEBUG(("osm_grow(): added %d blocks at %p\n",OSM_CHUNK_BLOCKS,m));
+
+    return 0;
+}
+#endif
+
+
 /*
  *  unlink_mdblock - unlinks an MDBLOCK from the mdb chain
  *
@@ -317,6 +375,13 @@ void *xmgetblk(WORD memtype)
             break;
         }
 
+#if CONF_WITH_BDOS_OSMEM_GROWTH
+        /* pool nearly exhausted: try to grow it before it's too late */
+        if (osmlen < OSM_RESERVE)
+            if (osm_grow() == 0)
+                continue;
+#endif
+
         /* nothing on free list, try pool */
         if ( (m = getosm(w+1)) )    /* include size of control word */
         {
@@ -326,7 +391,12 @@ void *xmgetblk(WORD memtype)
 
         /* no memory available for an MDBLOCK, that's (sort of) OK */
         if (memtype == MEMTYPE_MDBLOCK)
+        {
+#if CONF_WITH_BDOS_OSMEM_GROWTH
+            osmstats.os_failures++;
+#endif
             break;
+        }
 
         /*
          * no memory for DMD/DND/OFD, try to get some
@@ -335,6 +405,9 @@ void *xmgetblk(WORD memtype)
          * worked, but we're here again, then it lied and we should quit
          * to avoid an infinite loop
          */
+#if CONF_WITH_BDOS_OSMEM_GROWTH
+        osmstats.os_reclaims++;
+#endif
         if ((j >= 2) || (free_available_dnds() == 0))
         {
             kcprintf(_("\033EOut of internal memory.\nUse FOLDR100.PRG to get more.\nSystem halted!\n"));
@@ -350,6 +423,16 @@ void *xmgetblk(WORD memtype)
         for (j = 0; j < w; j++)
             *q++ = 0;
 
+#if CONF_WITH_BDOS_OSMEM_GROWTH
+    /* remember the type in the control word, for the statistics */
+    if (m)
+    {
+        m[-1] = i | (memtype << 8);
+        if (++osmstats.os_inuse[memtype] > osmstats.os_peak[memtype])
+            osmstats.os_peak[memtype] = osmstats.os_inuse[memtype];
+    }
+#endif
+
     return m;
 }
 
@@ -363,6 +446,14 @@ void xmfreblk(void *m)
 
     i = *(((WORD *)m) - 1);
 
+#if CONF_WITH_BDOS_OSMEM_GROWTH
+    if ((i & 0xff) == 4)
+    {
+        osmstats.os_inuse[i>>8]--;
+        i = 4;
+    }
+#endif
+
     if (i != 4)
     {
         /*  bad index  */
@@ -389,9 +480,18 @@ void xmfreblk(void *m)
  */
 void osmem_init(void)
 {
+    osmptr = osmem;
     osmlen = LENOSM;
     mdbroot = NULL;
     dbgfreblk = 0;
     dbggtosm = 0;
     dbggtblk = 0;
+
+#if CONF_WITH_BDOS_OSMEM_GROWTH
+    bzero(&osmstats, sizeof(osmstats));
+    osmstats.os_pool = NUM_OSM_BLOCKS;
+    osmstats.os_chunksize = OSM_CHUNK_BLOCKS;
+    osm_growing = FALSE;
+    etstats.es_osmem = &osmstats;
+#endif
 }
@@ -78,6 +78,10 @@ static void reserve_blocks(PD *p, MEMORY_PARTITION_BLOCK *mpb)
 {
     MEMORY_DESCRIPTOR *m, **q;
 
+#if CONF_WITH_BDOS_SIZE_CLASSES
+    scfreeall(p, mpb, TRUE);
+#endif
+
     for (m = *(q = &mpb->mp_mal); m; m = *q) {
         if (m->m_own == p) {
             *q = m->m_link; /* pouf ! like magic */
@@ -93,6 +97,10 @@ static void free_all_owned(PD *p, MEMORY_PARTITION_BLOCK *mpb)
 {
     MEMORY_DESCRIPTOR *m, *next;
 
+#if CONF_WITH_BDOS_SIZE_CLASSES
+    scfreeall(p, mpb, FALSE);
+#endif
+
     for (m = mpb->mp_mal; m; m = next) {
         next = m->m_link;
         if (m->m_own == p)
@@ -290,6 +298,11 @@ long xexec(WORD flag, char *path, char *tail, char *env)
     /* allocate the basepage depending on memory policy */
     needed = hdr.h01_tlen + hdr.h01_dlen + hdr.h01_blen + sizeof(PD);
     p = (PD *)alloc_tpa(hdr.h01_flags,needed,&max);
+#if CONF_WITH_PGMCACHE
+    /* cached program images may be taking up the memory we need */
+    if ((p == NULL) && pgmcache_flush())
+        p = (PD *)alloc_tpa(hdr.h01_flags,needed,&max);
+#endif
 
     /* if failed, free env_ptr and return */
     if (p == NULL) {
@@ -145,6 +145,20 @@ long xmfree(void *addr)
 
     KDEBUG(("BDOS Mfree: mpb=%s\n",(mpb==&pmd)?"pmd":"pmdalt"));
 
+#if CONF_WITH_BDOS_SIZE_CLASSES
+    {
+        PD **own = scowner(addr,mpb);
+
+        if (own == SC_NOTBLOCK)
+            return EIMBA;
+        if (own)
+        {
+            scfree(addr,mpb);
+            return E_OK;
+        }
+    }
+#endif
+
     for (p = mpb->mp_mal; p; p = p->m_link)
         if (addr == p->m_start)
             break;
@@ -180,6 +194,27 @@ long xsetblk(int n, void *blk, long len)
 
     KDEBUG(("BDOS Mshrink: mpb=%s\n",(mpb==&pmd)?"pmd":"pmdalt"));
 
+#if CONF_WITH_BDOS_SIZE_CLASSES
+    /*
+     * A small block keeps its size class: there is nothing to do unless
+     * it is shrunk to nothing.
+     */
+    {
+        PD **own = scowner(blk,mpb);
+
+        if (own == SC_NOTBLOCK)
+            return EIMBA;
+        if (own)
+        {
+            if (len > scsize(blk))
+                return EGSBF;
+            if (len == 0)
+                scfree(blk,mpb);
+            return E_OK;
+        }
+    }
+#endif
+
     /*
      * Traverse the list of memory descriptors looking for this block.
      */
@@ -228,12 +263,38 @@ long xsetblk(int n, void *blk, long len)
     return E_OK;
 }
 
+/*
+ * allocate a block from the specified partition
+ *
+ * returns the start of the block, or NULL if not enough memory
+ */
+static void *getblk(long amount, MEMORY_PARTITION_BLOCK *mp)
+{
+    MEMORY_DESCRIPTOR *m;
+
+#if CONF_WITH_BDOS_SIZE_CLASSES
+    if (amount <= SC_MAXSIZE)
+    {
+        void *blk = scalloc(amount,mp);
+        if (blk)
+            return blk;
+    }
+#endif
+
+    m = ffit(amount,mp);
+#if CONF_WITH_PGMCACHE
+    if (!m && (mp == &pmdalt) && pgmcache_flush())
+        m = ffit(amount,mp);
+#endif
+
+    return m ? m->m_start : NULL;
+}
+
 /*
  *  xmxalloc - Function 0x44 (Mxalloc)
  */
 void *xmxalloc(long amount, int mode)
 {
-    MEMORY_DESCRIPTOR *m;
     void *ret_value;
 
     KDEBUG(("BDOS: Mxalloc(%ld,0x%04x)\n",amount,mode));
@@ -291,40 +352,30 @@ void *xmxalloc(long amount, int mode)
      */
     switch(mode) {
     case MX_STRAM:
-        m = ffit(amount,&pmd);
+        ret_value = getblk(amount,&pmd);
         break;
 #if CONF_WITH_ALT_RAM
     case MX_TTRAM:
-        m = ffit(amount,&pmdalt);
+        ret_value = getblk(amount,&pmdalt);
         break;
 #endif
     case MX_PREFSTRAM:
-        m = ffit(amount,&pmd);
+        ret_value = getblk(amount,&pmd);
 #if CONF_WITH_ALT_RAM
-        if (m == NULL)
-            m = ffit(amount,&pmdalt);
+        if (ret_value == NULL)
+            ret_value = getblk(amount,&pmdalt);
 #endif
         break;
     case MX_PREFTTRAM:
 #if CONF_WITH_ALT_RAM
-        m = ffit(amount,&pmdalt);
-        if (m == NULL)
+        ret_value = getblk(amount,&pmdalt);
+        if (ret_value == NULL)
 #endif
-            m = ffit(amount,&pmd);
+            ret_value = getblk(amount,&pmd);
         break;
     default:
         /* unknown mode */
-        m = NULL;
-    }
-
-    /*
-     * The internal routine returned a pointer to a memory descriptor, or NULL
-     * Return its pointer to the start of the block.
-     */
-    if (m == NULL) {
         ret_value = NULL;
-    } else {
-        ret_value = m->m_start;
     }
 
 ret:
@@ -587,6 +638,39 @@ void umem_init(void)
     }
 }
 
+#if CONF_WITH_BDOS_FREEMAP || CONF_WITH_BDOS_OSMEM_GROWTH || CONF_WITH_BDOS_DIRHASH
+/*
+ * xmalloc_os - allocate memory for the BDOS's own use
+ *
+ * the block is not owned by any process, so it is not freed when the
+ * current process terminates; it must be freed explicitly via xmfree().
+ * Alt-RAM is used in preference to ST-RAM, and the block is taken from
+ * the top of the pool, so that it does not fragment the memory in which
+ * programs are loaded.
+ *
+ * returns NULL if there is not enough memory
+ */
+void *xmalloc_os(long amount)
+{
+    MEMORY_DESCRIPTOR *m = NULL;
+
+#if CONF_WITH_ALT_RAM
+    if (has_alt_ram)
+        m = lfit(amount, &pmdalt);
+#endif
+    if (!m)
+        m = lfit(amount, &pmd);
+    if (!m)
+        return NULL;
+
+    m->m_own = NULL;
+    KDEBUG(("BDOS: xmalloc_os(%ld): rc=%p\n",amount,m->m_start));
+
+    return m->m_start;
+}
+#endif
+
+
 /*
  * change the memory owner based on the block address
  */
@@ -600,6 +684,20 @@ void set_owner(void *addr, PD *p)
     if (!mpb)       /* block address was invalid */
         return;
 
+#if CONF_WITH_BDOS_SIZE_CLASSES
+    {
+        PD **own = scowner(addr,mpb);
+
+        if (own == SC_NOTBLOCK)
+            return;
+        if (own)
+        {
+            *own = p;
+            return;
+        }
+    }
+#endif
+
     for (m = mpb->mp_mal; m; m = m->m_link) {
         if (m->m_start == (UBYTE *)addr) {
             m->m_own = p;
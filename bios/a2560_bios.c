@@ -45,10 +45,8 @@
 #include "has.h"
 #include "../bdos/bdosstub.h"
 #include "screen.h"
-#include "serport.h" // push_serial_iorec
 #include "stdint.h"
 #include "../foenix/foenix.h"
-#include "../foenix/uart16550.h" /* Serial port */
 #include "../foenix/a2560.h"
 #include "../foenix/interrupts.h"
 #include "../foenix/mpu401.h"
@@ -121,97 +119,6 @@ void a2560_bios_vgetrgb(int16_t index,int16_t count,uint32_t *rgb) {
 
 
 
-/* Serial port ***************************************************************/
-
-uint32_t a2560_bios_bcostat1(void)
-{
-    return uart16550_can_put((UART16550*)UART1);
-}
-
-void a2560_bios_bconout1(uint8_t byte)
-{
-    uart16550_put((UART16550*)UART1,&byte, 1);
-	uart16550_put((UART16550*)UART2,&byte, 1);
-}
-
-void a2560_irq_com1(void); // Event handler in a2560_s.S
-
-void a2560_bios_rs232_init(void) {
-    a2560_debugnl("a2560_bios_rs232_init");
-    // The UART's base settings are setup earlier
-    uart16550_rx_handler = push_serial_iorec;
-    setexc(INT_COM1_VECN, (uint32_t)a2560_irq_com1);
-    a2560_irq_enable(INT_COM1);
-    uart16550_rx_irq_enable((UART16550*)UART1, true);
-}
-
-/* This does not perfectly emulate the MFP but may enough */
-uint32_t a2560_bios_rsconf1(int16_t baud_code, EXT_IOREC *iorec, int16_t ctrl, int16_t ucr, int16_t rsr, int16_t tsr, int16_t scr)
-{
-    static const int16_t baud_codes[] = {
-        UART16550_19200BPS, UART16550_9600BPS, UART16550_4800BPS, UART16550_3600BPS,
-        UART16550_2400BPS, UART16550_2000BPS, UART16550_1800BPS, UART16550_1200BPS,
-        UART16550_600BPS, UART16550_300BPS, UART16550_200BPS, UART16550_150BPS,
-        // This is not TOS compliant but we need to be able to use higher speeds than 19200bps...
-        // 12               13                  14                   15
-        UART16550_38400BPS, UART16550_57600BPS, UART16550_115200BPS, UART16550_230400BPS
-    };
-    // Note that 230400bps is not currently supported because it requires setting the "High Speed"
-    // bit of the SuperIO and I'm not sure how to do that
-
-    static const uint8_t dsize[] = {
-        UART16550_8D, UART16550_7D, UART16550_6D, UART16550_5D
-    };
-    uint8_t flags;
-    uint8_t data_size;
-    uint8_t data_format;
-
-    if (baud_code == -2)
-    {
-        return iorec->baudrate;
-    }
-    else if (baud_code >= 0) {
-        if (baud_code > ARRAY_SIZE(baud_codes)) {
-            KDEBUG(("a2560_bios_rsconf1 setting invalid baud specification %d\n", baud_code));
-        }
-        else {
-            KDEBUG(("[DISABLED] a2560_bios_rsconf1 setting speed %d bps (code: %d)\n", baud_codes[baud_code], baud_code));
-            uart16550_set_bps((UART16550*)UART1, baud_codes[baud_code]);
-            iorec->baudrate = baud_code;
-        }
-    }
-
-    flags = 0;
-    data_size = dsize[(ucr & 0x60) >> 5];
-    data_format = (ucr & 0x18) >> 3;
-
-    if (ucr != -1)
-    {
-        // Parity
-        if (ucr & 2)
-            flags |= ucr & 1 ? UART16550_ODD : UART16550_EVEN;
-        // Data size
-        flags |= data_size;
-        // Stop bits
-        if (data_size != UART16550_5D)
-        {
-            if (data_format == 3/* 1 start 2 stops*/)
-                flags |= UART16550_2S;
-        }
-        else if (data_format == 2/* 1 start 1.5 stop */)
-                flags |= UART16550_1_5S;
-
-        uart16550_set_line((UART16550*)UART1, flags);
-        KDEBUG(("a2560_bios_rsconf1 setting flags %x\n", flags));
-    }
-
-
-    // RTS/CTS and XON/XOFF not supported ! A2560U doesn't have RTS/CTS pins connected anyway
-    // TODO for machines having SuperIO
-    return 0L; // TODO.
-}
-
-
 /* Timers *********************************************************************/
 
 /* For being able to translate settings of the ST's MFP68901 we need this */
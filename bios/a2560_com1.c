@@ -0,0 +1,352 @@
+/*
+ * a2560_com1 - Serial port of the Foenix machines
+ *
+ * Copyright (C) 2013-2026 The EmuTOS development team
+ *
+ * Authors:
+ *  VB   Vincent Barrilliot
+ *
+ * This file is distributed under the GPL, version 2 or at your
+ * option any later version.  See doc/license.txt for details.
+ *
+ * This only talks to the UART through the uart16550 driver, so that it can
+ * be tested on the host with tools/com1loop.c.
+ */
+
+#define ENABLE_KDEBUG
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "emutos.h"
+
+#if defined(MACHINE_FOENIX)
+
+#include "bios.h"
+#include "asm.h"
+#include "serport.h" // push_serial_iorec
+#include "../foenix/foenix.h"
+#include "../foenix/uart16550.h"
+#include "../foenix/superio.h"
+#include "../foenix/a2560.h"
+#include "../foenix/a2560_debug.h"
+#include "../foenix/interrupts.h"
+#include "a2560_bios.h"
+
+
+#define COM1 ((UART16550*)UART1)
+
+#define XON  0x11
+#define XOFF 0x13
+
+/* Output goes through the transmit IOREC, which is drained by the "transmit
+ * FIFO empty" interrupt, up to UART16550_FIFO_SIZE bytes at a time. Until
+ * that is set up, and when the caller has masked all interrupts (e.g. panic),
+ * bytes are sent by polling.
+ * Flow control is driven by the water marks of the receive IOREC: when it
+ * fills up to the high mark, RTS is dropped and/or XOFF is sent; when it is
+ * emptied down to the low mark, RTS is raised and/or XON is sent. */
+static EXT_IOREC *com1_iorec; /* NULL until interrupt-driven I/O is enabled */
+static uint8_t com1_flow;     /* Flow control state */
+#define COM1_RX_STOPPED 1     /* We asked the other end to stop sending */
+#define COM1_TX_STOPPED 2     /* The other end sent XOFF */
+static uint8_t com1_xchar;    /* XON/XOFF waiting to be sent, or 0 */
+
+static WORD iorec_used(const IOREC *iorec)
+{
+    WORD used = iorec->tail - iorec->head;
+
+    return used < 0 ? used + iorec->size : used;
+}
+
+static bool iorec_full(const IOREC *iorec)
+{
+    return iorec_used(iorec) >= iorec->size - 1;
+}
+
+/* Move up to 'max' bytes from the IOREC to the FIFO */
+static void com1_fill_fifo(IOREC *out, int max)
+{
+    WORD head = out->head;
+
+    while (max-- > 0 && head != out->tail) {
+        uart16550_put_nowait(COM1, out->buf[head]);
+        if (++head >= out->size)
+            head = 0;
+    }
+    out->head = head;
+}
+
+/* Whether flow control allows us to send data */
+static bool com1_may_send(void)
+{
+    if (com1_flow & COM1_TX_STOPPED)
+        return false;
+    if ((com1_iorec->flowctrl & FLOW_CTRL_HARD) && !uart16550_cts(COM1))
+        return false;
+    return true;
+}
+
+/* Send what can be sent now, and ask for an interrupt when the FIFO is empty
+ * if there's more to send. Interrupts must be masked. */
+static void com1_start_tx(void)
+{
+    IOREC *out = &com1_iorec->out;
+    bool may_send = com1_may_send();
+    int room;
+
+    if (uart16550_can_put(COM1)) {
+        room = UART16550_FIFO_SIZE;
+        if (com1_xchar) {
+            uart16550_put_nowait(COM1, com1_xchar);
+            com1_xchar = 0;
+            room--;
+        }
+        if (may_send)
+            com1_fill_fifo(out, room);
+    }
+
+    /* If CTS is what stops us, the modem status interrupt will restart us */
+    uart16550_tx_irq_enable(COM1, com1_xchar || (may_send && out->head != out->tail));
+}
+
+/* Ask the other end to stop or resume sending. Interrupts must be masked. */
+static void com1_throttle(bool stop)
+{
+    if (stop)
+        com1_flow |= COM1_RX_STOPPED;
+    else
+        com1_flow &= ~COM1_RX_STOPPED;
+
+    if (com1_iorec->flowctrl & FLOW_CTRL_HARD)
+        uart16550_set_rts(COM1, !stop);
+    if (com1_iorec->flowctrl & FLOW_CTRL_SOFT) {
+        com1_xchar = stop ? XOFF : XON;
+        com1_start_tx();
+    }
+}
+
+/* Called by a2560_irq_com1 for each byte received */
+static void com1_rx(uint8_t byte)
+{
+    EXT_IOREC *iorec = com1_iorec;
+
+    if (iorec->flowctrl & FLOW_CTRL_SOFT) {
+        if (byte == XOFF) {
+            com1_flow |= COM1_TX_STOPPED;
+            return;
+        }
+        if (byte == XON) {
+            com1_flow &= ~COM1_TX_STOPPED;
+            com1_start_tx();
+            return;
+        }
+    }
+
+    push_serial_iorec(byte);
+
+    if (!(com1_flow & COM1_RX_STOPPED) && (iorec->flowctrl != FLOW_CTRL_NONE)
+        && iorec_used(&iorec->in) >= iorec->in.high)
+        com1_throttle(true);
+}
+
+/* Called by a2560_irq_com1 once there's nothing more to receive. This handles
+ * both the "transmit FIFO empty" and the modem status (CTS) interrupts. */
+void a2560_bios_com1_tx_interrupt(void)
+{
+    if (com1_iorec)
+        com1_start_tx();
+    else
+        uart16550_tx_irq_enable(COM1, false);
+}
+
+/* Called after a byte has been taken from the receive IOREC */
+void a2560_bios_com1_rx_drained(void)
+{
+    EXT_IOREC *iorec = com1_iorec;
+    WORD old_sr;
+
+    if (iorec && (com1_flow & COM1_RX_STOPPED) && iorec_used(&iorec->in) <= iorec->in.low) {
+        old_sr = set_sr(0x2700);
+        com1_throttle(false);
+        set_sr(old_sr);
+    }
+}
+
+/* Apply the flow control mode set in the IOREC */
+static void com1_set_flow(void)
+{
+    WORD old_sr;
+
+    old_sr = set_sr(0x2700);
+    com1_flow = 0;
+    com1_xchar = 0;
+    uart16550_set_rts(COM1, true);
+    uart16550_modem_irq_enable(COM1, com1_iorec->flowctrl & FLOW_CTRL_HARD);
+    com1_start_tx();
+    set_sr(old_sr);
+}
+
+uint32_t a2560_bios_bcostat1(void)
+{
+    IOREC *out;
+    WORD old_sr;
+
+    if (!com1_iorec)
+        return uart16550_can_put(COM1);
+
+    /* If the buffer is full, maybe that's because our caller has masked the
+     * interrupt, so we service the UART ourselves. */
+    out = &com1_iorec->out;
+    if (iorec_full(out) && uart16550_can_put(COM1)) {
+        old_sr = set_sr(0x2700);
+        com1_start_tx();
+        set_sr(old_sr);
+    }
+
+    return iorec_full(out) ? 0 : -1;
+}
+
+/* The caller must make sure that a2560_bios_bcostat1() is true */
+void a2560_bios_bconout1(uint8_t byte)
+{
+    IOREC *out;
+    WORD old_sr;
+
+    if (!com1_iorec) {
+        uart16550_put(COM1, &byte, 1);
+        return;
+    }
+
+    out = &com1_iorec->out;
+    old_sr = set_sr(0x2700);
+
+    out->buf[out->tail] = byte;
+    if (++out->tail >= out->size)
+        out->tail = 0;
+
+    if ((old_sr & 0x0700) == 0x0700) {
+        /* Interrupts were masked: send everything now, in order, regardless
+         * of flow control as we couldn't see it change anyway. */
+        while (out->head != out->tail) {
+            while (!uart16550_can_put(COM1))
+                ;
+            com1_fill_fifo(out, UART16550_FIFO_SIZE);
+        }
+    } else
+        com1_start_tx();
+
+    set_sr(old_sr);
+}
+
+/* Send a whole buffer, queuing as much of it as fits at a time */
+void a2560_bios_bconout1_run(const uint8_t *buf, LONG count)
+{
+    IOREC *out;
+    WORD n, old_sr;
+
+    if (!com1_iorec) {
+        uart16550_put(COM1, buf, count);
+        return;
+    }
+
+    out = &com1_iorec->out;
+    while (count > 0) {
+        while (!a2560_bios_bcostat1())
+            ;
+        n = iorec_write(out, buf, count < out->size ? count : out->size);
+        buf += n;
+        count -= n;
+
+        old_sr = set_sr(0x2700);
+        com1_start_tx();
+        set_sr(old_sr);
+    }
+}
+
+void a2560_irq_com1(void); // Event handler in a2560_s.S
+
+void a2560_bios_rs232_init(EXT_IOREC *iorec) {
+    a2560_debugnl("a2560_bios_rs232_init");
+    // The UART's base settings are setup earlier
+    com1_iorec = iorec;
+    uart16550_rx_handler = com1_rx;
+    setexc(INT_COM1_VECN, (uint32_t)a2560_irq_com1);
+    a2560_irq_enable(INT_COM1);
+    uart16550_rx_irq_enable(COM1, true);
+    com1_set_flow();
+}
+
+/* This does not perfectly emulate the MFP but may enough */
+uint32_t a2560_bios_rsconf1(int16_t baud_code, EXT_IOREC *iorec, int16_t ctrl, int16_t ucr, int16_t rsr, int16_t tsr, int16_t scr)
+{
+    static const uint16_t baud_codes[] = {
+        UART16550_19200BPS, UART16550_9600BPS, UART16550_4800BPS, UART16550_3600BPS,
+        UART16550_2400BPS, UART16550_2000BPS, UART16550_1800BPS, UART16550_1200BPS,
+        UART16550_600BPS, UART16550_300BPS, UART16550_200BPS, UART16550_150BPS,
+        // This is not TOS compliant but we need to be able to use higher speeds than 19200bps...
+        // 12               13                  14                   15                   16
+        UART16550_38400BPS, UART16550_57600BPS, UART16550_115200BPS, UART16550_230400BPS, UART16550_460800BPS
+    };
+
+    static const uint8_t dsize[] = {
+        UART16550_8D, UART16550_7D, UART16550_6D, UART16550_5D
+    };
+    uint8_t flags;
+    uint8_t data_size;
+    uint8_t data_format;
+
+    if (baud_code == -2)
+    {
+        return iorec->baudrate;
+    }
+    else if (baud_code >= 0) {
+        if (baud_code >= ARRAY_SIZE(baud_codes) || baud_codes[baud_code] == 0) {
+            KDEBUG(("a2560_bios_rsconf1 setting invalid baud specification %d\n", baud_code));
+        }
+        else {
+            KDEBUG(("a2560_bios_rsconf1 setting speed %lu bps (code: %d)\n", (unsigned long)uart16550_bps_code_to_actual(baud_codes[baud_code]), baud_code));
+#ifdef UART16550_HIGH_SPEED
+            superio_uart_high_speed(1, baud_codes[baud_code] & UART16550_HIGH_SPEED_DIVISOR);
+#endif
+            uart16550_set_bps(COM1, baud_codes[baud_code]);
+            iorec->baudrate = baud_code;
+        }
+    }
+
+    if (ctrl >= MIN_FLOW_CTRL && ctrl <= MAX_FLOW_CTRL) {
+        // The A2560U doesn't have the RTS/CTS pins connected, but we don't know
+        // whether there's something at the other end anyway
+        iorec->flowctrl = ctrl;
+        if (iorec == com1_iorec)
+            com1_set_flow();
+    }
+
+    flags = 0;
+    data_size = dsize[(ucr & 0x60) >> 5];
+    data_format = (ucr & 0x18) >> 3;
+
+    if (ucr != -1)
+    {
+        // Parity
+        if (ucr & 2)
+            flags |= ucr & 1 ? UART16550_ODD : UART16550_EVEN;
+        // Data size
+        flags |= data_size;
+        // Stop bits
+        if (data_size != UART16550_5D)
+        {
+            if (data_format == 3/* 1 start 2 stops*/)
+                flags |= UART16550_2S;
+        }
+        else if (data_format == 2/* 1 start 1.5 stop */)
+                flags |= UART16550_1_5S;
+
+        uart16550_set_line(COM1, flags);
+        KDEBUG(("a2560_bios_rsconf1 setting flags %x\n", flags));
+    }
+
+    return 0L; // TODO.
+}
+
+#endif /* MACHINE_FOENIX */
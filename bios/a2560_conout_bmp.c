@@ -26,6 +26,7 @@
 #include "lineavars.h"
 #include "tosvars.h"            /* for v_bas_ad */
 #include "string.h"
+#include "intmath.h"
 #include "conout.h"
 #include "font.h"
 #include "a2560_bios.h"
@@ -48,23 +49,76 @@ static void init(const Fonthead *font)
 }
 
 
+#if CONF_WITH_A2560_SHADOW_FRAMEBUFFER
+/* The text lines form a ring in the shadow frame buffer (see shadow_fb.c),
+ * of this size in bytes */
+static ULONG ring_size(void)
+{
+    return (ULONG)v_cel_wr * (v_cel_my + 1);
+}
+#endif
+
+
 static CHAR_ADDR cell_addr(UWORD x, UWORD y)
 {
-    return (CHAR_ADDR)(v_bas_ad + (ULONG)v_cel_wr * y + x * 8 + v_cur_of);
+    ULONG offset = (ULONG)v_cel_wr * y;
+
+#if CONF_WITH_A2560_SHADOW_FRAMEBUFFER
+    if (a2560_sfb_top && a2560_sfb_addr == v_bas_ad) {
+        offset += (ULONG)a2560_sfb_top * v_lin_wr;
+        if (offset >= ring_size())
+            offset -= ring_size();
+    }
+#endif
+
+    return (CHAR_ADDR)(v_bas_ad + offset + x * 8 + v_cur_of);
 }
 
 
 static int get_char_source(unsigned char c, CHAR_ADDR *src)
 {
     (*src).pxaddr = char_addr(c);   /* a0 -> get character source */
-    return src != NULL;             /* return false if no valid character */
+    return (*src).pxaddr != NULL;  /* return false if no valid character */
 }
 
 
-static void cell_xfer(CHAR_ADDR src, CHAR_ADDR dst)
-{    
-    UWORD fg;
-    UWORD bg;
+/* Expansion of each value of a font byte into 8 pixels of the current
+ * colours, so a row of a glyph is drawn with two long stores. This is
+ * rebuilt when the colours change, which is rare compared to the number of
+ * characters output. We only draw to the shadow framebuffer in system RAM,
+ * so long accesses are fine. */
+static ULONG expansion[256][2];
+static BOOL expansion_valid;
+static UBYTE expansion_fg;
+static UBYTE expansion_bg;
+
+
+static void build_expansion(UBYTE fg, UBYTE bg)
+{
+    ULONG nibble[16];
+    UWORD i, bit;
+
+    for (i = 0; i < 16; i++) {
+        nibble[i] = 0;
+        for (bit = 0x08; bit; bit >>= 1)
+            nibble[i] = (nibble[i] << 8) | ((i & bit) ? fg : bg);
+    }
+
+    for (i = 0; i < 256; i++) {
+        expansion[i][0] = nibble[i >> 4];
+        expansion[i][1] = nibble[i & 0x0f];
+    }
+
+    expansion_fg = fg;
+    expansion_bg = bg;
+    expansion_valid = TRUE;
+}
+
+
+static void get_expansion(void)
+{
+    UBYTE fg;
+    UBYTE bg;
 
     /* check for reversed foreground and background colors */
     if (v_stat_0 & M_REVID) {
@@ -76,56 +130,56 @@ static void cell_xfer(CHAR_ADDR src, CHAR_ADDR dst)
         bg = v_col_bg;
     }
 
+    if (!expansion_valid || fg != expansion_fg || bg != expansion_bg)
+        build_expansion(fg, bg);
+}
+
+
+/* Draw a glyph using the expansion table, which must be up to date */
+static void glyph_xfer(const UBYTE *src, UBYTE *dst)
+{
     int j; /* line of the cell */
-    UBYTE bsrc;
-    UBYTE *d = dst.pxaddr;
-    /* precompute so we don't have to do that in the loop */
-    const UWORD v_lin_wr_advance = v_lin_wr - 8;
-    UWORD bgbg;
+    const ULONG *e;
+
+    for (j = v_cel_ht; --j >= 0; ) {
+        e = expansion[*src];
+        ((ULONG *)dst)[0] = e[0];
+        ((ULONG *)dst)[1] = e[1];
+        dst += v_lin_wr;
+        src += v_fnt_wr;
+    }
+}
 
-    /* We take the bet at least one line will be blank */
-    ((UBYTE*)&bgbg)[0] = bg;
-    ((UBYTE*)&bgbg)[1] = bg;
 
-    for (j = v_cel_ht; --j>=0 ; )
-    {
-        if ((bsrc = *(src.pxaddr))) {
-        
-#if 0
-        int i;
-        for (i = 0; i < 8/*font width*/; i++)
-        {                
-            dst.pxaddr[i] = bsrc & 0x80 ? fg : bg;
-            bsrc <<= 1;
-        }
-#elif 1
-        /* Faster version, for fixed 8-pixel font */
-        *d++ = bsrc & 0x80 ? fg : bg;
-        *d++ = bsrc & 0x40 ? fg : bg;
-        *d++ = bsrc & 0x20 ? fg : bg;
-        *d++ = bsrc & 0x10 ? fg : bg;
-        *d++ = bsrc & 0x08 ? fg : bg;
-        *d++ = bsrc & 0x04 ? fg : bg;
-        *d++ = bsrc & 0x02 ? fg : bg;
-        *d++ = bsrc & 0x01 ? fg : bg;
-        d += v_lin_wr_advance;
+static void cell_xfer(CHAR_ADDR src, CHAR_ADDR dst)
+{
+    get_expansion();
+    glyph_xfer(src.pxaddr, dst.pxaddr);
+
+#if CONF_WITH_A2560_SHADOW_FRAMEBUFFER
+    a2560_sfb_mark_cell_dirty(dst.pxaddr);
 #endif
-        }
-        else {
-            UWORD *e = (UWORD*)d;
-            /* Optimise for white space */
-            *e++ = bgbg;
-            *e++ = bgbg;
-            *e++ = bgbg;
-            *e++ = bgbg;
-            d += v_lin_wr;
-        }
+}
 
-        src.pxaddr += v_fnt_wr;
+
+/* Draw characters in consecutive cells from the cursor position */
+static void cell_xfer_run(const UBYTE *str, UWORD count)
+{
+    UBYTE *dst = v_cur_ad.pxaddr;
+    const UBYTE *src;
+    UWORD i;
+
+    get_expansion();
+    for (i = count; i; i--, dst += 8) {
+        src = char_addr(*str++);
+        if (!src)
+            src = char_addr(' ');   /* missing from the font: draw a space */
+        if (src)
+            glyph_xfer(src, dst);
     }
 
-#if CONF_WITH_A2560_SHADOW_FRAMEBUFFER && 0
-    a2560_sfb_mark_cell_dirty(dst.pxaddr);
+#if CONF_WITH_A2560_SHADOW_FRAMEBUFFER
+    a2560_sfb_mark_rect(v_cur_cx * 8, v_cur_cy * v_cel_ht, (v_cur_cx + count) * 8 - 1, (v_cur_cy + 1) * v_cel_ht - 1);
 #endif
 }
 
@@ -134,7 +188,7 @@ static void neg_cell(CHAR_ADDR cell)
 {
     const int inc = v_lin_wr - 3 * sizeof(UWORD);
     int i;
-#if CONF_WITH_A2560_SHADOW_FRAMEBUFFER && 0
+#if CONF_WITH_A2560_SHADOW_FRAMEBUFFER
     UBYTE *c = cell.pxaddr;
 #endif
 
@@ -151,7 +205,7 @@ static void neg_cell(CHAR_ADDR cell)
         cell.pxaddr += inc;
     }
 
-#if CONF_WITH_A2560_SHADOW_FRAMEBUFFER && 0
+#if CONF_WITH_A2560_SHADOW_FRAMEBUFFER
     a2560_sfb_mark_cell_dirty(c);
 #endif
 }
@@ -166,8 +220,8 @@ static void next_cell(void)
 static void blank_out(int topx, int topy, int botx, int boty)
 {
     UWORD color = v_col_bg;             /* bg color value */
-    int pair, pairs, row, rows, offs;
-    UBYTE * addr = cell_addr(topx, topy).pxaddr;   /* running pointer to screen */
+    int pair, pairs, row, offs, y;
+    UBYTE * addr;                       /* running pointer to screen */
 
     /*
     * # of cell-pairs per row in region - 1
@@ -179,13 +233,6 @@ static void blank_out(int topx, int topy, int botx, int boty)
     /* calculate the BYTE offset from the end of one row to next start */
     offs = v_lin_wr - pairs * 2 * v_planes;
 
-    /*
-    * # of lines in region - 1
-    *
-    * see comments re cell-pairs above
-    */
-    rows = (boty - topy + 1) * v_cel_ht;
-
 
     /* Color modes are optimized for handling 2 planes at once */
     ULONG pair_planes[4];        /* bits on screen for 8 planes max */
@@ -206,28 +253,71 @@ static void blank_out(int topx, int topy, int botx, int boty)
         color >>= 1;        /* get next bit */
     }
 
-    /* do all rows in region */
-    for (row = rows; row--;) {
-        /* loop through all cell pairs */
-        for (pair = pairs; pair--;) {
-            for (i = 0; i < v_planes / 2; i++) {
-                *(ULONG*)addr = pair_planes[i];
-                addr += sizeof(ULONG);
+    /* do all rows in region, a text line at a time as they may wrap */
+    for (y = topy; y <= boty; y++) {
+        addr = cell_addr(topx, y).pxaddr;
+        for (row = v_cel_ht; row--;) {
+            /* loop through all cell pairs */
+            for (pair = pairs; pair--;) {
+                for (i = 0; i < v_planes / 2; i++) {
+                    *(ULONG*)addr = pair_planes[i];
+                    addr += sizeof(ULONG);
+                }
             }
+            addr += offs;       /* skip non-region area with stride advance */
         }
-        addr += offs;       /* skip non-region area with stride advance */
     }
 
-#if CONF_WITH_A2560_SHADOW_FRAMEBUFFER && 0
-    a2560_sfb_mark_screen_dirty();
+#if CONF_WITH_A2560_SHADOW_FRAMEBUFFER
+    a2560_sfb_mark_rect(topx * 8, topy * v_cel_ht, botx * 8 + 7, (boty + 1) * v_cel_ht - 1);
+#endif
+}
+
+
+/* Move n text lines from line 'from' to line 'to' */
+static void move_lines(UWORD to, UWORD from, UWORD n)
+{
+#if CONF_WITH_A2560_SHADOW_FRAMEBUFFER
+    UWORD i;
+
+    if (a2560_sfb_top && a2560_sfb_addr == v_bas_ad) {
+        /* The lines may wrap around the ring, move them one at a time */
+        if (to < from) {
+            for (i = 0; i < n; i++)
+                memcpy(cell_addr(0, to + i).pxaddr, cell_addr(0, from + i).pxaddr, v_cel_wr);
+        } else {
+            for (i = n; i--; )
+                memcpy(cell_addr(0, to + i).pxaddr, cell_addr(0, from + i).pxaddr, v_cel_wr);
+        }
+    }
+    else
+#endif
+        memmove(cell_addr(0, to).pxaddr, cell_addr(0, from).pxaddr, (ULONG)v_cel_wr * n);
+
+#if CONF_WITH_A2560_SHADOW_FRAMEBUFFER
+    a2560_sfb_mark_rect(0, min(to, from) * v_cel_ht, V_REZ_HZ - 1, (max(to, from) + n) * v_cel_ht - 1);
 #endif
 }
 
 
 static void scroll_up(const CHAR_ADDR src, CHAR_ADDR dst, ULONG count)
 {
-    /* move BYTEs of memory*/
-    memmove(dst.pxaddr, src.pxaddr, count);
+    UWORD lines = count / v_cel_wr;
+    UWORD top_line = v_cel_my - lines;
+
+#if CONF_WITH_A2560_SHADOW_FRAMEBUFFER
+    /* When the whole screen scrolls, the top of the ring of text lines
+     * moves one line further, and VICKY displays VRAM from one line
+     * further: nothing needs moving, only the new bottom line is cleared. */
+    if (top_line == 0 && a2560_bios_sfb_is_active && a2560_sfb_addr == v_bas_ad) {
+        /* Don't let the VBL copy tiles while the ring moves */
+        a2560_bios_sfb_is_active = false;
+        a2560_sfb_scroll(v_cel_ht);
+        a2560_bios_sfb_is_active = true;
+    }
+    else
+#endif
+        move_lines(top_line, top_line + 1, lines);
 
     /* exit thru blank out, bottom line cell address y to top/left cell */
     blank_out(0, v_cel_my , v_cel_mx, v_cel_my);
@@ -236,8 +326,7 @@ static void scroll_up(const CHAR_ADDR src, CHAR_ADDR dst, ULONG count)
 
 static void scroll_down(const CHAR_ADDR src, CHAR_ADDR dst, LONG count, UWORD start_line)
 {
-    /* move BYTEs of memory*/
-    memmove(dst.pxaddr, src.pxaddr, count);
+    move_lines(start_line + 1, start_line, count / v_cel_wr);
 
     /* exit thru blank out */
     blank_out(0, start_line , v_cel_mx, start_line);
@@ -264,6 +353,26 @@ static void unpaint_cursor(void)
 }
 
 
+#if CONF_WITH_A2560_SHADOW_FRAMEBUFFER
+/* Put the text lines back in screen order before the screen gets drawn
+ * through v_bas_ad by the VDI or a program */
+void a2560_bios_sfb_unwrap(void)
+{
+    bool active;
+
+    if (!a2560_sfb_top)
+        return;
+
+    active = a2560_bios_sfb_is_active;
+    a2560_bios_sfb_is_active = false;
+    a2560_sfb_unwrap();
+    a2560_bios_sfb_is_active = active;
+
+    v_cur_ad = cell_addr(v_cur_cx, v_cur_cy);
+}
+#endif
+
+
 const CONOUT_DRIVER a2560_conout_bmp =
 {
     init,
@@ -279,6 +388,7 @@ const CONOUT_DRIVER a2560_conout_bmp =
     paint_cursor,
     unpaint_cursor,
     0L, /* Use default method for blinking */
+    cell_xfer_run
 };
 
 #endif /* MACHINE_FOENIX */
@@ -244,7 +244,8 @@ const CONOUT_DRIVER a2560_conout_text =
     cell_xfer,
     paint_cursor,
     unpaint_cursor,
-    blink_cursor
+    blink_cursor,
+    0L  /* Draw runs of characters one by one */
 };
 
 #endif
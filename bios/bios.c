@@ -1084,6 +1084,66 @@ LONG bconout(WORD handle, WORD what)
     return 0L;
 }
 
+/*
+ * bconout_run - Print a buffer to output device, for the BDOS
+ *
+ * When neither the BIOS trap nor the output vector of the device have been
+ * hooked, the console (or the serial port, if its driver supports it) gets
+ * the whole buffer at once, which is much faster than going through
+ * Bconout() for each character.  Otherwise nothing is output and FALSE is
+ * returned, so the caller uses Bconout().
+ */
+
+BOOL bconout_run(WORD handle, const UBYTE *buf, LONG count)
+{
+    if (!(boot_status & CHARDEV_AVAILABLE) || VEC_BIOS != biostrap)
+        return FALSE;
+
+    switch(handle) {
+    case 1:
+        if (bconout_vec[1] == bconout1)
+            return bconout1_run(buf, count);
+        break;
+    case 2:
+        if (bconout_vec[2] == bconout2) {
+            cputs(buf, count);
+            return TRUE;
+        }
+        break;
+    }
+
+    return FALSE;
+}
+
+/*
+ * bconin_run - Get the characters available from input device, for the BDOS
+ *
+ * When neither the BIOS trap nor the input vector of the device have been
+ * hooked, up to 'count' characters are taken from the IOREC of the
+ * console or serial port at once, in the format returned by Bconin(),
+ * without waiting.  Otherwise nothing is read and -1 is returned, so the
+ * caller uses Bconin().
+ */
+
+WORD bconin_run(WORD handle, LONG *buf, WORD count)
+{
+    if (!(boot_status & CHARDEV_AVAILABLE) || VEC_BIOS != biostrap)
+        return -1;
+
+    switch(handle) {
+    case 1:
+        if (bconin_vec[1] == bconin1)
+            return bconin1_run(buf, count);
+        break;
+    case 2:
+        if (bconin_vec[2] == bconin2)
+            return bconin2_run(buf, count);
+        break;
+    }
+
+    return -1;
+}
+
 #if DBGBIOS
 static LONG bios_3(WORD handle, WORD what)
 {
@@ -1091,6 +1151,29 @@ static LONG bios_3(WORD handle, WORD what)
 }
 #endif
 
+/*
+ * bconws - Write a buffer to a character device (GenX extension)
+ *
+ * This is bconout_run() for programs: when neither the BIOS trap nor the
+ * output vector of the device have been hooked, the whole buffer is output
+ * and its length is returned.  Otherwise nothing is output and 0 is
+ * returned, so the caller uses Bconout() for each character.
+ */
+LONG bconws(WORD handle, LONG count, const UBYTE *buf)
+{
+    if (count <= 0 || !bconout_run(handle, buf, count))
+        return 0;
+
+    return count;
+}
+
+#if DBGBIOS
+static LONG bios_f(WORD handle, LONG count, const UBYTE *buf)
+{
+    return bconws(handle, count, buf);
+}
+#endif
+
 #if CONF_SERIAL_CONSOLE_ANSI
 /* Output a string via bconout() */
 void bconout_str(WORD handle, const char* str)
@@ -1354,7 +1437,8 @@ const PFLONG bios_vecs[] = {
     /* GenX OS extensions */
     VEC(bios_c, bmem_gettpa),  // We could also have a variable Bgetvar which returns a union... */
     VEC(bios_d, balloc_stram), // $d balloc_stram(ULONG size, BOOL fromTop): allocates memory, resizing the TPA. Should only be called before running the BDOS.
-    VEC(bios_e, disk_drvrem)   // $e LONG Bdrvmem(void): like _drvmem system variable, returns bitfield of drives supporting media change.
+    VEC(bios_e, disk_drvrem),  // $e LONG Bdrvmem(void): like _drvmem system variable, returns bitfield of drives supporting media change.
+    VEC(bios_f, bconws)        // $f LONG Bconws(WORD dev, LONG count, const UBYTE *buf): outputs a buffer to a character device in one go, or returns 0.
 };
 
 const UWORD bios_ent = ARRAY_SIZE(bios_vecs);
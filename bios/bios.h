@@ -19,6 +19,7 @@ LONG bios_do_unimpl(WORD number);
 LONG bconstat(WORD handle);
 LONG bconin(WORD handle);
 LONG bconout(WORD handle, WORD what);
+LONG bconws(WORD handle, LONG count, const UBYTE *buf);
 LONG lrwabs(WORD r_w, UBYTE *adr, WORD numb, WORD first, WORD drive, LONG lfirst);
 LONG setexc(WORD num, LONG vector);
 LONG tickcal(void);
@@ -353,6 +353,10 @@ static BOOL getbpb_allowed(char *id)
         case 0x04:
         case 0x06:
         case 0x0e:
+#if CONF_WITH_FAT32
+        case 0x0b:
+        case 0x0c:
+#endif
             return TRUE;
         }
     }
@@ -572,6 +576,67 @@ WORD get_shift(ULONG blocksize)
 }
 
 
+#if CONF_WITH_FAT32
+/*
+ * getbpb32 - build the BPB & its extension for a FAT32 filesystem
+ *
+ * the common fields of the BPB (recsiz, clsiz, clsizb) have already
+ * been set up by the caller
+ *
+ * returns FALSE if the bootsector is invalid
+ */
+static BOOL getbpb32(BLKDEV *bdev, struct fat32_bs *b, UWORD reserved)
+{
+    BPB32 *x = &bdev->bpb32;
+    ULONG tmp;
+
+    x->l_fsiz = MAKE_ULONG(getiword(b->spf32+2), getiword(b->spf32));
+    if (x->l_fsiz == 0UL)
+        return FALSE;
+
+    x->l_fatrec = reserved;
+    if (!CONF_WITH_1FAT_SUPPORT || (b->fat >= 2))
+        x->l_fatrec += x->l_fsiz;   /* use 2nd FAT, as for FAT12/16 */
+    x->l_datrec = x->l_fatrec + x->l_fsiz;
+
+    tmp = MAKE_ULONG(getiword(b->sec2+2), getiword(b->sec2));
+    if (tmp < x->l_datrec)
+        return FALSE;
+    x->l_numcl = (tmp - x->l_datrec) / b->spc;
+    if ((x->l_numcl == 0UL) || (x->l_numcl > MAX_FAT32_CLUSTERS))
+        return FALSE;
+
+    x->l_rootcl = MAKE_ULONG(getiword(b->rootcl+2), getiword(b->rootcl));
+    if ((x->l_rootcl < 2) || (x->l_rootcl >= x->l_numcl+2))
+        return FALSE;
+
+    x->l_fsinfo = getiword(b->fsinfo);
+    if ((x->l_fsinfo == 0) || (x->l_fsinfo >= reserved))
+        x->l_fsinfo = 0;            /* no (usable) FSInfo sector */
+
+    /* the 16-bit fields are meaningless for FAT32 */
+    bdev->bpb.rdlen = 0;
+    bdev->bpb.fsiz = 0;
+    bdev->bpb.fatrec = 0;
+    bdev->bpb.datrec = 0;
+    bdev->bpb.numcl = 0;
+
+    bdev->bpb.b_flags = B_32;
+#if CONF_WITH_1FAT_SUPPORT
+    if (b->fat < 2)
+        bdev->bpb.b_flags |= B_1FAT;
+#endif
+
+    KDEBUG(("bpb32 = {\n  fsiz = %lu;\n  fatrec = %lu;\n  datrec = %lu;\n",
+            x->l_fsiz,x->l_fatrec,x->l_datrec));
+    KDEBUG(("  numcl = %lu;\n  rootcl = %lu;\n  fsinfo = %u;\n}\n",
+            x->l_numcl,x->l_rootcl,x->l_fsinfo));
+
+    return TRUE;
+}
+#endif
+
+
 /*
  * blkdev_getbpb - Get BIOS parameter block
  *
@@ -689,6 +754,27 @@ LONG blkdev_getbpb(WORD dev)
     bdev->bpb.clsiz = b->spc;
     bdev->bpb.clsizb = clsizb;
 
+    reserved = getiword(b->res);
+    if (reserved == 0)      /* should not happen */
+        reserved = 1;       /* but if it does, Atari TOS assumes this */
+
+#if CONF_WITH_FAT32
+    /*
+     * a FAT32 filesystem is identified by a zero 16-bit FAT size
+     */
+    if ((getiword(b->spf) == 0) && (unit >= NUMFLOPPIES))
+    {
+        if (!getbpb32(bdev, (struct fat32_bs *)dskbufp, reserved))
+        {
+            KINFO(("Disk %c: is inaccessible (invalid FAT32)\n",dev+'A'));
+            bdev->bpb.recsiz = 0;           /* mark it for XHDI */
+            return 0L;
+        }
+        memcpy(bdev->serial2,((struct fat32_bs *)dskbufp)->serial2,4);
+        goto geometry;
+    }
+#endif
+
     /*
      * determine the number of root directory sectors
      *
@@ -712,9 +798,6 @@ LONG blkdev_getbpb(WORD dev)
      * - dir
      * - data clusters
      */
-    reserved = getiword(b->res);
-    if (reserved == 0)      /* should not happen */
-        reserved = 1;       /* but if it does, Atari TOS assumes this */
     bdev->bpb.fatrec = reserved;
     /*
      * with 2 FATs, use 2nd FAT by default.
@@ -748,7 +831,7 @@ LONG blkdev_getbpb(WORD dev)
         tmp = (tmp - bdev->bpb.datrec) / b->spc;
     if ((tmp > MAX_FAT16_CLUSTERS) || (bdev->bpb.fsiz == 0))
     {
-        /* FAT32 - unsupported */
+        /* FAT32 - unsupported, or not a valid FAT12/16 filesystem */
         KINFO(("Disk %c: is inaccessible (FAT32)\n",dev+'A'));
         bdev->bpb.recsiz = 0;               /* mark it for XHDI */
         return 0L;
@@ -768,11 +851,15 @@ LONG blkdev_getbpb(WORD dev)
         bdev->bpb.b_flags |= B_1FAT;
 #endif
 
+    memcpy(bdev->serial2,b16->serial2,4);
+
+#if CONF_WITH_FAT32
+geometry:
+#endif
     /* additional geometry info */
     bdev->geometry.sides = getiword(b->sides);
     bdev->geometry.spt = getiword(b->spt);
     memcpy(bdev->serial,b->serial,3);
-    memcpy(bdev->serial2,b16->serial2,4);
 
     /* store checksums iff floppy drive */
     if (unit < NUMFLOPPIES)
@@ -833,6 +920,10 @@ static LONG blkdev_mediach(WORD dev)
         KDEBUG(("blkdev_mediach thinks media has changed\n"));
         units[unit].status |= UNIT_CHANGED;
         b->mediachange = ret;
+#if CONF_WITH_DISK_READAHEAD
+        if (unit >= NUMFLOPPIES)
+            disk_readahead_invalidate(unit);
+#endif
     }
 
     KDEBUG(("blkdev_mediach returning %d\n",b->mediachange));
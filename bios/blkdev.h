@@ -24,6 +24,7 @@
  */
 #define MAX_FAT12_CLUSTERS  4084        /* architectural constants */
 #define MAX_FAT16_CLUSTERS  65524
+#define MAX_FAT32_CLUSTERS  0x0ffffff5UL
 #define MAX_CLUSTER_SIZE    32768L      /* must fit in unsigned short */
 #define MIN_SECS_PER_CLUS   1
 #define MAX_SECS_PER_CLUS   (MAX_CLUSTER_SIZE/SECTOR_SIZE)
@@ -86,6 +87,40 @@ struct fat16_bs {
   /* 1fe */  UBYTE cksum[2];
 };
 
+/* FAT32 bootsector */
+struct fat32_bs {
+  /*   0 */  UBYTE bra[2];
+  /*   2 */  UBYTE loader[6];
+  /*   8 */  UBYTE serial[3];
+  /*   b */  UBYTE bps[2];    /* bytes per sector */
+  /*   d */  UBYTE spc;       /* sectors per cluster */
+  /*   e */  UBYTE res[2];    /* number of reserved sectors */
+  /*  10 */  UBYTE fat;       /* number of FATs */
+  /*  11 */  UBYTE dir[2];    /* number of DIR root entries (0) */
+  /*  13 */  UBYTE sec[2];    /* total number of sectors (0) */
+  /*  15 */  UBYTE media;     /* media descriptor */
+  /*  16 */  UBYTE spf[2];    /* sectors per FAT (0) */
+  /*  18 */  UBYTE spt[2];    /* sectors per track */
+  /*  1a */  UBYTE sides[2];  /* number of sides */
+  /*  1c */  UBYTE hid[4];    /* number of hidden sectors */
+  /*  20 */  UBYTE sec2[4];   /* total number of sectors */
+  /*  24 */  UBYTE spf32[4];  /* sectors per FAT */
+  /*  28 */  UBYTE flags[2];  /* FAT mirroring flags */
+  /*  2a */  UBYTE version[2]; /* filesystem version */
+  /*  2c */  UBYTE rootcl[4]; /* first cluster of root directory */
+  /*  30 */  UBYTE fsinfo[2]; /* FSInfo sector */
+  /*  32 */  UBYTE bkboot[2]; /* backup boot sector */
+  /*  34 */  UBYTE reserved[12];
+  /*  40 */  UBYTE ldn;       /* logical drive number */
+  /*  41 */  UBYTE dirty;     /* dirty filesystem flags */
+  /*  42 */  UBYTE ext;       /* extended signature */
+  /*  43 */  UBYTE serial2[4]; /* extended serial number */
+  /*  47 */  UBYTE label[11]; /* volume label */
+  /*  52 */  UBYTE fstype[8]; /* file system type */
+  /*  5a */  UBYTE data[0x1a4];
+  /* 1fe */  UBYTE cksum[2];
+};
+
 
 struct _geometry        /* disk parameter block */
 {
@@ -155,6 +190,9 @@ struct _blkdev
     UBYTE       flags;          /* general flag byte (see above for definitions) */
     UBYTE       mediachange;    /* current mediachange status */
     BPB         bpb;
+#if CONF_WITH_FAT32
+    BPB32       bpb32;          /* must immediately follow bpb */
+#endif
     GEOMETRY    geometry;       /* this should probably belong to units */
     UBYTE       forcechange;    /* see above for description */
     UBYTE       serial[3];      /* the serial number taken from the bootsector */
@@ -302,8 +302,8 @@ void conout_ascii_out(int ch)
             v_cur_cy = y + 1;           /* update cursor's y coordinate */
         }
         else {
-            cell = conout->cell_addr(0, y); /* cursor stays on (current) last line */
             conout_scroll_up(0);            /* scroll from top of screen */
+            cell = conout->cell_addr(0, y); /* cursor stays on (current) last line */
         }
         v_cur_ad = cell;                /* update cursor address */   
     }
@@ -335,6 +335,110 @@ void conout_blank_out(int topx, int topy, int botx, int boty)
 }
 
 
+/*
+ * cell_run - draw characters in consecutive cells from the cursor position
+ *
+ * The cursor is not moved.
+ */
+
+static void cell_run(const UBYTE *str, UWORD count)
+{
+    CHAR_ADDR src;
+    CHAR_ADDR cursor;
+
+    if (conout->cell_xfer_run) {
+        conout->cell_xfer_run(str, count);
+        return;
+    }
+
+    cursor = v_cur_ad;
+    while (count--) {
+        /* a character missing from the font is drawn as a space */
+        if (conout->get_char_source(*str++, &src) || conout->get_char_source(' ', &src))
+            conout->cell_xfer(src, v_cur_ad);
+        conout->next_cell();
+    }
+    v_cur_ad = cursor;
+}
+
+
+/*
+ * conout_ascii_run - output a run of characters
+ *
+ * Same as calling conout_ascii_out() for each character of str, but the
+ * cursor is only hidden and shown once, and the characters which fit on
+ * the current line are drawn in one go.  Wrapping and scrolling are done
+ * at the end of each line.  Control characters are not interpreted.
+ */
+
+void conout_ascii_run(const UBYTE *str, UWORD count)
+{
+    BOOL visible;                       /* was the cursor visible? */
+    UWORD n;
+
+    if (count == 0)
+        return;
+
+    visible = CURSOR_IS_ENABLED;        /* test visibility bit */
+    if (visible)
+        CURSOR_DISABLE;                 /* start of critical section */
+
+    for (;;) {
+        n = v_cel_mx - v_cur_cx + 1;    /* cells left on the line */
+        if (n > count)
+            n = count;
+
+        /* put the cells out (this covers the cursor) */
+        cell_run(str, n);
+        str += n;
+        count -= n;
+
+        if (v_cur_cx + n <= v_cel_mx) {
+            /* all done, and still on the same line */
+            v_cur_cx += n;
+            v_cur_ad = conout->cell_addr(v_cur_cx, v_cur_cy);
+            break;
+        }
+
+        /* we've written the last cell of the line */
+        v_cur_cx = v_cel_mx;
+        v_cur_ad = conout->cell_addr(v_cur_cx, v_cur_cy);
+        if (!(v_stat_0 & M_CEOL)) {
+            /* overwrite in effect, only the last character remains */
+            if (count)
+                cell_run(str + count - 1, 1);
+            break;
+        }
+
+        /* CRLF */
+        v_cur_cx = 0;
+        if (v_cur_cy < v_cel_my)
+            v_cur_cy++;
+        else
+            conout_scroll_up(0);        /* scroll from top of screen */
+        v_cur_ad = conout->cell_addr(0, v_cur_cy);
+
+        if (count == 0)
+            break;
+    }
+
+    if (conout->cursor_moved)
+        conout->cursor_moved();
+
+    /* if visible */
+    if (visible) {
+        conout_paint_cursor();          /* display cursor. */
+        CURSOR_FLASH_UP;                /* set state flag (cursor on). */
+        CURSOR_ENABLE;                  /* end of critical section. */
+
+        /* do not flash the cursor when it moves */
+        if (CURSOR_FLASH_ENABLED) {
+            v_cur_tim = v_period;       /* reset the timer. */
+        }
+    }
+}
+
+
 /*
  * conout_scroll_up - Scroll upwards
  *
@@ -363,6 +467,9 @@ void conout_scroll_up(UWORD top_line)
     src = conout->cell_addr(0, top_line + 1);
     count = (ULONG)v_cel_wr * (v_cel_my - top_line);
     conout->scroll_up(src, dst, count);   
+
+    /* the driver may have moved the lines rather than their contents */
+    v_cur_ad = cell_addr(v_cur_cx, v_cur_cy);
 }
 
 
@@ -381,6 +488,9 @@ void conout_scroll_down(UWORD start_line)
     count = (ULONG)v_cel_wr * (v_cel_my - start_line);
 
     conout->scroll_down(src, dst, count, start_line);
+
+    /* the driver may have moved the lines rather than their contents */
+    v_cur_ad = cell_addr(v_cur_cx, v_cur_cy);
 }
 
 
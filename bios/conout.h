@@ -71,6 +71,7 @@ extern WORD sav_cur_y;          /* saved cursor cell y */
 /* Prototypes */
 void conout_init(const Fonthead *font);
 void conout_ascii_out(int);
+void conout_ascii_run(const UBYTE *str, UWORD count);
 void conout_enable_cursor(void);
 void conout_disable_cursor(void);
 void conout_move_cursor(int x, int y);
@@ -96,6 +97,7 @@ typedef struct {
     void (*con_paint_cursor)(void);
     void (*unpaint_cursor)(void);
     void (*blink_cursor)(void); /* If null, a fallback is used */
+    void (*cell_xfer_run)(const UBYTE *str, UWORD count); /* If null, cell_xfer is used */
 } CONOUT_DRIVER;
 
 #endif
\ No newline at end of file
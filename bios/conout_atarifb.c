@@ -111,7 +111,7 @@ static CHAR_ADDR cell_addr(UWORD x, UWORD y)
 static int get_char_source(unsigned char c, CHAR_ADDR *src)
 {
     (*src).pxaddr = char_addr(c);   /* a0 -> get character source */
-    return src != NULL;             /* return false if char not in font */
+    return (*src).pxaddr != NULL;  /* return false if char not in font */
 }
 
 
@@ -560,7 +560,8 @@ const CONOUT_DRIVER conout_atarifb =
     cell_xfer,
     paint_cursor,
     paint_cursor, /* painting/unpainting are symetric operations */
-    0L /* Use default method for blinking */
+    0L, /* Use default method for blinking */
+    0L  /* Draw runs of characters one by one */
 };
 
 #endif
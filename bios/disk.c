@@ -28,6 +28,7 @@
 #include "sd.h"
 #include "../bdos/bdosstub.h"
 #include "string.h"
+#include "intmath.h"
 
 /*==== Defines ============================================================*/
 
@@ -93,6 +94,23 @@ int has_ultrasatan_clock;
 int ultrasatan_id;
 #endif
 
+#if CONF_WITH_DISK_READAHEAD
+/*
+ * read-ahead window: a single buffer holding the sectors most recently
+ * read in advance, for one unit.  For each unit, we remember where the
+ * last read ended and how much we currently prefetch.
+ */
+#define RA_BUFSIZE      (CONF_DISK_READAHEAD_KB * 1024L)
+#define RA_MIN_SECTORS  8       /* prefetch size after the first sequential read */
+
+static LONG ra_buf[RA_BUFSIZE/sizeof(LONG)];    /* LONG for alignment */
+static WORD ra_unit = -1;       /* unit of the data in ra_buf, -1 => none */
+static ULONG ra_start;          /* first sector in ra_buf */
+static UWORD ra_count;          /* number of sectors in ra_buf */
+static ULONG ra_next[UNITSNUM]; /* sector following the last read */
+static UWORD ra_size[UNITSNUM]; /* current prefetch size, 0 => not sequential */
+#endif
+
 /*==== Internal declarations ==============================================*/
 #if !CONF_WITH_EXTERNAL_DISK_DRIVER
 static int atari_partition(UWORD unit,LONG *devices_available);
@@ -454,6 +472,10 @@ void disk_rescan(UWORD unit)
 
     KDEBUG(("disk_rescan(%d):drivemap=0x%08lx\n",unit,devices_available));
 
+#if CONF_WITH_DISK_READAHEAD
+    disk_readahead_invalidate(unit);
+#endif
+
     /* rescan (this clobbers 'devices_available') */
     disk_init_one(unit,&devices_available);
 
@@ -1191,7 +1213,11 @@ LONG disk_get_capacity(UWORD unit, ULONG *blocks, ULONG *blocksize)
 }
 
 /* Unit read/write */
+#if CONF_WITH_DISK_READAHEAD
+static LONG disk_rw_direct(UWORD unit, UWORD rw, ULONG sector, UWORD count, UBYTE *buf)
+#else
 LONG disk_rw(UWORD unit, UWORD rw, ULONG sector, UWORD count, UBYTE *buf)
+#endif
 {
     UWORD major = unit - NUMFLOPPIES;
     LONG ret;
@@ -1253,6 +1279,105 @@ LONG disk_rw(UWORD unit, UWORD rw, ULONG sector, UWORD count, UBYTE *buf)
     return ret;
 }
 
+#if CONF_WITH_DISK_READAHEAD
+
+/*
+ * forget the read-ahead data & sequential state of a unit
+ *
+ * this must be called whenever the medium may have changed
+ */
+void disk_readahead_invalidate(UWORD unit)
+{
+    if (ra_unit == unit)
+        ra_unit = -1;
+    ra_size[unit] = 0;
+}
+
+/*
+ * Unit read/write, with read-ahead
+ *
+ * Reads that start where the previous read on the same unit ended are
+ * considered sequential: we then read the requested sectors plus the
+ * following ones into ra_buf with a single command, and serve the next
+ * requests from there.  The prefetch size doubles on each sequential
+ * read that is not satisfied from ra_buf, and drops to zero as soon as
+ * the access pattern becomes random.
+ */
+LONG disk_rw(UWORD unit, UWORD rw, ULONG sector, UWORD count, UBYTE *buf)
+{
+    UBYTE *rabuf = (UBYTE *)ra_buf;
+    WORD psshift = units[unit].psshift;
+    ULONG start = sector;               /* start of the request */
+    UWORD max, n;
+    LONG ret;
+
+    if ((rw & RW_RW) != RW_READ) {
+        /* drop the read-ahead data if the write overlaps it */
+        if ((ra_unit == unit) && (sector < ra_start + ra_count)
+         && (sector + count > ra_start))
+            ra_unit = -1;
+        return disk_rw_direct(unit, rw, sector, count, buf);
+    }
+
+    /* unswapped data must come from the disk */
+    if (rw & RW_NOBYTESWAP)
+        return disk_rw_direct(unit, rw, sector, count, buf);
+
+    /* copy what we can from the read-ahead buffer */
+    if ((ra_unit == unit) && (sector >= ra_start) && (sector < ra_start + ra_count)) {
+        n = ra_start + ra_count - sector;
+        if (n > count)
+            n = count;
+        memcpy(buf, rabuf + ((sector - ra_start) << psshift), (ULONG)n << psshift);
+        KDEBUG(("disk_rw(): %u sector(s) at %lu from read-ahead\n", n, sector));
+        sector += n;
+        count -= n;
+        buf += (ULONG)n << psshift;
+        if (count == 0) {
+            ra_next[unit] = sector;
+            return 0L;
+        }
+    }
+
+    /* adapt the prefetch size to the access pattern: the request is
+     * sequential if it started where the previous one ended, even if
+     * its beginning came from the read-ahead buffer */
+    max = (UWORD)(RA_BUFSIZE >> psshift);
+    if (start == ra_next[unit])
+        ra_size[unit] = ra_size[unit] ? min(2*ra_size[unit], max) : RA_MIN_SECTORS;
+    else ra_size[unit] = 0;
+    ra_next[unit] = sector + count;
+
+    if ((ra_size[unit] == 0) || (count >= max))
+        return disk_rw_direct(unit, rw, sector, count, buf);
+
+    n = min(count + ra_size[unit], max);
+    if (units[unit].size && (sector + n > units[unit].size))
+        n = units[unit].size - sector;
+    if (n <= count)
+        return disk_rw_direct(unit, rw, sector, count, buf);
+
+    ra_unit = -1;
+    ret = disk_rw_direct(unit, rw, sector, n, rabuf);
+    if (ret < 0L) {
+        /* the error may be in the prefetched part: read just what was asked */
+        ra_size[unit] = 0;
+        if (ret == E_CHNG)
+            return ret;
+        return disk_rw_direct(unit, rw, sector, count, buf);
+    }
+
+    KDEBUG(("disk_rw(): read %u sector(s) at %lu, %u requested\n", n, sector, count));
+    ra_unit = unit;
+    ra_start = sector;
+    ra_count = n;
+    memcpy(buf, rabuf, (ULONG)count << psshift);
+
+    return 0L;
+}
+
+#endif /* CONF_WITH_DISK_READAHEAD */
+
 /*==== XBIOS functions ====================================================*/
 
 LONG DMAread(LONG sector, WORD count, UBYTE *buf, WORD major)
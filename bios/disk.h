@@ -107,6 +107,9 @@ LONG disk_inquire(UWORD unit, ULONG *blocksize, ULONG *deviceflags, char *produc
 
 LONG disk_get_capacity(UWORD unit, ULONG *blocks, ULONG *blocksize);
 LONG disk_rw(UWORD unit, UWORD rw, ULONG sector, UWORD count, UBYTE *buf);
+#if CONF_WITH_DISK_READAHEAD
+void disk_readahead_invalidate(UWORD unit);
+#endif
 
 /* xbios functions */
 
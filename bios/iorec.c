@@ -11,50 +11,73 @@
  */
 
 #include "emutos.h"
-#include "asm.h"
 #include "iorec.h"
+#include "string.h"
+#include "intmath.h"
+
+
+/*
+ * The IORECs are single-producer/single-consumer ring buffers: the
+ * producer (usually an interrupt handler) only ever writes 'tail', and
+ * the consumer only ever writes 'head', so there's no need to mask
+ * interrupts.  Each side fills or empties the buffer slots first, then
+ * publishes its new index with a single (atomic) word write.  The slot
+ * 'head' points to has already been read, and is never written to by the
+ * producer, so that 'tail' can't catch up with 'head'.
+ */
 
+/* Make sure the buffer accesses are done before the index is updated */
+#define publish_barrier()   __asm__ volatile ("" : : : "memory")
 
-UBYTE iorec_get(IOREC *iorec) {
-    WORD old_sr;
-    LONG value;
 
-    /* disable interrupts */
-    old_sr = set_sr(0x2700);
-
-    iorec->head++;
-    if (iorec->head >= iorec->size)
-        iorec->head = 0;
+UBYTE iorec_get(IOREC *iorec) {
+    WORD head;
+    UBYTE value;
 
-    value = *(UBYTE *)(iorec->buf + iorec->head);
+    head = iorec->head + 1;
+    if (head >= iorec->size)
+        head = 0;
 
-    /* restore interrupts */
-    set_sr(old_sr);
+    value = *(iorec->buf + head);
+    publish_barrier();
+    iorec->head = head;
 
     return value;
 }
 
 
 LONG  iorec_get_long(IOREC *iorec) {
-    WORD old_sr;
+    WORD head;
     LONG value;
 
-    /* disable interrupts */
-    old_sr = set_sr(0x2700);
-
-    iorec->head += 4;
-    if (iorec->head >= iorec->size) {
-        iorec->head = 0;
+    head = iorec->head + 4;
+    if (head >= iorec->size) {
+        head = 0;
     }
-    value = *(ULONG_ALIAS *) (iorec->buf + iorec->head);
-
-    /* restore interrupts */
-    set_sr(old_sr);
+    value = *(ULONG_ALIAS *) (iorec->buf + head);
+    publish_barrier();
+    iorec->head = head;
 
     return value;
 }
 
 
+void iorec_put(IOREC *iorec, UBYTE value) {
+    WORD tail;
+
+    tail = iorec->tail + 1;
+    if (tail >= iorec->size)
+        tail = 0;
+    if (tail == iorec->head) {
+        /* iorec full */
+        return;
+    }
+    *(iorec->buf + tail) = value;
+    publish_barrier();
+    iorec->tail = tail;
+}
+
+
 void iorec_put_long(IOREC *iorec, ULONG value) {
     short tail;
 
@@ -69,10 +92,93 @@ void iorec_put_long(IOREC *iorec, ULONG value) {
         return;
     }
     *(ULONG_ALIAS *) (iorec->buf + tail) = value;
+    publish_barrier();
     iorec->tail = tail;
 }
 
 
+/*
+ * iorec_read - take up to 'count' bytes from a byte IOREC
+ *
+ * returns the number of bytes actually read, without waiting
+ */
+WORD iorec_read(IOREC *iorec, UBYTE *dest, WORD count) {
+    WORD head, avail, n;
+
+    head = iorec->head;
+    avail = iorec->tail - head;
+    if (avail < 0)
+        avail += iorec->size;
+    if (count > avail)
+        count = avail;
+
+    for (avail = count; avail; avail -= n) {
+        if (++head >= iorec->size)
+            head = 0;
+        n = min(avail, iorec->size - head);     /* up to the end of buf */
+        memcpy(dest, iorec->buf + head, n);
+        dest += n;
+        head += n - 1;
+    }
+    publish_barrier();
+    iorec->head = head;
+
+    return count;
+}
+
+
+/*
+ * iorec_read_long - take up to 'count' longs from a long IOREC
+ *
+ * returns the number of longs actually read, without waiting
+ */
+WORD iorec_read_long(IOREC *iorec, ULONG *dest, WORD count) {
+    WORD head, n;
+
+    head = iorec->head;
+    for (n = 0; (n < count) && (head != iorec->tail); n++) {
+        head += 4;
+        if (head >= iorec->size)
+            head = 0;
+        dest[n] = *(ULONG_ALIAS *) (iorec->buf + head);
+    }
+    publish_barrier();
+    iorec->head = head;
+
+    return n;
+}
+
+
+/*
+ * iorec_write - put up to 'count' bytes into a byte IOREC
+ *
+ * returns the number of bytes actually written, without waiting
+ */
+WORD iorec_write(IOREC *iorec, const UBYTE *src, WORD count) {
+    WORD tail, room, n;
+
+    tail = iorec->tail;
+    room = iorec->head - tail - 1;
+    if (room < 0)
+        room += iorec->size;
+    if (count > room)
+        count = room;
+
+    for (room = count; room; room -= n) {
+        if (++tail >= iorec->size)
+            tail = 0;
+        n = min(room, iorec->size - tail);      /* up to the end of buf */
+        memcpy(iorec->buf + tail, src, n);
+        src += n;
+        tail += n - 1;
+    }
+    publish_barrier();
+    iorec->tail = tail;
+
+    return count;
+}
+
+
 WORD iorec_can_read(IOREC *iorec) {
     return iorec->head == iorec->tail ? 0 : -1;
 }
@@ -37,7 +37,11 @@ extern IOREC ikbdiorec, midiiorec;
 
 UBYTE iorec_get(IOREC *iorec);
 WORD  iorec_can_read(IOREC *iorec);
+void  iorec_put(IOREC *iorec, UBYTE value);
 void  iorec_put_long(IOREC *iorec, ULONG value);
 LONG  iorec_get_long(IOREC *iorec);
+WORD  iorec_read(IOREC *iorec, UBYTE *dest, WORD count);
+WORD  iorec_read_long(IOREC *iorec, ULONG *dest, WORD count);
+WORD  iorec_write(IOREC *iorec, const UBYTE *src, WORD count);
 
 #endif /* IOREC_H */
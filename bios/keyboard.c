@@ -446,6 +446,29 @@ LONG bconin2(void)
     return value;
 }
 
+/*
+ * take all the keys available, up to 'count', in the format returned by
+ * bconin2(), without waiting
+ *
+ * returns the number of keys, or -1 if they must be read via bconin2()
+ */
+WORD bconin2_run(LONG *buf, WORD count)
+{
+#if CONF_SERIAL_CONSOLE_POLLING_MODE
+    return -1;
+#else
+    WORD i, n;
+
+    n = iorec_read_long(&ikbdiorec, (ULONG *)buf, count);
+
+    if (!(conterm & 8))         /* shift status not wanted? */
+        for (i = 0; i < n; i++)
+            buf[i] &= 0x00ffffffL;
+
+    return n;
+#endif
+}
+
 
 /*
  * convert a scancode to an ascii character
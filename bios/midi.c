@@ -54,19 +54,7 @@ static void midivec(UBYTE data)
     /* Store the data in the circular buffer, if not full */
     //KDEBUG(("midivec called\n"));
 
-    UWORD tail;
-    IOREC *iorec = &midiiorec;
-
-    tail = iorec->tail + 1;
-
-    if (tail >= iorec->size)
-        tail = 0;
-
-    if (tail == iorec->head)
-        return; // buffer full
-
-    iorec->buf[tail] = data;
-    iorec->tail = tail;
+    iorec_put(&midiiorec, data);
 }
 
 /*==== MIDI bios functions =========================================*/
@@ -259,6 +259,10 @@ void screen_setphys(const UBYTE *addr)
 
 UBYTE *logbase(void)
 {
+#if CONF_WITH_A2560_SHADOW_FRAMEBUFFER
+    /* The caller may draw to it directly */
+    a2560_bios_sfb_unwrap();
+#endif
     return v_bas_ad;
 }
 
@@ -68,6 +68,8 @@ static void init(void)
     KDEBUG(("screen_1bpp:init\n"));
 
     a2560_irq_set_handler(INT_SOF_B, int_vbl);
+    /* The VBL routines can take a while, don't let them delay the other interrupts */
+    a2560_irq_set_deferred(INT_SOF_B, true);
 
     cpu_set_vector(INT_VICKYII_A, (uint32_t)a2560_irq_vicky_a);
     cpu_set_vector(INT_VICKYII_B, (uint32_t)a2560_irq_vicky_b);
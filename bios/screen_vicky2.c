@@ -11,6 +11,7 @@
 #include "screen.h"
 #include "tosvars.h" // v_bas_ad
 #include "vectors.h" // int_vbl
+#include "../foenix/a2560.h"
 #include "../foenix/interrupts.h"
 #include "../foenix/regutils.h"
 #include "../foenix/shadow_fb.h"
@@ -32,6 +33,8 @@ static void screen_vicky2_screen_init(void)
 
     // TODO on the A2560U, are we using channel A since there is no channel B?
     a2560_irq_set_handler(INT_SOF_B, int_vbl);
+    /* The VBL routines can take a while, don't let them delay the other interrupts */
+    a2560_irq_set_deferred(INT_SOF_B, true);
     KDEBUG(("screen_vicky2_screen_init exiting\n"));
 }
 
@@ -146,6 +149,17 @@ static WORD screen_vicky2_setscreen(UBYTE *logical, const UBYTE *physical, WORD
 
 static void screen_vicky2_setphys(const UBYTE *addr)
 {
+    KDEBUG(("screen_vicky2_setphys(%p)\n", addr));
+#if CONF_WITH_A2560_SHADOW_FRAMEBUFFER
+    /* The screen is drawn in system RAM and copied to VRAM during VBL,
+     * VICKY can only show the copy. */
+    if (addr < (UBYTE *)VRAM_Bank0 || addr >= (UBYTE *)(VRAM_Bank0 + VRAM0_SIZE))
+        addr = (UBYTE *)VRAM_Bank0;
+#endif
+    a2560_setphys(addr);
+#if CONF_WITH_A2560_SHADOW_FRAMEBUFFER
+    a2560_sfb_mark_screen_dirty();
+#endif
 }
 
 /* This is the whole point of this file */
@@ -689,8 +689,7 @@ UBYTE token;
      *  transfer data
      */
     if (buf) {
-        for (i = 0; i < len; i++)
-            *buf++ = spi_driver->recv_byte();
+        spi_driver->recv_block(buf,len);
     } else {
         for (i = 0; i < len; i++)
             spi_driver->recv_byte();
@@ -711,7 +710,6 @@ UBYTE token;
  */
 static int sd_send_data(UBYTE *buf,UWORD len,UBYTE token,const SPI_DRIVER *spi_driver)
 {
-LONG i;
 UBYTE rtoken;
 
     spi_driver->send_byte(token);
@@ -719,8 +717,7 @@ UBYTE rtoken;
         spi_driver->recv_byte();    /* skip a byte before testing for busy */
     } else {
         /* send the data */
-        for (i = 0; i < len; i++)
-            spi_driver->send_byte(*buf++);
+        spi_driver->send_block(buf,len);
         spi_driver->send_byte(0xff);        /* send dummy crc */
         spi_driver->send_byte(0xff);
 
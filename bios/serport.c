@@ -169,26 +169,6 @@ static void put_iorecbuf(IOREC *out, WORD b)
 #endif
 
 
-static LONG get_iorecbuf(IOREC *in)
-{
-    WORD old_sr;
-    LONG value;
-
-    /* disable interrupts */
-    old_sr = set_sr(0x2700);
-    
-    in->head++;
-    if (in->head >= in->size) {
-        in->head = 0;
-    }
-    value = *(UBYTE *)(in->buf + in->head);
-
-    /* restore interrupts */
-    set_sr(old_sr);
-    
-    return value;
-}
-
 static LONG bconstat_iorec(EXT_IOREC *iorec)
 {
     /* Character available in the serial input buffer? */
@@ -207,7 +187,7 @@ static LONG bconin_iorec(EXT_IOREC *iorec)
         ;
 
     /* Return character... */
-    return get_iorecbuf(&iorec->in);
+    return iorec_get(&iorec->in);
 }
 
 
@@ -260,7 +240,57 @@ LONG bconstat1(void)
 
 LONG bconin1(void)
 {
+#if defined(MACHINE_A2560U) || defined(MACHINE_A2560K) || defined(MACHINE_A2560M) || defined(MACHINE_A2560X) || defined(MACHINE_GENX)
+    LONG c = bconin_iorec(&iorec1);
+
+    a2560_bios_com1_rx_drained();   /* maybe resume the flow */
+
+    return c;
+#else
     return bconin_iorec(&iorec1);
+#endif
+}
+
+/*
+ * take all the characters available, up to 'count', without waiting
+ *
+ * returns the number of characters
+ */
+WORD bconin1_run(LONG *buf, WORD count)
+{
+    UBYTE bytes[16];
+    WORD i, n, total = 0;
+
+    do {
+        n = count - total;
+        if (n > (WORD)sizeof(bytes))
+            n = sizeof(bytes);
+        n = iorec_read(&iorec1.in, bytes, n);
+        for (i = 0; i < n; i++)
+            buf[total++] = bytes[i];
+    } while ((n == (WORD)sizeof(bytes)) && (total < count));
+
+#if defined(MACHINE_A2560U) || defined(MACHINE_A2560K) || defined(MACHINE_A2560M) || defined(MACHINE_A2560X) || defined(MACHINE_GENX)
+    if (total)
+        a2560_bios_com1_rx_drained();   /* maybe resume the flow */
+#endif
+
+    return total;
+}
+
+/*
+ * output a whole buffer, if the driver supports it
+ *
+ * returns FALSE if it must be done with bconout1()
+ */
+BOOL bconout1_run(const UBYTE *buf, LONG count)
+{
+#if defined(MACHINE_A2560U) || defined(MACHINE_A2560K) || defined(MACHINE_A2560M) || defined(MACHINE_A2560X) || defined(MACHINE_GENX)
+    a2560_bios_bconout1_run(buf, count);
+    return TRUE;
+#else
+    return FALSE;
+#endif
 }
 
 /*
@@ -336,16 +366,7 @@ LONG bconout1(WORD dev, WORD b)
 
 void push_serial_iorec(UBYTE data)
 {
-    IOREC *in = &iorec1.in;
-    WORD tail;
-
-    tail = incr_tail(in);
-    if (tail == in->head) {
-        /* iorec full, do nothing */
-    } else {
-        *((UBYTE *)(in->buf + tail)) = data;
-        in->tail = tail;
-    }
+    iorec_put(&iorec1.in, data);    /* does nothing if full */
 }
 
 #if CONF_WITH_MFP_RS232
@@ -457,16 +478,9 @@ static LONG bconoutTT(WORD dev, WORD b)
 void mfp_tt_rx_interrupt_handler(void)
 {
     IOREC *in = &iorecTT.in;
-    WORD tail;
 
     if (TT_MFP_BASE->rsr & 0x80) {
-        UBYTE data = TT_MFP_BASE->udr;
-        tail = incr_tail(in);
-        if (tail != in->head) {
-            /* space available in iorec buffer */
-            *((UBYTE *)(in->buf + tail)) = data;
-            in->tail = tail;
-        }
+        iorec_put(in, TT_MFP_BASE->udr);    /* does nothing if full */
     }
 
     /* clear the interrupt service bit (bit 4) */
@@ -659,7 +673,6 @@ void scc_rx_interrupt_handler(WORD portnum)
     IOREC *in;
     SCC_PORT *port;
     UBYTE available;
-    WORD tail;
 
     if (portnum == 0) {
         extiorec = &iorecA;
@@ -677,12 +690,7 @@ void scc_rx_interrupt_handler(WORD portnum)
     if (available) {
         UBYTE data = port->data & extiorec->datamask;
         RECOVERY_DELAY;
-        tail = incr_tail(in);
-        if (tail != in->head) {
-            /* space available in iorec buffer */
-            *((UBYTE *)(in->buf + tail)) = data;
-            in->tail = tail;
-        }
+        iorec_put(in, data);                /* does nothing if full */
     }
 
     /* do error reset in case we're here because of a 'special receive condition' */
@@ -1083,7 +1091,7 @@ void init_serport(void)
 #endif
 
 #if defined(MACHINE_A2560U) || defined(MACHINE_A2560K) || defined(MACHINE_A2560M) || defined(MACHINE_A2560X) || defined(MACHINE_GENX)
-    a2560_bios_rs232_init();
+    a2560_bios_rs232_init(&iorec1);
 #endif
 
 #ifdef __mcoldfire__
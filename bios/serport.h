@@ -75,8 +75,10 @@ extern EXT_IOREC *rs232iorecptr;
  */
 LONG bconstat1(void);
 LONG bconin1(void);
+WORD bconin1_run(LONG *buf, WORD count);
 LONG bcostat1(void);
 LONG bconout1(WORD,WORD);
+BOOL bconout1_run(const UBYTE *buf, LONG count);
 ULONG rsconf1(WORD baud, WORD ctrl, WORD ucr, WORD rsr, WORD tsr, WORD scr);
 void init_serport(void);
 void push_serial_iorec(UBYTE data);
@@ -23,6 +23,8 @@ typedef struct {
     void (*cs_unassert)(void);  /* Unassert chip select*/
     void (*send_byte)(UBYTE c);
     UBYTE (*recv_byte)(void);
+    void (*send_block)(const UBYTE *buf, UWORD len);    /* send_byte() for each byte */
+    void (*recv_block)(UBYTE *buf, UWORD len);          /* recv_byte() for each byte */
     void (*led_on)(void);       /* Turn on the led of the associated slot */
     void (*led_off)(void);      /* Turn off the led of the associated slot */
     ULONG data;                 /* Free for the driver's use */
@@ -39,4 +41,14 @@ extern const SPI_DRIVER spi_a2560m_sd0;
 extern const SPI_DRIVER spi_a2560m_sd1;
 #endif
 
+/* block transfer routines in spi_a2560_s.S */
+#if defined(MACHINE_A2560U) || defined(MACHINE_A2560K) || defined(MACHINE_A2560X) || defined(MACHINE_GENX)
+void spi_gavin_send_block(const UBYTE *buf, UWORD len);
+void spi_gavin_recv_block(UBYTE *buf, UWORD len);
+#endif
+#if defined(MACHINE_A2560K) || defined(MACHINE_A2560M) || defined(MACHINE_A2560X) || defined(MACHINE_GENX)
+void spi_a2560m_send_block(volatile UBYTE *data, const UBYTE *buf, UWORD len);
+void spi_a2560m_recv_block(volatile UBYTE *data, UBYTE *buf, UWORD len);
+#endif
+
 #endif /* _SPI_H */
@@ -136,6 +136,8 @@ static void spi_cs_assert0(void) { spi_cs_assert(&sd0); }
 static void spi_cs_unassert0(void) { spi_cs_unassert(&sd0); }
 static void spi_send_byte0(uint8_t b) { spi_send_byte(&sd0, b); }
 static uint8_t spi_recv_byte0(void) { return spi_recv_byte(&sd0); }
+static void spi_send_block0(const UBYTE *buf, UWORD len) { spi_a2560m_send_block((volatile UBYTE *)sd0.data, buf, len); }
+static void spi_recv_block0(UBYTE *buf, UWORD len) { spi_a2560m_recv_block((volatile UBYTE *)sd0.data, buf, len); }
 const SPI_DRIVER spi_a2560m_sd0 = {
     spi_initialise0,
     spi_clock_sd0,
@@ -145,6 +147,8 @@ const SPI_DRIVER spi_a2560m_sd0 = {
     spi_cs_unassert0,
     spi_send_byte0,
     spi_recv_byte0,
+    spi_send_block0,
+    spi_recv_block0,
     just_rts,
     just_rts
 };
@@ -163,6 +167,8 @@ static void spi_cs_assert1(void) { spi_cs_assert(&sd1); }
 static void spi_cs_unassert1(void) { spi_cs_unassert(&sd1); }
 static void spi_send_byte1(uint8_t b) { spi_send_byte(&sd1, b); }
 static uint8_t spi_recv_byte1(void) { return spi_recv_byte(&sd1); }
+static void spi_send_block1(const UBYTE *buf, UWORD len) { spi_a2560m_send_block((volatile UBYTE *)sd1.data, buf, len); }
+static void spi_recv_block1(UBYTE *buf, UWORD len) { spi_a2560m_recv_block((volatile UBYTE *)sd1.data, buf, len); }
 const SPI_DRIVER spi_a2560m_sd1 = {
     spi_initialise1,
     spi_clock_sd1,
@@ -172,6 +178,8 @@ const SPI_DRIVER spi_a2560m_sd1 = {
     spi_cs_unassert1,
     spi_send_byte1,
     spi_recv_byte1,
+    spi_send_block1,
+    spi_recv_block1,
     just_rts,
     just_rts
 };
@@ -195,6 +195,18 @@ ULONG temp;
     return LOBYTE(temp);
 }
 
+static void spi_send_block(const UBYTE *buf, UWORD len)
+{
+    while (len--)
+        spi_send_byte(*buf++);
+}
+
+static void spi_recv_block(UBYTE *buf, UWORD len)
+{
+    while (len--)
+        *buf++ = spi_recv_byte();
+}
+
 const SPI_DRIVER spi_coldfire_driver = {
     spi_initialise,
     spi_clock_sd,
@@ -204,6 +216,8 @@ const SPI_DRIVER spi_coldfire_driver = {
     spi_cs_unassert,
     spi_send_byte,
     spi_recv_byte,
+    spi_send_block,
+    spi_recv_block,
     just_rts,
     just_rts
 };
@@ -79,6 +79,8 @@ const SPI_DRIVER spi_gavin_driver = {
     spi_cs_unassert,
     spi_send_byte,
     spi_recv_byte,
+    spi_gavin_send_block,
+    spi_gavin_recv_block,
     led_on,
     led_off
 };
@@ -79,6 +79,18 @@ static UBYTE spi_recv_byte(void)
     return SAGA_SDCARD_DATA;
 }
 
+static void spi_send_block(const UBYTE *buf, UWORD len)
+{
+    while (len--)
+        spi_send_byte(*buf++);
+}
+
+static void spi_recv_block(UBYTE *buf, UWORD len)
+{
+    while (len--)
+        *buf++ = spi_recv_byte();
+}
+
 
 const SPI_DRIVER spi_vamp_driver = {
     spi_initialise,
@@ -89,6 +101,8 @@ const SPI_DRIVER spi_vamp_driver = {
     spi_cs_unassert,
     spi_send_byte,
     spi_recv_byte,
+    spi_send_block,
+    spi_recv_block,
     just_rts,
     just_rts
 };
@@ -14,7 +14,7 @@
 
 /* #define ENABLE_KDEBUG */
 
-#include "config.h"
+#include "emutos.h"
 #include "timer.h"
 #include "tosvars.h"
 
@@ -30,7 +30,13 @@
 #include "ikbd.h"
 #include "keyboard.h" /* for key_repeat_tick */
 #include "sound.h"
+#include "asm.h"
+#include "gemerror.h"
 #include "../foenix/timer.h"
+#if CONF_WITH_TIMER_HOOKS && (defined(MACHINE_A2560U) || defined(MACHINE_A2560K) || defined(MACHINE_A2560M) || defined(MACHINE_A2560X) || defined(MACHINE_GENX))
+# include "../foenix/foenix.h"
+# include "../foenix/regutils.h"
+#endif
 
 /* Non-Atari hardware vectors */
 #if !CONF_WITH_MFP
@@ -44,20 +50,151 @@ void (*vector_5ms)(void);       /* 200 Hz system timer */
 WORD timer_c_sieve;
 
 
+#if CONF_WITH_TIMER_HOOKS
+
+/*
+ * Routines called by the system timer, registered with Tmrhook().
+ * A hook is enabled when its bit is set in timer_hooks_200hz or
+ * timer_hooks_50hz, so the interrupt handler only has to test a word
+ * when there is nothing to do.
+ */
+TIMERHOOK timer_hooks[CONF_TIMER_HOOKS];
+UWORD timer_hooks_200hz;
+UWORD timer_hooks_50hz;
+
+/*
+ * The time spent in the hooks is measured with the counter of the
+ * timer generating the 200 Hz interrupt, when we can read it.
+ */
+#if defined(MACHINE_A2560U) || defined(MACHINE_A2560K) || defined(MACHINE_A2560M) || defined(MACHINE_A2560X) || defined(MACHINE_GENX)
+# define HOOK_CLOCK()       R32(TIMER2_VALUE)   /* counts up, at the CPU clock */
+# define HOOK_PERIOD()      R32(TIMER2_COMPARE)
+#elif CONF_WITH_MFP && !CONF_COLDFIRE_TIMER_C
+# define HOOK_CLOCK()       (ULONG)(192 - MFP_BASE->tcdr)   /* timer C counts down from 192 */
+# define HOOK_PERIOD()      192UL
+#else
+# define HOOK_CLOCK()       0UL
+# define HOOK_PERIOD()      0UL
+#endif
+
+static void run_timer_hooks(UWORD mask)
+{
+    TIMERHOOK *hook;
+    ULONG start, end;
+
+    for (hook = timer_hooks; mask; mask >>= 1, hook++) {
+        if (!(mask & 1))
+            continue;
+
+        start = HOOK_CLOCK();
+        hook->func();
+        end = HOOK_CLOCK();
+        if (end < start)
+            end += HOOK_PERIOD();
+
+        hook->calls++;
+        hook->time += end - start;
+        if (end - start > hook->max_time)
+            hook->max_time = end - start;
+    }
+}
+
+/* Called from int_timerc when timer_hooks_200hz is not zero */
+void timer_run_200hz_hooks(void);
+void timer_run_200hz_hooks(void)
+{
+    run_timer_hooks(timer_hooks_200hz);
+}
+
+static void enable_timer_hook(WORD n, BOOL enable)
+{
+    UWORD bit = 1 << n;
+    WORD old_sr = set_sr(0x2700);
+
+    timer_hooks_200hz &= ~bit;
+    timer_hooks_50hz &= ~bit;
+    if (enable) {
+        if (timer_hooks[n].flags & TH_200HZ)
+            timer_hooks_200hz |= bit;
+        else
+            timer_hooks_50hz |= bit;
+    }
+
+    set_sr(old_sr);
+}
+
+/*
+ * XBIOS function: install, remove, enable or disable a timer hook,
+ * or get its statistics.  For TH_INSTALL, arg is the TH_xxx flags and
+ * the number of the new hook is returned; for the others, arg is the
+ * hook number.
+ */
+LONG tmrhook(WORD mode, WORD arg, PFVOID func)
+{
+    WORD n;
+
+    switch(mode) {
+    case TH_INSTALL:
+        if (!func)
+            return EBADRQ;
+        for (n = 0; n < CONF_TIMER_HOOKS; n++) {
+            if (!timer_hooks[n].func)
+                break;
+        }
+        if (n == CONF_TIMER_HOOKS)
+            return ENSMEM;
+        timer_hooks[n].func = func;
+        timer_hooks[n].flags = arg;
+        timer_hooks[n].calls = timer_hooks[n].time = timer_hooks[n].max_time = 0;
+        enable_timer_hook(n, TRUE);
+        KDEBUG(("timer hook %d: %p, flags %04x\n", n, func, arg));
+        return n;
+    case TH_CLOCK:
+        return HOOK_PERIOD() * 200;
+    }
+
+    if (arg < 0 || arg >= CONF_TIMER_HOOKS || !timer_hooks[arg].func)
+        return ERANGE;
+
+    switch(mode) {
+    case TH_REMOVE:
+        enable_timer_hook(arg, FALSE);
+        timer_hooks[arg].func = NULL;
+        break;
+    case TH_ENABLE:
+        enable_timer_hook(arg, TRUE);
+        break;
+    case TH_DISABLE:
+        enable_timer_hook(arg, FALSE);
+        break;
+    case TH_INFO:
+        return (LONG)&timer_hooks[arg];
+    default:
+        return EBADRQ;
+    }
+
+    return E_OK;
+}
+
+#endif /* CONF_WITH_TIMER_HOOKS */
+
+
 // Called from timer_S.s 200Hz timer irq handler
 void timer_20ms_routine(void);
 
-// TODO: have a list like the VBL list so users can hook into without having to
-// hook the full timer C vector, so here wouldn't have to depend on the GEM etv_timer as
-// this is a layering breakage.
 void timer_20ms_routine(void)
 {
+#if CONF_WITH_TIMER_HOOKS
+    // Key repeat, Dosound() and the drivers' routines
+    run_timer_hooks(timer_hooks_50hz);
+#else
     // Repeat keys
     key_repeat_tick();
 
 #if CONF_WITH_YM2149
     // Play Dosound() if appropriate
     sndirq();
+#endif
 #endif
 
     // GEM
@@ -73,6 +210,14 @@ void init_system_timer(void)
     /* The system timer is initially disabled since the sieve is zero (see note above) */
     timer_ms = 20;
 
+#if CONF_WITH_TIMER_HOOKS
+    /* These are called first, as they always were */
+    tmrhook(TH_INSTALL, TH_50HZ, key_repeat_tick);
+# if CONF_WITH_YM2149
+    tmrhook(TH_INSTALL, TH_50HZ, sndirq);
+# endif
+#endif
+
 #if !CONF_WITH_MFP
     vector_5ms = int_timerc;
 #endif
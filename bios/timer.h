@@ -42,4 +42,29 @@ void timer_start_20ms_routine(void);
 /* XBIOS function */
 void xbtimer(WORD timer, WORD control, WORD data, LONG vector);
 
+#if CONF_WITH_TIMER_HOOKS
+/* Tmrhook() modes */
+#define TH_INSTALL  0   /* Tmrhook(TH_INSTALL, flags, func) returns the hook number */
+#define TH_REMOVE   1   /* Tmrhook(TH_REMOVE, hook, NULL) */
+#define TH_ENABLE   2   /* Tmrhook(TH_ENABLE, hook, NULL) */
+#define TH_DISABLE  3   /* Tmrhook(TH_DISABLE, hook, NULL) */
+#define TH_INFO     4   /* Tmrhook(TH_INFO, hook, NULL) returns a TIMERHOOK * */
+#define TH_CLOCK    5   /* Tmrhook(TH_CLOCK, 0, NULL) returns the frequency of the time unit, 0 if time is not measured */
+
+/* Tmrhook() flags */
+#define TH_50HZ     0x0000  /* Call every 4th tick, before etv_timer */
+#define TH_200HZ    0x0001  /* Call every tick */
+
+typedef struct {
+    PFVOID func;        /* Routine, NULL if the slot is free */
+    WORD flags;         /* TH_xxx */
+    ULONG calls;        /* Number of calls */
+    ULONG time;         /* Total time spent in the routine, see TH_CLOCK */
+    ULONG max_time;     /* Longest call */
+} TIMERHOOK;
+
+/* XBIOS function */
+LONG tmrhook(WORD mode, WORD arg, PFVOID func);
+#endif
+
 #endif
\ No newline at end of file
@@ -52,11 +52,10 @@ void vbl_handler(void) {
     conout_blink_cursor();
 #endif
 
-#if CONF_WITH_A2560_SHADOW_FRAMEBUFFER && 0 /* Disabled because I'm trying something different (write both to SRAM and VRAM )*/
-    if (!a2560_bios_sfb_is_active) {
-        a2560_sfb_addr = v_bas_ad;
+#if CONF_WITH_A2560_SHADOW_FRAMEBUFFER
+    /* Copy the tiles drawn since the last VBL to VRAM */
+    if (a2560_bios_sfb_is_active)
         a2560_sfb_copy_fb_to_vram();
-    }
 #endif
 
     // Support of Setpalette
@@ -82,6 +82,7 @@ static void ascii_lf(void);
 static void ascii_cr(void);
 
 /* handlers for the console state machine */
+static void normal_ascii(WORD);
 static void esc_ch1(WORD);
 static void get_row(WORD);
 static void get_column(WORD);
@@ -168,6 +169,40 @@ void cputc(WORD ch)
 }
 
 
+/*
+ * cputs - console output of a buffer
+ *
+ * Same as calling cputc() for each character, but runs of printable
+ * characters are drawn in one go, so the cursor is only updated once per
+ * run and the cells are addressed once per line.
+ */
+void cputs(const UBYTE *buf, LONG count)
+{
+    const UBYTE *start;
+    UWORD n;
+
+    while (count > 0) {
+        if (con_state != normal_ascii || *buf < ' ') {
+            /* escape sequences and control characters go the usual way */
+            cputc(*buf++);
+            count--;
+            continue;
+        }
+
+        start = buf;
+        do {
+#if CONF_SERIAL_CONSOLE
+            bconout(1, *buf);
+#endif
+            buf++;
+            count--;
+        } while (count > 0 && *buf >= ' ' && buf - start < 0x7fff);
+        n = buf - start;
+        conout_ascii_run(start, n);
+    }
+}
+
+
 /*
  * normal_ascii - state is normal output
  */
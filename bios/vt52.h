@@ -19,5 +19,6 @@
 void vt52_init(void);               /* initialize the vt52 console */
 WORD cursconf(WORD, WORD);          /* XBIOS cursor configuration */
 void cputc(WORD);
+void cputs(const UBYTE *buf, LONG count);  /* cputc() for a whole buffer */
 
 #endif /* VT52_H */
@@ -1246,6 +1246,17 @@ static LONG xbios_8d(LONG sptr)
 
 #endif
 
+/*
+ * xbios_8e - (Tmrhook) EmuTOS extension, see timer.c
+ */
+#if DBG_XBIOS && CONF_WITH_TIMER_HOOKS
+static LONG xbios_8e(WORD mode, WORD arg, PFVOID func)
+{
+    kprintf("XBIOS: Tmrhook\n");
+    return tmrhook(mode, arg, func);
+}
+#endif
+
 /*
  * xbios_unimpl
  *
@@ -1275,7 +1286,9 @@ LONG supexec(PFLONG);       /* defined in vectors.S */
 #define VEC(wrapper, direct) (PFLONG) direct
 #endif
 
-#if CONF_WITH_DMASOUND
+#if CONF_WITH_TIMER_HOOKS
+# define LAST_ENTRY 0x8e
+#elif CONF_WITH_DMASOUND
 # define LAST_ENTRY 0x8d
 #elif CONF_WITH_DSP
 # define LAST_ENTRY 0x7f
@@ -1525,7 +1538,26 @@ const PFLONG xbios_vecs[] = {
     VEC(xbios_8b, devconnect),  /* 8b */
     VEC(xbios_8c, sndstatus),   /* 8c */
     VEC(xbios_8d, buffptr),     /* 8d */
+#elif LAST_ENTRY > 0x8d     /* must insert fillers for sound opcodes */
+    xbios_unimpl,   /* 80 */
+    xbios_unimpl,   /* 81 */
+    xbios_unimpl,   /* 82 */
+    xbios_unimpl,   /* 83 */
+    xbios_unimpl,   /* 84 */
+    xbios_unimpl,   /* 85 */
+    xbios_unimpl,   /* 86 */
+    xbios_unimpl,   /* 87 */
+    xbios_unimpl,   /* 88 */
+    xbios_unimpl,   /* 89 */
+    xbios_unimpl,   /* 8a */
+    xbios_unimpl,   /* 8b */
+    xbios_unimpl,   /* 8c */
+    xbios_unimpl,   /* 8d */
 #endif /* CONF_WITH_XBIOS_SOUND */
+
+#if CONF_WITH_TIMER_HOOKS
+    VEC(xbios_8e, tmrhook),     /* 8e */
+#endif
 };
 
 const UWORD xbios_ent = ARRAY_SIZE(xbios_vecs);
@@ -122,7 +122,17 @@ static long XHInqDev2(UWORD drv, UWORD *major, UWORD *minor, ULONG *start,
 
     myBPB = (BPB *)blkdev_getbpb(drv);
     if (bpb && myBPB)
+    {
         memcpy(bpb, myBPB, sizeof(BPB));
+#if CONF_WITH_FAT32
+        /*
+         * XHDI clients expect an invalid BPB for FAT32 partitions,
+         * since they must handle these themselves
+         */
+        if (myBPB->b_flags & B_32)
+            bpb->recsiz = 0;
+#endif
+    }
 
     if (blocks)
         *blocks = blkdev[drv].size;
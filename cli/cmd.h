@@ -50,6 +50,7 @@ extern LONG jmp_xbios(WORD, ...);
 #define jmp_gemdos_wppp(a,b,c,d,e)  jmp_gemdos((WORD)(a),(WORD)(b),(void *)(c),(void *)(d),(void *)(e))
 #define jmp_bios_w(a,b)         jmp_bios((WORD)(a),(WORD)(b))
 #define jmp_bios_ww(a,b,c)      jmp_bios((WORD)(a),(WORD)(b),(WORD)(c))
+#define jmp_bios_wlp(a,b,c,d)   jmp_bios((WORD)(a),(WORD)(b),(LONG)(c),(void *)(d))
 #define jmp_xbios_v(a)          jmp_xbios((WORD)(a))
 #define jmp_xbios_l(a,b)        jmp_xbios((WORD)(a),(LONG)(b))
 #define jmp_xbios_llww(a,b,c,d,e)   jmp_xbios((WORD)a,(LONG)b,(LONG)c,(WORD)d,(WORD)e)
@@ -78,11 +79,13 @@ extern LONG jmp_xbios(WORD, ...);
 #define Pexec(a,b,c,d)      jmp_gemdos_wppp(0x4b,a,b,c,d)
 #define Fsfirst(a,b)        jmp_gemdos_pw(0x4e,a,b)
 #define Fsnext()            jmp_gemdos_v(0x4f)
+#define Fsnextn(a,b)        jmp_gemdos_pw(0x50,a,b)
 #define Frename(a,b,c)      jmp_gemdos_wpp(0x56,a,b,c)
 
 #define Bconstat(a)         jmp_bios_w(0x01,a)
 #define Bconin(a)           jmp_bios_w(0x02,a)
 #define Bconout(a,b)        jmp_bios_ww(0x03,a,b)
+#define Bconws(a,b,c)       jmp_bios_wlp(0x0f,a,b,c)
 
 #define Getrez()            jmp_xbios_v(0x04)
 #define Setscreen(a,b,c,d)  jmp_xbios_llww(0x05,a,b,c,d)
@@ -161,6 +164,7 @@ typedef LONG FUNC(WORD argc,char **argv);
 /*
  *  manifest constants
  */
+#define EINVFN          -32
 #define EFILNF          -33
 #define EPTHNF          -34
 #define ENHNDL          -35
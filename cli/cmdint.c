@@ -27,10 +27,11 @@ typedef struct {
  */
 PRIVATE LONG check_path_component(char *component);
 PRIVATE LONG copy_move(WORD argc,char **argv,WORD delete);
-PRIVATE void display_dta_detail(void);
+PRIVATE void display_dta_detail(const DTA *d);
 PRIVATE char *extract_path(char *dest,const char *src);
 PRIVATE void fixup_filespec(char *filespec);
 PRIVATE char getyn(void);
+PRIVATE LONG ls_next(DTA **pdta,WORD *pleft);
 PRIVATE void help_display(const COMMAND *p);
 PRIVATE WORD help_lines(const COMMAND *p);
 PRIVATE WORD help_pause(void);
@@ -166,6 +167,13 @@ static LONG run_testmouse(WORD argc, char **argv)
 }
 #endif
 
+/*
+ *  buffer for directory entries fetched by Fsnextn()
+ */
+#define LS_BATCH        16
+LOCAL DTA ls_batch[LS_BATCH];
+LOCAL WORD no_fsnextn;          /* set if Fsnextn() is not available */
+
 /*
  *  command table
  */
@@ -403,8 +411,9 @@ PRIVATE LONG run_ls(WORD argc,char **argv)
 {
 char filespec[MAXPATHLEN];
 char buf[20];
+DTA *d;
 LONG rc;
-WORD names_per_line, n;
+WORD names_per_line, n, left;
 WORD detail = 0;
 
     if (argc > 1) {
@@ -426,14 +435,14 @@ WORD detail = 0;
         output(_("Listing of "));
         outputnl(filespec);
     }
-    for (rc = Fsfirst(filespec,0x17), n = 0; rc == 0; rc = Fsnext()) {
+    for (rc = Fsfirst(filespec,0x17), n = 0, d = dta, left = 1; rc == 0; rc = ls_next(&d,&left)) {
         if (constat())
             if (user_input(-1))
                 return USER_BREAK;
         if (detail) {
-            display_dta_detail();
-        } else if (dta->d_fname[0] != '.') {
-            padname(buf,dta->d_fname);
+            display_dta_detail(d);
+        } else if (d->d_fname[0] != '.') {
+            padname(buf,d->d_fname);
             output(buf);
             if (++n >= names_per_line) {
                 outputnl("");
@@ -1137,30 +1146,65 @@ WORD i;
     *buf = '\0';
 }
 
-PRIVATE void display_dta_detail(void)
+PRIVATE void display_dta_detail(const DTA *d)
 {
 char buf[80], *p = buf;
 
-    p += sprintf(buf,"%-13.13s",dta->d_fname);
-    p += decode_date_time(p,dta->d_date,dta->d_time);
+    p += sprintf(buf,"%-13.13s",d->d_fname);
+    p += decode_date_time(p,d->d_date,d->d_time);
 
-    if (dta->d_attrib & 0x10) {
+    if (d->d_attrib & 0x10) {
         strcpy(p,"<dir>");
     } else {
-        sprintf(p,"%15lu",dta->d_length);
+        sprintf(p,"%15lu",d->d_length);
         p++;
-        if (dta->d_attrib & 0x01)
+        if (d->d_attrib & 0x01)
             *p++= 'r';
-        if (dta->d_attrib & 0x02)
+        if (d->d_attrib & 0x02)
             *p++ = 'h';
-        if (dta->d_attrib & 0x04)
+        if (d->d_attrib & 0x04)
             *p = 's';
-        if (!(dta->d_attrib & 0x07))
+        if (!(d->d_attrib & 0x07))
             *p = '-';
     }
     outputnl(buf);
 }
 
+/*
+ *  get the next directory entry for run_ls(), fetching LS_BATCH entries
+ *  at a time with Fsnextn().  *pdta points to the current entry, and
+ *  *pleft is the number of entries left in the batch, including the
+ *  current one.  if we are not running under EmuTOS (or an older
+ *  version), we fall back to Fsnext() into the DTA.
+ */
+PRIVATE LONG ls_next(DTA **pdta,WORD *pleft)
+{
+LONG rc;
+
+    if (--(*pleft) > 0) {
+        (*pdta)++;
+        return 0L;
+    }
+
+    if (!no_fsnextn) {
+        rc = Fsnextn(ls_batch,LS_BATCH);
+        if (rc != EINVFN) {
+            if (rc > 0L) {
+                *pdta = ls_batch;
+                *pleft = rc;
+                rc = 0L;
+            }
+            return rc;
+        }
+        no_fsnextn = 1;
+    }
+
+    *pdta = dta;
+    *pleft = 1;
+
+    return Fsnext();
+}
+
 PRIVATE LONG is_valid_drive(char drive_letter)
 {
 ULONG drvbits;
@@ -1270,7 +1314,7 @@ PRIVATE void outputnl(const char *s)
  */
 PRIVATE LONG outputbuf(const char *s,LONG len,WORD paging)
 {
-LONG n, rc;
+LONG n, rc, run;
 char c, cprev = 0, response;
 
     if (redir_handle < 0L) {
@@ -1279,6 +1323,15 @@ char c, cprev = 0, response;
             if (constat())
                 if (user_input(-1))
                     return USER_BREAK;
+            /* output up to the next newline in one go, if the BIOS can */
+            for (run = 0; (run <= n) && (s[run] != '\n'); run++)
+                ;
+            if ((run > 1) && (Bconws(2,run,s) == run)) {
+                s += run;
+                n -= run - 1;
+                cprev = s[-1];
+                continue;
+            }
             c = *s++;
             /* convert Un*x-style text to TOS-style */
             if ((c == '\n') && (cprev != '\r'))
@@ -522,14 +522,44 @@ static void update_modified_windows(char *path,WORD length)
 }
 
 
+/*
+ *  Get the next entry of a search started by dos_sfirst() into dtabuf[0],
+ *  which must be the current DTA.  Entries are fetched DTA_BATCH-1 at a
+ *  time into the rest of dtabuf[].  *pdta points to the current entry,
+ *  and *pn is the number of entries left in the batch, including the
+ *  current one: they must be initialised to dtabuf and 1 respectively.
+ *
+ *  Returns 0 (next entry is at *pdta) or the error from dos_snextn()
+ */
+WORD snext_batch(DTA *dtabuf, DTA **pdta, WORD *pn)
+{
+    WORD ret;
+
+    if (--(*pn) > 0)
+    {
+        (*pdta)++;
+        return 0;
+    }
+
+    ret = dos_snextn(dtabuf+1, DTA_BATCH-1);
+    if (ret < 0)
+        return ret;
+
+    *pn = ret;
+    *pdta = dtabuf + 1;
+
+    return 0;
+}
+
+
 /*
  *  Directory routine to DO an operation on an entire sub-directory
  */
 WORD d_doop(WORD level, WORD op, char *psrc_path, char *pdst_path, OBJECT *tree, DIRCOUNT *count)
 {
     char *ptmp, *ptmpdst;
-    DTA  *dta, *prevdta;
-    WORD more, ret = 0;
+    DTA  *dtabuf, *dta, *prevdta;
+    WORD more, n, ret = 0;
 
     /*
      * ensure we don't exceed allowed depth
@@ -538,8 +568,8 @@ WORD d_doop(WORD level, WORD op, char *psrc_path, char *pdst_path, OBJECT *tree,
         ret = -1;
     else
     {
-        dta = dos_alloc_anyram(sizeof(DTA));
-        if (!dta)
+        dtabuf = dos_alloc_anyram(DTA_BATCH*sizeof(DTA));
+        if (!dtabuf)
             ret = -1;
     }
     if (ret < 0)
@@ -553,9 +583,9 @@ WORD d_doop(WORD level, WORD op, char *psrc_path, char *pdst_path, OBJECT *tree,
 
     /* save old DTA, use new DTA for this level */
     prevdta = dos_gdta();
-    dos_sdta(dta);
+    dos_sdta(dtabuf);
 
-    for (ret = dos_sfirst(psrc_path, ALLFILES); ; ret = dos_snext())
+    for (ret = dos_sfirst(psrc_path, ALLFILES), dta = dtabuf, n = 1; ; ret = snext_batch(dtabuf, &dta, &n))
     {
         more = TRUE;
         /*
@@ -682,7 +712,7 @@ WORD d_doop(WORD level, WORD op, char *psrc_path, char *pdst_path, OBJECT *tree,
 
     /* restore old DTA, free current DTA */
     dos_sdta(prevdta);
-    dos_free(dta);
+    dos_free(dtabuf);
 
     return more;
 }
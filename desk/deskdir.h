@@ -19,6 +19,8 @@ typedef struct {    /* #files/#folders/total filesize of directory & its subdire
     LONG size;
 } DIRCOUNT;
 
+#define DTA_BATCH   16  /* number of DTAs used by snext_batch() */
+
 /*
  * function prototypes
  */
@@ -27,6 +29,7 @@ void draw_dial(OBJECT *tree);
 char *add_fname(char *path, char *new_name);
 void del_fname(char *pstr);
 void add_path(char *path, char *new_name);
+WORD snext_batch(DTA *dtabuf, DTA **pdta, WORD *pn);
 WORD d_doop(WORD level, WORD op, char *psrc_path, char *pdst_path, OBJECT *tree, DIRCOUNT *count);
 WORD dir_op(WORD op, WORD icontype, PNODE *pspath, char *pdst_path, DIRCOUNT *count);
 WORD illegal_op_msg(void);
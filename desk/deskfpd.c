@@ -226,10 +226,10 @@ FNODE *pn_sort(PNODE *pn)
  */
 WORD pn_active(PNODE *pn, BOOL include_folders)
 {
-    DTA *dtasave;
+    DTA *dtasave, *dtabuf, *dta;
     FNODE *fn, *prev;
     LONG maxmem, maxcount, size = 0L;
-    WORD count, ret;
+    WORD count, n, ret;
 #if CONF_WITH_FILEMASK
     char search[MAXPATHLEN];
     char *match;
@@ -237,6 +237,13 @@ WORD pn_active(PNODE *pn, BOOL include_folders)
 
     fl_free(pn);                    /* free any existing filenodes */
 
+    /*
+     * the DTA, plus a buffer for directory entries fetched in batches.
+     * if there's no memory for that, use G.g_wdta one entry at a time.
+     */
+    dtabuf = dos_alloc_anyram(DTA_BATCH*sizeof(DTA));
+    dta = dtabuf ? dtabuf : &G.g_wdta;
+
     maxmem = dos_avail_anyram();    /* allocate max possible memory */
     maxcount = maxmem / sizeof(FNODE);
     if (maxcount)
@@ -246,7 +253,7 @@ WORD pn_active(PNODE *pn, BOOL include_folders)
     prev = (FNODE *)&pn->p_flist;   /* assumes fnode link is at start of fnode */
 
     dtasave = dos_gdta();           /* so we can preserve it */
-    dos_sdta(&G.g_wdta);
+    dos_sdta(dta);
 
 #if CONF_WITH_FILEMASK
     strcpy(search, pn->p_spec);
@@ -256,19 +263,21 @@ WORD pn_active(PNODE *pn, BOOL include_folders)
     if (include_folders)                /* match all folders? */
         del_fname(search);              /* yes - change search filespec to *.* */
     match = filename_start(pn->p_spec); /* the match filespec is always unaltered */
-    for (ret = dos_sfirst(search, pn->p_attr), count = 0; (ret == 0) && (count < maxcount); ret = dos_snext())
+    for (ret = dos_sfirst(search, pn->p_attr), n = 1, count = 0; (ret == 0) && (count < maxcount);
+                ret = dtabuf ? snext_batch(dtabuf, &dta, &n) : dos_snext())
     {
-        if (G.g_wdta.d_attrib != FA_SUBDIR) /* skip *files* that don't match */
-            if (!wildcmp(match, G.g_wdta.d_fname))
+        if (dta->d_attrib != FA_SUBDIR) /* skip *files* that don't match */
+            if (!wildcmp(match, dta->d_fname))
                 continue;
 #else
-    for (ret = dos_sfirst(pn->p_spec,pn->p_attr), count = 0; (ret == 0) && (count < maxcount); ret = dos_snext())
+    for (ret = dos_sfirst(pn->p_spec,pn->p_attr), n = 1, count = 0; (ret == 0) && (count < maxcount);
+                ret = dtabuf ? snext_batch(dtabuf, &dta, &n) : dos_snext())
     {
 #endif
-        if (G.g_wdta.d_fname[0] == '.') /* skip "." & ".." entries */
+        if (dta->d_fname[0] == '.')     /* skip "." & ".." entries */
             continue;
         fn->f_selected = FALSE;
-        memcpy(&fn->f_attr, &G.g_wdta.d_attrib, 23);
+        memcpy(&fn->f_attr, &dta->d_attrib, 23);
         fn->f_seq = count++;
         size += fn->f_size;
         prev->f_next = fn;      /* link fnodes */
@@ -293,6 +302,8 @@ WORD pn_active(PNODE *pn, BOOL include_folders)
         KDEBUG(("Not enough FNODEs for folder %s\n",pn->p_spec));
 
     dos_sdta(dtasave);          /* restore original DTA for neatness */
+    if (dtabuf)
+        dos_free(dtabuf);
 
     return ((ret==ENMFIL) || (ret==EFILNF)) ? 0 : ret;
 }
@@ -184,6 +184,7 @@
 /* For speed codes, checkout uart16550.h */
 #elif defined (MACHINE_A2560X) || defined(MACHINE_A2560K) || defined(MACHINE_A2560M) || defined(MACHINE_GENX)
 #define UART16550_CLOCK 1843200UL
+#define UART16550_HIGH_SPEED      /* SuperIO UARTs can do 230400 & 460800bps */
 #define UART1       (SUPERIO_BASE+0x3F8)  /* Base address for UART 1 (COM1) */
 #define UART2       (SUPERIO_BASE+0x2F8)  /* Base address for UART 2 (COM2), the doc is wrong! */
 #endif
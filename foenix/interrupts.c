@@ -1,4 +1,5 @@
 #include <stdint.h>
+#include <stdbool.h>
 #include "foenix.h"
 #include "a2560.h"
 #include "a2560_debug.h"
@@ -10,6 +11,17 @@
 /* Interrupt handlers for each of the IRQ groups */
 void *a2560_irq_vectors[IRQ_GROUPS][16];
 
+/* Statistics for the sources handled by a2560_irq_dispatch */
+struct a2560_irq_stats_t a2560_irq_stats[IRQ_GROUPS][16];
+
+/* Bottom halves: sources whose handler is called with the interrupt
+ * priority level lowered to that of the interrupted code, after all
+ * pending sources have been acknowledged. Bits are only cleared at IPL 7. */
+static uint16_t bh_deferred[IRQ_GROUPS]; /* Sources to defer */
+static volatile uint16_t bh_pending[IRQ_GROUPS]; /* Deferred sources waiting */
+static uint32_t bh_stamp[IRQ_GROUPS][16]; /* When they were acknowledged */
+static volatile bool bh_running;
+
 void a2560_irq_init(void)
 {
     int i, j;
@@ -27,8 +39,12 @@ void a2560_irq_init(void)
 
         for (j=0; j<16; j++)
             a2560_irq_vectors[i][j] = a2560_rts;
+
+        bh_deferred[i] = bh_pending[i] = 0;
     }
 
+    a2560_irq_reset_stats();
+
     for (i=0x40; i<0x60; i++)
         cpu_set_vector(i,(uint32_t)a2560_rte); /* That's not even correct because it doesn't acknowledge interrupts */
 }
@@ -100,3 +116,167 @@ void *a2560_irq_set_handler(uint16_t irq_id, void *handler)
     a2560_debugnl("a2560_irq_set_handler(%04x,%p)", irq_id, handler);
     return old_handler;
 }
+
+
+/* Defer the handler of an interrupt to the bottom half. This is for sources which
+ * are dispatched through a2560_irq_dispatch (i.e. the VICKY sources) and whose
+ * handlers take long enough to cause other devices to lose data. */
+void a2560_irq_set_deferred(uint16_t irq_id, bool deferred)
+{
+    uint16_t sr = m68k_set_sr(0x2700);
+
+    if (deferred)
+        bh_deferred[irq_group(irq_id)] |= irq_mask(irq_id);
+    else
+        bh_deferred[irq_group(irq_id)] &= ~irq_mask(irq_id);
+
+    m68k_set_sr(sr);
+}
+
+
+const struct a2560_irq_stats_t *a2560_irq_get_stats(uint16_t irq_id)
+{
+    return &a2560_irq_stats[irq_group(irq_id)][irq_number(irq_id)];
+}
+
+
+void a2560_irq_reset_stats(void)
+{
+    struct a2560_irq_stats_t *stats = &a2560_irq_stats[0][0];
+    int i;
+    uint16_t sr = m68k_set_sr(0x2700);
+
+    for (i = 0; i < IRQ_GROUPS*16; i++, stats++)
+        stats->count = stats->lost = stats->time = stats->max_time = stats->max_latency = 0;
+
+    m68k_set_sr(sr);
+}
+
+
+/* Dispatcher ****************************************************************/
+
+/* Time stamps are taken from the 200Hz timer, which counts CPU clock cycles
+ * up to its compare value. Intervals longer than a tick are not accurate,
+ * but we're only interested in short ones. */
+static inline uint32_t irq_clock(void)
+{
+    return R32(TIMER2_VALUE);
+}
+
+static inline uint32_t irq_elapsed(uint32_t since)
+{
+    uint32_t now = irq_clock();
+
+    if (now < since)
+        now += R32(TIMER2_COMPARE);
+
+    return now - since;
+}
+
+/* Number of the lowest bit set in a non-zero word */
+static inline uint16_t irq_first_set(uint16_t bits)
+{
+    static const uint8_t lowest[16] = { 4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0 };
+    uint16_t n = 0;
+
+    if (!(bits & 0xff)) {
+        bits >>= 8;
+        n = 8;
+    }
+    if (!(bits & 0x0f)) {
+        bits >>= 4;
+        n += 4;
+    }
+
+    return n + lowest[bits & 0x0f];
+}
+
+static void irq_call(uint16_t group, uint16_t n, uint32_t since)
+{
+    struct a2560_irq_stats_t *stats = &a2560_irq_stats[group][n];
+    uint32_t start = irq_clock();
+    uint32_t t;
+
+    t = start - since;
+    if (start < since)
+        t += R32(TIMER2_COMPARE);
+    if (t > stats->max_latency)
+        stats->max_latency = t;
+
+    ((void(*)(void))a2560_irq_vectors[group][n])();
+
+    t = irq_elapsed(start);
+    stats->count++;
+    stats->time += t;
+    if (t > stats->max_time)
+        stats->max_time = t;
+}
+
+static void irq_run_bottom_halves(uint16_t old_sr)
+{
+    uint16_t group, n;
+
+    bh_running = true;
+
+    /* Pending bits are checked and cleared at IPL 7, the handlers are called with
+     * the IPL of the code we interrupted so the devices with a lower priority
+     * than ours can be serviced meanwhile. */
+    m68k_set_sr(0x2700);
+    for (;;)
+    {
+        for (group = 0; group < IRQ_GROUPS; group++)
+            if (bh_pending[group])
+                break;
+        if (group == IRQ_GROUPS)
+            break;
+
+        n = irq_first_set(bh_pending[group]);
+        bh_pending[group] &= ~(1 << n);
+
+        m68k_set_sr(0x2000 | (old_sr & 0x0700));
+        irq_call(group, n, bh_stamp[group][n]);
+        m68k_set_sr(0x2700);
+    }
+
+    bh_running = false;
+}
+
+/* Called by the interrupt handlers of the sources which are not vectored. It handles
+ * the pending sources of the group that are set in 'sources', lowest bit (highest
+ * priority) first, then calls the deferred handlers. old_sr is the SR of the
+ * interrupted code, it's restored by the caller. */
+void a2560_irq_dispatch(uint16_t group, uint16_t sources, uint16_t old_sr)
+{
+    volatile uint16_t *pending_reg = &((volatile uint16_t*)IRQ_PENDING_GRP0)[group];
+    uint32_t since;
+    uint16_t pending, n, bit;
+
+    while ((pending = *pending_reg & sources) != 0)
+    {
+        since = irq_clock();
+        do {
+            n = irq_first_set(pending);
+            bit = 1 << n;
+            pending &= ~bit;
+            *pending_reg = bit; /* Acknowledge */
+
+            if (bh_deferred[group] & bit) {
+                if (!(bh_pending[group] & bit)) {
+                    bh_stamp[group][n] = since;
+                    bh_pending[group] |= bit;
+                }
+                else
+                    a2560_irq_stats[group][n].lost++;
+            }
+            else
+                irq_call(group, n, since);
+        } while (pending);
+    }
+
+    if (!bh_running)
+        for (n = 0; n < IRQ_GROUPS; n++)
+            if (bh_pending[n]) {
+                irq_run_bottom_halves(old_sr);
+                break;
+            }
+}
@@ -2,6 +2,17 @@
 #define FOENIX_IRQ_H
 
 #include <stdint.h>
+#include <stdbool.h>
+
+/* Statistics of the sources handled by a2560_irq_dispatch. Times are in CPU cycles. */
+struct a2560_irq_stats_t
+{
+    uint32_t count;       /* Number of times the handler was called */
+    uint32_t lost;        /* Interrupts which happened again before their bottom half ran */
+    uint32_t time;        /* Total time spent in the handler */
+    uint32_t max_time;    /* Longest time spent in the handler */
+    uint32_t max_latency; /* Longest delay between acknowledging the interrupt and calling the handler */
+};
 
 void a2560_irq_init(void);
 void a2560_irq_mask_all(uint16_t *save);
@@ -10,5 +21,9 @@ void a2560_irq_enable(uint16_t irq_id);
 void a2560_irq_disable(uint16_t irq_id);
 void a2560_irq_acknowledge(uint8_t irq_id);
 void *a2560_irq_set_handler(uint16_t irq_id, void *handler);
+void a2560_irq_set_deferred(uint16_t irq_id, bool deferred);
+const struct a2560_irq_stats_t *a2560_irq_get_stats(uint16_t irq_id);
+void a2560_irq_reset_stats(void);
+void a2560_irq_dispatch(uint16_t group, uint16_t sources, uint16_t old_sr);
 
 #endif
\ No newline at end of file
@@ -4,34 +4,64 @@
  * The so-called Shadow Frame Buffer aims at working around this.
  * It works like this: in system RAM we have a memory which acts as video
  * memory. On VBL (a.k.a SOF), we copy that to Video RAM.
+ *
+ * To keep the copy short, the screen is divided into tiles of
+ * SFB_TILE_W x SFB_TILE_H pixels, and whoever draws into the shadow frame
+ * buffer marks the tiles it touched. For each row of tiles we keep a bitmap
+ * of the dirty columns, so marking is a couple of shifts and an OR whatever
+ * the size of the area, and the copier can merge consecutive dirty tiles
+ * into one span. Tiles are marked in screen coordinates.
+ *
+ * The console keeps its text lines in a ring: the text area covers the
+ * first sfb_ring_lines lines of the shadow frame buffer, and the top of the
+ * screen shows shadow line a2560_sfb_top. Scrolling the whole text area is
+ * then just a matter of moving a2560_sfb_top forward by one text line, and
+ * the copier follows the ring when it reads the shadow frame buffer. The
+ * lines below the text area, if any, are not part of the ring. Whoever
+ * draws the screen as a plain bitmap must call a2560_sfb_unwrap() first.
  */
 
 #include <stdint.h>
+#include <stdbool.h>
+#include "foenix.h"
 #include "a2560_debug.h"
+#include "cpu.h"
+#include "regutils.h"
 #include "shadow_fb.h"
 #include "vicky2.h"
 
-/* To speed up the copy from RAM to VRAM we manage a list of dirty cells */
-#define A2560U_DIRTY_CELLS_SIZE 256
-volatile struct
-{
-    uint16_t writer;
-    uint16_t reader;
-    uint16_t full_copy; /* Set this to non-zero to copy the whole frame buffer and flush the ring buffer */
-    uint8_t *cells[A2560U_DIRTY_CELLS_SIZE];
-} a2560_sfb_dirty_cells;
+/* Time we allow the copier to spend per frame, in TIMER2 (CPU clock) ticks.
+ * This must stay below the TIMER2 period (5ms). What doesn't fit is copied
+ * at the next VBL. */
+#define SFB_COPY_BUDGET (CPU_FREQ/500) /* 2ms */
 
+/* Dirty tile columns of each row of tiles, bit n is column n */
+volatile uint32_t a2560_sfb_dirty[SFB_MAX_TILE_ROWS];
 
 /* Size and address of the shadow frame buffer */
 uint8_t  *a2560_sfb_addr;
 uint32_t a2560_sfb_size;
 uint16_t a2560_sfb_line_size_in_bytes;
 uint16_t a2560_sfb_text_cell_height;
+uint16_t a2560_sfb_top;        /* shadow line shown at the top of the screen */
+
+static uint16_t sfb_width;     /* in pixels */
+static uint16_t sfb_height;
+static uint16_t sfb_ring_lines;
+static uint16_t sfb_tile_rows;
+static uint16_t sfb_next_row;  /* where the copier resumes */
+
+extern uint8_t *a2560_bios_vram_fb;
+void a2560_sfb_copy_span(const uint8_t *src, uint8_t *dst, uint16_t width, uint16_t lines, uint16_t stride);
 
 
 void a2560_sfb_init(void)
 {
-    a2560_sfb_dirty_cells.writer = a2560_sfb_dirty_cells.reader = a2560_sfb_dirty_cells.full_copy = 0;
+    uint16_t i;
+
+    for (i = 0; i < SFB_MAX_TILE_ROWS; i++)
+        a2560_sfb_dirty[i] = 0;
+    sfb_tile_rows = sfb_next_row = 0;
 }
 
 
@@ -44,12 +74,255 @@ void a2560_sfb_setup(const uint8_t *addr, uint16_t text_cell_height)
     a2560_sfb_text_cell_height = text_cell_height;
     
     vicky2_read_video_mode(vicky, &mode);
-    a2560_sfb_size = mode.w * mode.h;
+    a2560_sfb_size = (uint32_t)mode.w * mode.h;
     a2560_sfb_line_size_in_bytes = mode.w;
+
+    sfb_width = mode.w;
+    sfb_height = mode.h;
+    sfb_ring_lines = text_cell_height ? mode.h / text_cell_height * text_cell_height : mode.h;
+    a2560_sfb_top = 0;
+    sfb_tile_rows = (mode.h + SFB_TILE_H - 1) / SFB_TILE_H;
+    if (sfb_tile_rows > SFB_MAX_TILE_ROWS)
+        sfb_tile_rows = SFB_MAX_TILE_ROWS;
+    sfb_next_row = 0;
+
+    a2560_sfb_mark_screen_dirty();
+}
+
+
+void a2560_sfb_mark_rect(int16_t x1, int16_t y1, int16_t x2, int16_t y2)
+{
+    uint32_t columns;
+    uint16_t row, last;
+
+    /* Clip to the screen */
+    if (x1 < 0)
+        x1 = 0;
+    if (y1 < 0)
+        y1 = 0;
+    if (x2 >= (int16_t)sfb_width)
+        x2 = sfb_width - 1;
+    if (y2 >= (int16_t)sfb_height)
+        y2 = sfb_height - 1;
+    if (x1 > x2 || y1 > y2)
+        return;
+
+    x1 /= SFB_TILE_W;
+    x2 /= SFB_TILE_W;
+    columns = ((uint32_t)2 << x2) - ((uint32_t)1 << x1);
+
+    last = y2 / SFB_TILE_H;
+    for (row = y1 / SFB_TILE_H; row <= last; row++)
+        a2560_sfb_dirty[row] |= columns;
 }
 
 
 void a2560_sfb_mark_screen_dirty(void)
 {
-    a2560_sfb_dirty_cells.full_copy = -1;
+    a2560_sfb_mark_rect(0, 0, sfb_width - 1, sfb_height - 1);
+}
+
+
+void a2560_sfb_mark_cell_dirty(const uint8_t *cell_address)
+{
+    uint32_t offset = cell_address - a2560_sfb_addr;
+    uint16_t x, y;
+
+    if (offset >= a2560_sfb_size)
+        return;
+
+    y = offset / a2560_sfb_line_size_in_bytes;
+    x = offset - (uint32_t)y * a2560_sfb_line_size_in_bytes;
+    if (y < sfb_ring_lines)
+        y = y >= a2560_sfb_top ? y - a2560_sfb_top : y + sfb_ring_lines - a2560_sfb_top;
+    a2560_sfb_mark_rect(x, y, x + 7, y + a2560_sfb_text_cell_height - 1);
+}
+
+
+/* Shadow frame buffer line shown on screen line y */
+static uint16_t sfb_line(uint16_t y)
+{
+    if (y < sfb_ring_lines) {
+        y += a2560_sfb_top;
+        if (y >= sfb_ring_lines)
+            y -= sfb_ring_lines;
+    }
+    return y;
+}
+
+
+/* Copy an area of the screen to VRAM, splitting it where the ring wraps */
+static void sfb_copy_lines(uint16_t x, uint16_t y, uint16_t width, uint16_t lines, uint8_t *vram)
+{
+    const uint16_t line_size = a2560_sfb_line_size_in_bytes;
+    uint16_t src, n;
+
+    while (lines) {
+        src = sfb_line(y);
+        n = lines;
+        if (y < sfb_ring_lines) {
+            if (n > sfb_ring_lines - src)
+                n = sfb_ring_lines - src;
+            if (n > sfb_ring_lines - y)
+                n = sfb_ring_lines - y;
+        }
+        a2560_sfb_copy_span(a2560_sfb_addr + (uint32_t)src * line_size + x,
+            vram + (uint32_t)y * line_size + x, width, n, line_size);
+        y += n;
+        lines -= n;
+    }
+}
+
+
+/* Copy the dirty tiles to VRAM. This is called from the VBL handler.
+ * Writers can't interrupt us, so reading then clearing a row's bitmap is
+ * safe. If a writer is interrupted between reading and writing back the
+ * bitmap, the worst case is that it marks again tiles we just copied. */
+void a2560_sfb_copy_fb_to_vram(void)
+{
+    uint32_t start, now, columns;
+    uint16_t n, row, col, first, lines, width;
+
+    if (a2560_sfb_addr == a2560_bios_vram_fb)
+        return; /* Drawing goes directly to VRAM, nothing to do */
+
+    start = R32(TIMER2_VALUE);
+    row = sfb_next_row;
+    for (n = sfb_tile_rows; n; n--) {
+        columns = a2560_sfb_dirty[row];
+        if (columns) {
+            a2560_sfb_dirty[row] = 0;
+            lines = sfb_height - row * SFB_TILE_H;
+            if (lines > SFB_TILE_H)
+                lines = SFB_TILE_H;
+
+            /* Copy each run of consecutive dirty tiles in one go */
+            for (col = 0; columns; ) {
+                while (!(columns & 1)) {
+                    columns >>= 1;
+                    col++;
+                }
+                first = col;
+                while (columns & 1) {
+                    columns >>= 1;
+                    col++;
+                }
+                width = (col - first) * SFB_TILE_W;
+                if (width > sfb_width - first * SFB_TILE_W)
+                    width = sfb_width - first * SFB_TILE_W;
+                sfb_copy_lines(first * SFB_TILE_W, row * SFB_TILE_H, width, lines,
+                    a2560_bios_vram_fb);
+            }
+        }
+        if (++row == sfb_tile_rows)
+            row = 0;
+
+        /* Leave the rest for the next frame if we're over budget */
+        now = R32(TIMER2_VALUE);
+        if (now < start)
+            now += R32(TIMER2_COMPARE);
+        if (now - start > SFB_COPY_BUDGET)
+            break;
+    }
+    sfb_next_row = row;
+}
+
+
+/* The console scrolled its text area up by the given number of pixel lines,
+ * which must be a whole number of text lines: the top of the ring moves
+ * forward, and the caller clears and marks the line that comes round at the
+ * bottom. Rather than copying the whole screen to VRAM again, we move the
+ * VICKY bitmap address forward through VRAM by the same amount, and the
+ * pending tiles move up along with the contents. There is no wrap-around in
+ * the hardware, so when we reach the end of VRAM we copy the screen back to
+ * its start in one go, which only happens every few hundred lines.
+ * The copier must not run while the caller updates the ring. */
+void a2560_sfb_scroll(uint16_t lines)
+{
+    const uint32_t step = (uint32_t)lines * a2560_sfb_line_size_in_bytes;
+    uint8_t *vram = a2560_bios_vram_fb + step;
+    uint32_t columns;
+    uint16_t sr, row, shift;
+    bool wrapped, straddle;
+
+    a2560_sfb_top += lines;
+    if (a2560_sfb_top >= sfb_ring_lines)
+        a2560_sfb_top -= sfb_ring_lines;
+
+    wrapped = vram < (uint8_t *)VRAM_Bank0
+        || vram + a2560_sfb_size > (uint8_t *)(VRAM_Bank0 + VRAM0_SIZE);
+    if (wrapped) {
+        vram = (uint8_t *)VRAM_Bank0;
+        sfb_copy_lines(0, 0, sfb_width, sfb_height, vram);
+    }
+
+    /* Don't let the copier see a half-updated state */
+    sr = m68k_set_sr(0x2700);
+    a2560_bios_vram_fb = vram;
+    vicky2_set_bitmap_address(vicky, 0, (uint8_t *)((uint32_t)vram - (uint32_t)VRAM_Bank0));
+
+    if (wrapped) {
+        for (row = 0; row < sfb_tile_rows; row++)
+            a2560_sfb_dirty[row] = 0;
+    }
+    else {
+        /* When the contents move by part of a tile (8 pixel high fonts),
+         * each tile row gets the bottom of the one it moves to and the top
+         * of the one below, so it takes the dirty tiles of both. */
+        shift = lines / SFB_TILE_H;
+        straddle = (lines % SFB_TILE_H) != 0;
+        for (row = 0; row + shift < sfb_tile_rows; row++) {
+            columns = a2560_sfb_dirty[row + shift];
+            if (straddle && row + shift + 1 < sfb_tile_rows)
+                columns |= a2560_sfb_dirty[row + shift + 1];
+            a2560_sfb_dirty[row] = columns;
+        }
+        for (; row < sfb_tile_rows; row++)
+            a2560_sfb_dirty[row] = 0;
+
+        /* VRAM below the text area moved too, but the text didn't */
+        if (sfb_ring_lines < sfb_height)
+            a2560_sfb_mark_rect(0, sfb_ring_lines - lines, sfb_width - 1, sfb_height - 1);
+    }
+    m68k_set_sr(sr);
+}
+
+
+static void sfb_copy_line(uint8_t *dst, const uint8_t *src)
+{
+    a2560_sfb_copy_span(src, dst, a2560_sfb_line_size_in_bytes, 1, a2560_sfb_line_size_in_bytes);
+}
+
+
+/* Put the lines of the ring back in screen order, so that the shadow frame
+ * buffer is a plain bitmap again. Each line is moved once, following the
+ * cycles of the rotation through a one line buffer. What is on screen
+ * doesn't change, but the copier must not run meanwhile. */
+void a2560_sfb_unwrap(void)
+{
+    static uint8_t line[SFB_MAX_TILE_COLUMNS * SFB_TILE_W];
+    const uint16_t line_size = a2560_sfb_line_size_in_bytes;
+    const uint16_t n = sfb_ring_lines;
+    const uint16_t k = a2560_sfb_top;
+    uint16_t start, done, y, next;
+
+    if (k == 0)
+        return;
+
+    for (start = done = 0; done < n; start++) {
+        sfb_copy_line(line, a2560_sfb_addr + (uint32_t)start * line_size);
+        for (y = start; ; y = next) {
+            next = y + k;
+            if (next >= n)
+                next -= n;
+            if (next == start)
+                break;
+            sfb_copy_line(a2560_sfb_addr + (uint32_t)y * line_size,
+                a2560_sfb_addr + (uint32_t)next * line_size);
+            done++;
+        }
+        sfb_copy_line(a2560_sfb_addr + (uint32_t)y * line_size, line);
+        done++;
+    }
+    a2560_sfb_top = 0;
 }
@@ -3,12 +3,23 @@
 
 #include <stdint.h>
 
+/* Dirty areas are tracked in tiles of this size (in pixels). A row of tiles
+ * is a 32-bit bitmap, so the screen can be up to 32 tiles wide. */
+#define SFB_TILE_W 32
+#define SFB_TILE_H 16
+#define SFB_MAX_TILE_COLUMNS 32
+#define SFB_MAX_TILE_ROWS ((768 + SFB_TILE_H - 1) / SFB_TILE_H) /* 1024x768 */
+
 extern uint8_t  *a2560_sfb_addr;
+extern uint16_t a2560_sfb_top;
 
 void a2560_sfb_init(void);
 void a2560_sfb_setup(const uint8_t *addr, uint16_t text_cell_height);
+void a2560_sfb_mark_rect(int16_t x1, int16_t y1, int16_t x2, int16_t y2);
 void a2560_sfb_mark_screen_dirty(void);
 void a2560_sfb_mark_cell_dirty(const uint8_t *cell_address);
 void a2560_sfb_copy_fb_to_vram(void);
+void a2560_sfb_scroll(uint16_t lines);
+void a2560_sfb_unwrap(void);
 
-#endif
\ No newline at end of file
+#endif
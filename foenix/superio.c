@@ -126,6 +126,25 @@ static void activate(void) {
   *CONFIG_0x2F_REG = 0x01;
 }
 
+/*
+ * Enable or disable the high speed mode of a serial port (1 or 2). In that
+ * mode, divisors 0x8001 and 0x8002 select 460800 and 230400bps.
+ */
+void superio_uart_high_speed(int port, bool enable) {
+  uint8_t mode;
+
+  *CONFIG_0x2E_REG = 0x55;    /* Enter the Configuration Mode */
+  select_logical_device(port == 2 ? SUPERIO_LDN_COM2 : SUPERIO_LDN_COM1);
+  *CONFIG_0x2E_REG = 0xF0;    /* Serial Port Mode Register */
+  mode = *CONFIG_0x2F_REG;
+  if (enable)
+    mode |= 0x02;             /* High Speed */
+  else
+    mode &= ~0x02;
+  *CONFIG_0x2F_REG = mode;
+  *CONFIG_0x2E_REG = 0xAA;    /* Exit the Configuration Mode */
+}
+
 static void configure_zones(void) {
 	DONT_OPTIMIZE_OUT;
 
@@ -11,10 +11,12 @@
 #define __SUPERIO_H
 
 #include <stdint.h>
+#include <stdbool.h>
 
 
 
 void superio_init(void);
+void superio_uart_high_speed(int port, bool enable);
 
 
 #define CONFIG_0x2E_REG ((volatile uint8_t *)SUPERIO_BASE+0x02E)
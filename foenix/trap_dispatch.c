@@ -45,6 +45,8 @@ int32_t trap_dispatch(uint16_t *args_on_stack)
 	case FNX_IRQ_DISABLE: a2560_irq_disable(*((uint16_t*)args)); break;
 	case FNX_IRQ_ACKNOWLEDGE: a2560_irq_disable(*((uint16_t*)args)); break;; /* it's really uint8_t */
 	case FNX_IRQ_SET_HANDLER: { struct p_t { uint16_t a; void *b; } *p = (struct p_t*)args; a2560_irq_set_handler(p->a, p->b); break; }
+	case FNX_IRQ_SET_DEFERRED: { struct p_t { uint16_t a; uint16_t b; } *p = (struct p_t*)args; a2560_irq_set_deferred(p->a, p->b != 0); break; }
+	case FNX_IRQ_GET_STATS: return (int32_t)a2560_irq_get_stats(*((uint16_t*)args));
 
 	/* Timers */
 	case FNX_TIMER_INIT: a2560_timer_init(); break;
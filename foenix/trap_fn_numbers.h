@@ -20,6 +20,8 @@
 #define FNX_IRQ_DISABLE     (FNX_IRQ_FN_BASE+04)
 #define FNX_IRQ_ACKNOWLEDGE (FNX_IRQ_FN_BASE+05)
 #define FNX_IRQ_SET_HANDLER (FNX_IRQ_FN_BASE+06)
+#define FNX_IRQ_SET_DEFERRED (FNX_IRQ_FN_BASE+7)
+#define FNX_IRQ_GET_STATS   (FNX_IRQ_FN_BASE+8)
 
 /*  Timers */
 #define FNX_TIMER_BASE      40
@@ -35,11 +35,18 @@
 #define IER_TX      2 /* Transmit interrupt */
 #define IER_MODEM   4 /* Modem status interrupt */
 
+#define FCR_FIFO_ENABLE 0x01
+#define FCR_RX_RESET    0x02
+#define FCR_TX_RESET    0x04
+#define FCR_RX_TRIG_8   0x80 /* Receive interrupt when 8 bytes are in the FIFO */
+
 #define MCR_DTR     1
 #define MCR_RTS     2
 #define MCR_OUT1    4
 #define MCR_OUT2    8
 
+#define MSR_CTS     0x10
+
 #define R8(x) ((volatile uint8_t*)x) /* Convenience */
 
 void a2560_rts(uint16_t);
@@ -52,8 +59,10 @@ void uart16550_init(UART16550 *uart)
     uart16550_set_bps(uart, UART16550_9600BPS);
     uart16550_set_line(uart, UART16550_8D | UART16550_1S | UART16550_NOPARITY);
     uart16550_rx_handler = (void(*)(uint8_t))a2560_rts;
-    //uart[FCR] = 0b00100111; //0b00000110; // No FIFO, reset FIFOs. See 16C750B doc
-    uart[FCR] = 0xC1; /* 16550: Clear FIFOs, one byte buffer */
+    /* Enable & clear the FIFOs. Receive interrupts are requested when 8 bytes
+     * are waiting (or after a timeout), which leaves room for another 8 bytes
+     * if the interrupt is held off for a while at high speeds. */
+    R8(uart)[FCR] = FCR_FIFO_ENABLE | FCR_RX_RESET | FCR_TX_RESET | FCR_RX_TRIG_8;
 
     // Don't enable interrupts by default
     R8(uart)[IER] = 0;
@@ -87,6 +96,9 @@ uint32_t uart16550_bps_code_to_actual(uint16_t bps_code) {
         case UART16550_57600BPS: return 57600;
         case UART16550_115200BPS: return 115200;
         case UART16550_230400BPS: return 230400;
+#ifdef UART16550_HIGH_SPEED
+        case UART16550_460800BPS: return 460800;
+#endif
         default: return (UART16550_CLOCK/bps_code/16);
     }
 }
@@ -128,14 +140,23 @@ void uart16550_set_line(UART16550 *uart, uint8_t flags)
 
 void uart16550_put(UART16550 *uart, const uint8_t *bytes, uint32_t count)
 {
-    uint8_t *c = (uint8_t*)bytes;
+    const uint8_t *c = bytes;
+    int n;
 
-    while (count--)
+    while (count)
     {
         while (!uart16550_can_put(uart))
             ;
-        R8(uart)[THR] = *c++;
-    };
+        /* The transmit FIFO is empty, fill it */
+        for (n = 0; count && n < UART16550_FIFO_SIZE; n++, count--)
+            R8(uart)[THR] = *c++;
+    }
+}
+
+
+void uart16550_put_nowait(UART16550 *uart, uint8_t byte)
+{
+    R8(uart)[THR] = byte;
 }
 
 
@@ -147,7 +168,7 @@ bool uart16550_can_get(const UART16550 *uart)
 
 bool uart16550_can_put(const UART16550 *uart)
 {
-    return R8(uart)[LSR] & 0x20; /* bit 5: THR is empty */
+    return R8(uart)[LSR] & 0x20; /* bit 5: THR (the whole FIFO when enabled) is empty */
 }
 
 
@@ -169,3 +190,37 @@ void uart16550_rx_irq_enable(UART16550 *uart, bool enable) {
         uart[MCR] &= ~MCR_OUT2;
     }
 }
+
+
+/* The transmit interrupt is raised when the FIFO becomes empty. The receive
+ * interrupt must be enabled too, as it controls the interrupt line (OUT2). */
+void uart16550_tx_irq_enable(UART16550 *uart, bool enable) {
+    if (enable)
+        R8(uart)[IER] |= IER_TX;
+    else
+        R8(uart)[IER] &= ~IER_TX;
+}
+
+
+void uart16550_modem_irq_enable(UART16550 *uart, bool enable) {
+    if (enable)
+        R8(uart)[IER] |= IER_MODEM;
+    else
+        R8(uart)[IER] &= ~IER_MODEM;
+}
+
+
+/* Reading the MSR also acknowledges the modem status interrupt */
+bool uart16550_cts(const UART16550 *uart)
+{
+    return R8(uart)[MSR] & MSR_CTS;
+}
+
+
+void uart16550_set_rts(UART16550 *uart, bool on)
+{
+    if (on)
+        R8(uart)[MCR] |= MCR_RTS;
+    else
+        R8(uart)[MCR] &= ~MCR_RTS;
+}
@@ -41,7 +41,15 @@
 #define UART16550_38400BPS  (UART16550_CLOCK/38400/16)
 #define UART16550_57600BPS  (UART16550_CLOCK/57600/16)
 #define UART16550_115200BPS (UART16550_CLOCK/115200/16)
+#ifdef UART16550_HIGH_SPEED
+/* The SMSC SuperIO UARTs use these special divisors when in high speed mode */
+#define UART16550_HIGH_SPEED_DIVISOR 0x8000
+#define UART16550_230400BPS 0x8002
+#define UART16550_460800BPS 0x8001
+#else
 #define UART16550_230400BPS (UART16550_CLOCK/230400/16) /* We reserve the value but we can't actually do it with the Foenix */
+#define UART16550_460800BPS 0 /* Not possible */
+#endif
 
 #define UART16550_5D    0    /* Number of data bits */
 #define UART16550_6D    1
@@ -59,6 +67,9 @@
 #define UART16550_EBRK  0x40 /* Break signal enabled */
 
 
+#define UART16550_FIFO_SIZE 16 /* Transmit FIFO size */
+
+
 typedef uint8_t UART16550;
 
 void uart16550_init(UART16550 *uart);
@@ -67,10 +78,15 @@ uint16_t uart16550_get_bps_code(const UART16550 *uart);
 uint32_t uart16550_bps_code_to_actual(uint16_t bps_code);
 void uart16550_set_line(UART16550 *uart, uint8_t flags);
 void uart16550_put(UART16550 *uart, const uint8_t *bytes, uint32_t count);
+void uart16550_put_nowait(UART16550 *uart, uint8_t byte); // Make sure there's room in the FIFO
 uint8_t uart16550_get_nowait(const UART16550 *uart); // Make sure there's something to read otherwize you'll get garbage
 bool uart16550_can_get(const UART16550 *uart);
 bool uart16550_can_put(const UART16550 *uart);
 void uart16550_rx_irq_enable(UART16550 *uart, bool);
+void uart16550_tx_irq_enable(UART16550 *uart, bool);
+void uart16550_modem_irq_enable(UART16550 *uart, bool);
+bool uart16550_cts(const UART16550 *uart);
+void uart16550_set_rts(UART16550 *uart, bool on);
 
 /* Called by when a byte is received from the UART */
 extern void (*uart16550_rx_handler)(uint8_t byte);
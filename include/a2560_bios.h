@@ -40,11 +40,16 @@ void     a2560_bios_vsetrgb(int16_t index,int16_t count,const uint32_t *rgb);
 void     a2560_bios_vgetrgb(int16_t index,int16_t count,uint32_t *rgb);
 
 void a2560_bios_sfb_setup(uint8_t *addr, uint16_t text_cell_height);
+/* Make the shadow framebuffer a plain bitmap again, see shadow_fb.c */
+void a2560_bios_sfb_unwrap(void);
 
 /* Serial port */
 uint32_t a2560_bios_bcostat1(void);
 void a2560_bios_bconout1(uint8_t byte);
-void a2560_bios_rs232_init(void);
+void a2560_bios_bconout1_run(const uint8_t *buf, LONG count);
+void a2560_bios_rs232_init(EXT_IOREC *iorec);
+void a2560_bios_com1_tx_interrupt(void);
+void a2560_bios_com1_rx_drained(void);
 uint32_t a2560_bios_rsconf1(int16_t baud, EXT_IOREC *iorec, int16_t ctrl, int16_t ucr, int16_t rsr, int16_t tsr, int16_t scr);
 
 /* Timing stuff */
@@ -41,6 +41,9 @@ extern void just_rts(void);
 /* Wrapper around the STOP instruction. This preserves SR. */
 extern void stop_until_interrupt(void);
 
+/* Same, using the interrupt mask of sr and returning with sr set to it */
+extern void stop_with_sr(WORD sr);
+
 /* perform WORD multiply/divide with rounding */
 WORD mul_div_round(WORD mult1, WORD mult2, WORD divisor);
 
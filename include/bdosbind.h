@@ -50,6 +50,7 @@ extern long trap1_pexec(short mode, const char *path, const char *tail, const ch
 #define Pexec(mode,name,cmdline,env) trap1_pexec(mode, name, cmdline, env)
 #define Fsfirst(filename,attr) trap1(0x4e, filename, attr)
 #define Fsnext() trap1(0x4f)
+#define Fsnextn(buf,count) trap1(0x50, buf, count)
 #define Frename(oldname,newname) trap1(0x56, 0, oldname, newname)
 #define Fdatime(timeptr,handle,wflag) trap1(0x57, timeptr, handle, wflag)
 
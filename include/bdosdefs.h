@@ -127,5 +127,54 @@ struct _mpb
 
 #define PATH_ENV "PATH="    /* PATH environment variable */
 
+/*
+ *  BCSTATS - BDOS sector cache statistics
+ *
+ *  pointed to by ETSTATS.es_cache when the BDOS is built with
+ *  CONF_WITH_BDOS_CACHE.  the counters are only ever incremented.
+ */
+typedef struct
+{
+    UWORD   bs_nbufs[2];    /* number of buffers in FAT, dir/data lists */
+    ULONG   bs_hits;        /* lookups satisfied from the cache */
+    ULONG   bs_misses;      /* lookups that required a sector read */
+    ULONG   bs_writes;      /* dirty buffers written back to disk */
+} BCSTATS;
+
+/*
+ *  OSMSTATS - BDOS internal (OS) memory statistics
+ *
+ *  pointed to by ETSTATS.es_osmem when the BDOS is built with
+ *  CONF_WITH_BDOS_OSMEM_GROWTH.  the os_inuse[] and os_peak[]
+ *  entries are indexed by block type: MDBLOCK, DMD, DND, OFD.
+ */
+typedef struct
+{
+    UWORD   os_inuse[4];    /* blocks currently in use, by type */
+    UWORD   os_peak[4];     /* highest values of os_inuse[] */
+    UWORD   os_pool;        /* blocks in the initial (static) pool */
+    UWORD   os_chunksize;   /* blocks added each time the pool grows */
+    UWORD   os_chunks;      /* number of times the pool has grown */
+    UWORD   os_reclaims;    /* attempts to free unused DNDs for space */
+    UWORD   os_failures;    /* MDBLOCK requests that failed */
+} OSMSTATS;
+
+/*
+ *  ETSTATS - EmuTOS statistics
+ *
+ *  pointed to by the value of the ETST cookie.  new members are only
+ *  ever added at the end, and es_version is then incremented.  pointers
+ *  to statistics that are not configured in are NULL.
+ */
+#define ETSTATS_VERSION 1
+
+typedef struct
+{
+    UWORD   es_version;     /* ETSTATS_VERSION */
+    UWORD   es_size;        /* sizeof(ETSTATS) */
+    BCSTATS *es_cache;      /* BDOS sector cache */
+    OSMSTATS *es_osmem;     /* BDOS internal memory pool */
+} ETSTATS;
+
 
 #endif /* _BDOSDEFS_H */
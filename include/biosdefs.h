@@ -85,6 +85,27 @@ typedef struct _bpb BPB;
  */
 #define B_16    1       /* device has 16-bit FATs */
 #define B_1FAT  2       /* device has only a single FAT */
+#define B_32    4       /* device has 32-bit FATs (EmuTOS extension, see below) */
+
+#if CONF_WITH_FAT32
+/*
+ *  BPB32 - FAT32 extension to the BPB
+ *
+ *  if B_32 is set in b_flags, the BPB is immediately followed by this
+ *  structure.  the rdlen, fsiz, fatrec, datrec and numcl fields of the
+ *  BPB itself are zero, so that programs that only know about FAT12/16
+ *  will not try to use the drive.
+ */
+typedef struct
+{
+    ULONG l_fsiz;       /* FAT size in records */
+    ULONG l_fatrec;     /* first FAT record (of last FAT) */
+    ULONG l_datrec;     /* first data record */
+    ULONG l_numcl;      /* number of data clusters available */
+    ULONG l_rootcl;     /* first cluster of root directory */
+    UWORD l_fsinfo;     /* FSInfo record, or 0 if none */
+} BPB32;
+#endif
 
 
 /*  low/high addresses were programs will be loaded.
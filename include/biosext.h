@@ -55,6 +55,12 @@ WORD cache_exists(void);
 void set_cache(WORD enable);
 #endif
 
+/* console output of a whole buffer, FALSE if it must be done with Bconout() */
+BOOL bconout_run(WORD handle, const UBYTE *buf, LONG count);
+
+/* console input of the characters available, -1 if it must be done with Bconin() */
+WORD bconin_run(WORD handle, LONG *buf, WORD count);
+
 /* bios allocation of ST-RAM */
 UBYTE *balloc_stram(ULONG size, BOOL top);
 
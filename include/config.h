@@ -328,6 +328,36 @@
 # ifndef CONF_WITH_BACKGROUNDS
 #  define CONF_WITH_BACKGROUNDS 0
 # endif
+# ifndef CONF_WITH_BDOS_CACHE
+#  define CONF_WITH_BDOS_CACHE 0
+# endif
+# ifndef CONF_WITH_BDOS_FREEMAP
+#  define CONF_WITH_BDOS_FREEMAP 0
+# endif
+# ifndef CONF_WITH_BDOS_EXTMAP
+#  define CONF_WITH_BDOS_EXTMAP 0
+# endif
+# ifndef CONF_WITH_BDOS_DIRHASH
+#  define CONF_WITH_BDOS_DIRHASH 0
+# endif
+# ifndef CONF_WITH_BDOS_SIZE_CLASSES
+#  define CONF_WITH_BDOS_SIZE_CLASSES 0
+# endif
+# ifndef CONF_WITH_BDOS_OSMEM_GROWTH
+#  define CONF_WITH_BDOS_OSMEM_GROWTH 0
+# endif
+# ifndef CONF_WITH_PGMCACHE
+#  define CONF_WITH_PGMCACHE 0
+# endif
+# ifndef CONF_WITH_TIMER_HOOKS
+#  define CONF_WITH_TIMER_HOOKS 0
+# endif
+# ifndef CONF_WITH_DISK_READAHEAD
+#  define CONF_WITH_DISK_READAHEAD 0
+# endif
+# ifndef CONF_WITH_FAT32
+#  define CONF_WITH_FAT32 0
+# endif
 # ifndef CONF_WITH_SEARCH
 #  define CONF_WITH_SEARCH 0
 # endif
@@ -723,6 +753,9 @@
 # ifndef CONF_WITH_MPU401
 #  define CONF_WITH_MPU401 0
 # endif
+# ifndef CONF_BDOS_CACHE_BUFFERS
+#  define CONF_BDOS_CACHE_BUFFERS 64
+# endif
 #if 0
 # ifndef CONF_VRAM_ADDRESS
 #  define CONF_VRAM_ADDRESS 0x00c00000 /* VRAM is at a special location */
@@ -797,6 +830,9 @@
 # ifndef CONF_WITH_MPU401
 #  define CONF_WITH_MPU401 1
 # endif
+# ifndef CONF_BDOS_CACHE_BUFFERS
+#  define CONF_BDOS_CACHE_BUFFERS 64
+# endif
 #if 0
 # ifndef CONF_VRAM_ADDRESS
 #  define CONF_VRAM_ADDRESS 0x00c00000 /* VRAM is at a special location */
@@ -877,6 +913,9 @@
 # ifndef CONF_WITH_MPU401
 #  define CONF_WITH_MPU401 1
 # endif
+# ifndef CONF_BDOS_CACHE_BUFFERS
+#  define CONF_BDOS_CACHE_BUFFERS 64
+# endif
 # ifndef CONF_VRAM_ADDRESS
 #  define CONF_VRAM_ADDRESS 0x0c000000 /* VRAM is at a special location, must be in DDR3 memory. We set it right after the 8MB of static RAM */
 # endif
@@ -950,6 +989,9 @@
 # ifndef CONF_WITH_MPU401
 #  define CONF_WITH_MPU401 1
 # endif
+# ifndef CONF_BDOS_CACHE_BUFFERS
+#  define CONF_BDOS_CACHE_BUFFERS 64
+# endif
 #if 0
 # ifndef CONF_VRAM_ADDRESS
 #  define CONF_VRAM_ADDRESS 0x00c00000 /* VRAM is at a special location */
@@ -1404,6 +1446,20 @@
 # define CONF_WITH_SDMMC 0
 #endif
 
+/*
+ * Set CONF_WITH_DISK_READAHEAD to 1 to detect sequential reads on hard
+ * disk units and read the following sectors in advance, with the same
+ * multi-sector command.  Later reads are then served from memory.
+ * The prefetch size starts small and doubles while the reads stay
+ * sequential, up to CONF_DISK_READAHEAD_KB kilobytes.
+ */
+#ifndef CONF_WITH_DISK_READAHEAD
+# define CONF_WITH_DISK_READAHEAD 1
+#endif
+#ifndef CONF_DISK_READAHEAD_KB
+# define CONF_DISK_READAHEAD_KB 16
+#endif
+
 /*
  * Set CONF_WITH_VAMPIRE_SPI to 1 to activate SPI on the Vampire,
  * required for SD/MMC support on these boards
@@ -1868,6 +1924,20 @@
 # define CONF_WITH_XBIOS_SOUND 1
 #endif
 
+/*
+ * Set CONF_WITH_TIMER_HOOKS to 1 to let drivers register routines called
+ * by the system timer at 200 Hz or 50 Hz with the XBIOS function
+ * Tmrhook() (opcode 0x8e), instead of hooking the timer C vector.
+ * Up to CONF_TIMER_HOOKS routines can be registered, and the number of
+ * calls and the time spent in each one are recorded.
+ */
+#ifndef CONF_WITH_TIMER_HOOKS
+# define CONF_WITH_TIMER_HOOKS 1
+#endif
+#ifndef CONF_TIMER_HOOKS
+# define CONF_TIMER_HOOKS 8
+#endif
+
 /*
  * Set the default baud rate for serial ports.
  */
@@ -1953,6 +2023,134 @@
 # define CONF_LOGSEC_SIZE 512
 #endif
 
+/*
+ * Set CONF_WITH_BDOS_CACHE to 1 to replace the two fixed 2-buffer BCB
+ * lists used by Atari TOS with a larger sector cache, indexed by a hash
+ * table and managed in least-recently-used order.
+ *
+ * CONF_BDOS_CACHE_BUFFERS is the default total number of buffers allocated
+ * at boot time, shared equally between the FAT list and the dir/data list.
+ * If an ETBC cookie is in the cookie jar when the BDOS starts, its value
+ * is used instead.  Either way, the number is clamped to the range 16 to 256.
+ */
+#ifndef CONF_WITH_BDOS_CACHE
+# define CONF_WITH_BDOS_CACHE 1
+#endif
+#ifndef CONF_BDOS_CACHE_BUFFERS
+# define CONF_BDOS_CACHE_BUFFERS 16
+#endif
+
+/*
+ * With CONF_WITH_BDOS_CACHE, dirty FAT & directory records are written
+ * back in sorted batches when a file is closed, when Dfree() is called,
+ * when a dirty buffer must be reused, when the console input functions
+ * are about to wait for a key, and by the first file system call made
+ * CONF_BDOS_FLUSH_DELAY ticks (of 200 Hz) after a buffer was dirtied.
+ */
+#ifndef CONF_BDOS_FLUSH_DELAY
+# define CONF_BDOS_FLUSH_DELAY 400
+#endif
+
+/*
+ * Set CONF_WITH_BDOS_FREEMAP to 1 to keep an in-memory bitmap of the
+ * free clusters of each logged-in drive.  The bitmap is built the first
+ * time a cluster is allocated or Dfree() is called, and is then kept up
+ * to date, so that Dfree() does not need to read the whole FAT, and free
+ * clusters are found without scanning it.  It costs one bit per cluster,
+ * taken from Alt-RAM if available.
+ */
+#ifndef CONF_WITH_BDOS_FREEMAP
+# define CONF_WITH_BDOS_FREEMAP 1
+#endif
+
+/*
+ * Set CONF_WITH_BDOS_EXTMAP to 1 to cache the cluster chains of recently
+ * seeked files as lists of extents (runs of contiguous clusters), so that
+ * Fseek() does not need to follow the FAT from the start of the file.
+ * CONF_BDOS_EXTMAP_FILES is the number of chains that are cached.
+ */
+#ifndef CONF_WITH_BDOS_EXTMAP
+# define CONF_WITH_BDOS_EXTMAP 1
+#endif
+#ifndef CONF_BDOS_EXTMAP_FILES
+# define CONF_BDOS_EXTMAP_FILES 8
+#endif
+
+/*
+ * Set CONF_WITH_BDOS_DIRHASH to 1 to keep, for recently scanned folders,
+ * a small hash table of the positions of their entries.  Looking up a
+ * name without wildcards (Fopen(), Fsfirst(), path parsing, etc.) then
+ * reads just the matching entry instead of rescanning the folder.
+ * CONF_BDOS_DIRHASH_DIRS is the number of folders that are cached; the
+ * table for a large folder grows as needed, taking memory from the
+ * user pools.
+ */
+#ifndef CONF_WITH_BDOS_DIRHASH
+# define CONF_WITH_BDOS_DIRHASH 1
+#endif
+#ifndef CONF_BDOS_DIRHASH_DIRS
+# define CONF_BDOS_DIRHASH_DIRS 4
+#endif
+
+/*
+ * Set CONF_WITH_BDOS_SIZE_CLASSES to 1 to serve small Malloc()/Mxalloc()
+ * requests (up to 256 bytes) from per-size slabs instead of the free
+ * list.  This makes allocating and freeing small blocks take constant
+ * time, and avoids using up the OS memory pool with one memory
+ * descriptor per block.
+ */
+#ifndef CONF_WITH_BDOS_SIZE_CLASSES
+# define CONF_WITH_BDOS_SIZE_CLASSES 1
+#endif
+
+/*
+ * Programs loaded by Pexec() without the fastload flag normally get their
+ * whole heap cleared, which can take a long time with a lot of memory.
+ * Set CONF_PEXEC_HEAP_CLEAR_KB to a non-zero value to clear only the BSS
+ * plus that many kilobytes of heap (a guard zone for programs that expect
+ * some zeroed memory after their BSS).
+ */
+#ifndef CONF_PEXEC_HEAP_CLEAR_KB
+# define CONF_PEXEC_HEAP_CLEAR_KB 0
+#endif
+
+/*
+ * Set CONF_WITH_BDOS_OSMEM_GROWTH to 1 to let the internal OS memory
+ * pool (used for DMDs, DNDs, OFDs and memory descriptors) grow by
+ * taking memory from the user pools, preferably Alt-RAM, when it is
+ * exhausted.  The ETST cookie then gives access to usage statistics.
+ */
+#ifndef CONF_WITH_BDOS_OSMEM_GROWTH
+# define CONF_WITH_BDOS_OSMEM_GROWTH 1
+#endif
+
+/*
+ * Set CONF_WITH_PGMCACHE to 1 to keep copies of the programs loaded by
+ * Pexec() in Alt-RAM, so that running the same program again does not
+ * read it from disk.  At most CONF_PGMCACHE_PROGRAMS programs and
+ * CONF_PGMCACHE_KB kilobytes are kept; the cache is flushed when memory
+ * runs short.
+ */
+#ifndef CONF_WITH_PGMCACHE
+# define CONF_WITH_PGMCACHE CONF_WITH_ALT_RAM
+#endif
+#ifndef CONF_PGMCACHE_PROGRAMS
+# define CONF_PGMCACHE_PROGRAMS 8
+#endif
+#ifndef CONF_PGMCACHE_KB
+# define CONF_PGMCACHE_KB 2048
+#endif
+
+/*
+ * Set CONF_WITH_FAT32 to 1 to support FAT32 partitions (DOS partition
+ * types $0B and $0C).  Cluster numbers become 32-bit, and the free
+ * cluster count & next free cluster hint are taken from the FSInfo
+ * sector, so that the FAT does not have to be scanned.
+ */
+#ifndef CONF_WITH_FAT32
+# define CONF_WITH_FAT32 1
+#endif
+
 
 
 /****************************************************
@@ -2435,8 +2633,9 @@
 #endif
 
 /*
- * Set CONF_WITH_CHUNKY8 if the machine uses a chunky frame buffer with 8 bytes
- * per pixel.
+ * Set CONF_WITH_CHUNKY8 if the machine uses a chunky frame buffer with one
+ * byte per pixel in 8-plane modes.  The VDI then draws 8-plane screens with
+ * its chunky routines instead of the interleaved bitplane ones.
  */
 #ifndef CONF_WITH_CHUNKY8
 # define CONF_WITH_CHUNKY8 0
@@ -2541,6 +2740,9 @@
 # if CONF_WITH_TTRAM
 #  error CONF_WITH_TTRAM requires CONF_WITH_ALT_RAM.
 # endif
+# if CONF_WITH_PGMCACHE
+#  error CONF_WITH_PGMCACHE requires CONF_WITH_ALT_RAM.
+# endif
 #endif
 
 #ifndef STATIC_ALT_RAM_ADDRESS
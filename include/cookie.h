@@ -42,6 +42,8 @@ struct cookie {
 #define COOKIE__5MS     0x5f354d53L
 #define COOKIE_NVDI     0x4e564449L
 #define COOKIE_SCSIDRIV 0x53435349L
+#define COOKIE_ETST     0x45545354L /* EmuTOS statistics */
+#define COOKIE_ETBC     0x45544243L /* number of BDOS cache buffers */
 
 /*
  * values of _MCH cookie
@@ -67,6 +67,11 @@ static __inline__ WORD dos_snext(void)
     return Fsnext();
 }
 
+static __inline__ WORD dos_snextn(void *pbuf, WORD count)
+{
+    return Fsnextn(pbuf,count);
+}
+
 static __inline__ LONG dos_open(char *pname, WORD access)
 {
     return Fopen(pname,access);
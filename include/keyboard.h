@@ -103,6 +103,7 @@ void key_repeat_tick(void);
 /* some bios functions */
 LONG bconstat2(void);
 LONG bconin2(void);
+WORD bconin2_run(LONG *buf, WORD count);
 LONG kbshift(WORD flag);
 
 /* some xbios functions */
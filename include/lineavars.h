@@ -29,6 +29,14 @@
  * own color value (rather than an index into a color palette). */
 #define TRUECOLOR_MODE  (v_planes > 8)
 
+/* On machines with a chunky 8bpp frame buffer, 8-plane screens store one byte
+ * per pixel (the colour index) instead of interleaved bitplanes. */
+#if CONF_WITH_CHUNKY8
+#define CHUNKY8_MODE    (v_planes == 8)
+#else
+#define CHUNKY8_MODE    0
+#endif
+
 /*
  * mouse cursor save area
  *
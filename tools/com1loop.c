@@ -0,0 +1,196 @@
+/*
+ * com1loop.c - host test of the flow control of the Foenix serial port
+ *
+ * This builds bios/a2560_com1.c on the host, against a stand-in of the
+ * uart16550 driver which loops the transmit line back to the receive
+ * line, and RTS back to CTS.  Bytes written with Bconout() thus come back
+ * through the receive interrupt into the input IOREC, which is emptied
+ * more slowly than it is filled.  In each flow control mode, the bytes
+ * must all come back, in order and without overruns.
+ *
+ * Compile and run from the top directory with:
+ *      gcc -Wall -Wno-pointer-to-int-cast -o com1loop \
+ *          -DTARGET_A2560M_ROM -DMACHINE_A2560M -Iinclude -Ibios -Ifoenix \
+ *          tools/com1loop.c bios/iorec.c
+ *      ./com1loop
+ *
+ * Copyright (C) 2026 The EmuTOS development team
+ *
+ * This file is distributed under the GPL, version 2 or at your
+ * option any later version.  See doc/license.txt for details.
+ */
+
+#include <stdio.h>
+#include <stdarg.h>
+
+/*
+ * asm.h only provides m68k code; the BIOS code just needs set_sr(),
+ * which is emulated here
+ */
+#define ASM_H
+static unsigned short sr = 0x2000;
+static unsigned short host_set_sr(unsigned short new_sr)
+{
+    unsigned short old_sr = sr;
+
+    sr = new_sr;
+    return old_sr;
+}
+#define set_sr(a) host_set_sr(a)
+
+#include "../bios/a2560_com1.c"
+
+#define BUFSIZE     256     /* like RS232_BUFSIZE in serport.c */
+#define BYTES       5000
+#define RX_PERIOD   3       /* the reader takes a byte every RX_PERIOD ticks */
+#define MAX_TICKS   1000000L
+
+/*
+ * the stand-in UART: one byte per tick goes from the transmit FIFO to
+ * the receive side, where it is handed to uart16550_rx_handler
+ */
+static uint8_t fifo[UART16550_FIFO_SIZE];
+static int fifo_count;
+static bool rx_irq, tx_irq, modem_irq;
+static bool rts, modem_pending;
+
+static UBYTE ibuf[BUFSIZE], obuf[BUFSIZE];
+static EXT_IOREC rs;
+static long overruns;
+
+void (*uart16550_rx_handler)(uint8_t byte);
+
+void uart16550_set_bps(UART16550 *uart, uint16_t bps_code) { }
+uint32_t uart16550_bps_code_to_actual(uint16_t bps_code) { return 0; }
+void uart16550_set_line(UART16550 *uart, uint8_t flags) { }
+void uart16550_rx_irq_enable(UART16550 *uart, bool on) { rx_irq = on; }
+void uart16550_tx_irq_enable(UART16550 *uart, bool on) { tx_irq = on; }
+void uart16550_modem_irq_enable(UART16550 *uart, bool on) { modem_irq = on; }
+bool uart16550_cts(const UART16550 *uart) { return rts; }
+bool uart16550_can_put(const UART16550 *uart) { return fifo_count == 0; }
+
+void uart16550_set_rts(UART16550 *uart, bool on)
+{
+    if (on != rts)
+        modem_pending = true;   /* CTS changes, see tick() */
+    rts = on;
+}
+
+void uart16550_put_nowait(UART16550 *uart, uint8_t byte)
+{
+    if (fifo_count == UART16550_FIFO_SIZE) {
+        printf("transmit FIFO overflow\n");
+        return;
+    }
+    fifo[fifo_count++] = byte;
+}
+
+void uart16550_put(UART16550 *uart, const uint8_t *bytes, uint32_t count)
+{
+    while (count--)
+        uart16550_put_nowait(uart, *bytes++);
+}
+
+void superio_uart_high_speed(int port, bool enable) { }
+LONG setexc(WORD num, LONG vector) { return 0; }
+void a2560_irq_enable(uint16_t irq_id) { }
+void a2560_irq_com1(void) { }
+void a2560_debugnl(const char* __restrict__ s, ...) { }
+int kprintf(const char *RESTRICT fmt, ...) { return 0; }
+
+void push_serial_iorec(UBYTE data)
+{
+    WORD tail = rs.in.tail + 1;
+
+    if (tail >= rs.in.size)
+        tail = 0;
+    if (tail == rs.in.head)
+        overruns++;
+    iorec_put(&rs.in, data);
+}
+
+/*
+ * move one byte along the line, and deliver the interrupts like
+ * a2560_irq_com1 does: received bytes first, then the transmit and
+ * modem status interrupts
+ */
+static void tick(void)
+{
+    bool tx_pending = false;
+    uint8_t byte;
+    int i;
+
+    sr = 0x2700;
+
+    if (fifo_count) {
+        byte = fifo[0];
+        for (i = 1; i < fifo_count; i++)
+            fifo[i-1] = fifo[i];
+        tx_pending = (--fifo_count == 0);
+        if (rx_irq)
+            uart16550_rx_handler(byte);
+    }
+
+    if ((tx_pending && tx_irq) || (modem_pending && modem_irq))
+        a2560_bios_com1_tx_interrupt();
+    modem_pending = false;
+
+    sr = 0x2000;
+}
+
+static uint8_t pattern(long n)
+{
+    return ' ' + n % 95;    /* printable, so never XON or XOFF */
+}
+
+static int run(int flowctrl, int rx_period)
+{
+    long sent = 0, received = 0, ticks = 0, errors = 0;
+
+    rs.in.buf = ibuf;
+    rs.out.buf = obuf;
+    rs.in.size = rs.out.size = BUFSIZE;
+    rs.in.head = rs.in.tail = rs.out.head = rs.out.tail = 0;
+    rs.in.low = rs.out.low = BUFSIZE/4;
+    rs.in.high = rs.out.high = 3*BUFSIZE/4;
+    fifo_count = 0;
+    modem_pending = false;
+    overruns = 0;
+
+    a2560_bios_rs232_init(&rs);
+    a2560_bios_rsconf1(-1, &rs, flowctrl, -1, -1, -1, -1);
+
+    while (received < BYTES && ticks < MAX_TICKS) {
+        if (sent < BYTES && a2560_bios_bcostat1())
+            a2560_bios_bconout1(pattern(sent++));
+
+        tick();
+        ticks++;
+
+        if ((ticks % rx_period) == 0 && rs.in.head != rs.in.tail) {
+            if (iorec_get(&rs.in) != pattern(received++))
+                errors++;
+            a2560_bios_com1_rx_drained();
+        }
+    }
+
+    printf("flow control %d: %ld/%d bytes received in %ld ticks, "
+            "%ld out of order, %ld overruns\n",
+            flowctrl, received, BYTES, ticks, errors, overruns);
+
+    return received == BYTES && errors == 0 && overruns == 0;
+}
+
+int main(void)
+{
+    int ok = 1;
+
+    ok &= run(FLOW_CTRL_NONE, 1);       /* a reader as fast as the line */
+    ok &= run(FLOW_CTRL_SOFT, RX_PERIOD);
+    ok &= run(FLOW_CTRL_HARD, RX_PERIOD);
+    ok &= run(FLOW_CTRL_BOTH, RX_PERIOD);
+
+    printf("%s\n", ok ? "OK" : "FAILED");
+
+    return ok ? 0 : 1;
+}
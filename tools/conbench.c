@@ -0,0 +1,91 @@
+/*
+ * Quick & dirty console output throughput test
+ *
+ * Prints the same screenful of text through Bconout(), Cconws() and
+ * Fwrite() to the console, and reports the number of characters per second
+ * for each.  The lines are long enough to exercise wrapping and scrolling.
+ *
+ * Compile with:
+ *      m68k-atari-mint-gcc -o CONBENCH.TTP -Wall conbench.c
+ *
+ * Usage: CONBENCH.TTP [lines]      (the default is 200 lines)
+ *
+ * Copyright (C) 2026 The EmuTOS development team
+ *
+ * This file is distributed under the GPL, version 2 or at your
+ * option any later version.  See doc/license.txt for details.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <osbind.h>
+
+#define LINE_LENGTH 78      /* printable characters, + CR LF */
+
+static char line[LINE_LENGTH + 3];
+
+static long get_hz_200(void)
+{
+    return *(volatile long *)0x4ba;
+}
+
+static void by_bconout(int lines)
+{
+    const char *p;
+
+    while (lines--)
+        for (p = line; *p; p++)
+            Bconout(2, (unsigned char)*p);
+}
+
+static void by_cconws(int lines)
+{
+    while (lines--)
+        Cconws(line);
+}
+
+static void by_fwrite(int lines)
+{
+    while (lines--)
+        Fwrite(1, sizeof(line) - 1, line);
+}
+
+static long run(void (*func)(int), int lines)
+{
+    long start;
+
+    Cconws("\033E");
+    start = Supexec(get_hz_200);
+    func(lines);
+
+    return Supexec(get_hz_200) - start;
+}
+
+int main(int argc, char **argv)
+{
+    static const char * const names[] = { "Bconout", "Cconws", "Fwrite" };
+    void (* const funcs[])(int) = { by_bconout, by_cconws, by_fwrite };
+    long ticks[3], chars;
+    int i, lines = 200;
+
+    if (argc > 1)
+        lines = atoi(argv[1]);
+    if (lines <= 0)
+        lines = 1;
+
+    for (i = 0; i < LINE_LENGTH; i++)
+        line[i] = ' ' + (i % 95);
+    strcpy(line + LINE_LENGTH, "\r\n");
+    chars = (long)lines * (sizeof(line) - 1);
+
+    for (i = 0; i < 3; i++)
+        ticks[i] = run(funcs[i], lines);
+
+    Cconws("\033E");
+    for (i = 0; i < 3; i++)
+        printf("%-8s %ld chars in %ld ms, %ld chars/s\r\n", names[i], chars,
+                ticks[i] * 5L, ticks[i] ? chars * 200L / ticks[i] : 0L);
+
+    return 0;
+}
@@ -0,0 +1,146 @@
+/*
+ * Quick & dirty AES event latency test
+ *
+ * Puts a key into the keyboard buffer from a 200 Hz timer hook, and
+ * measures the time until evnt_multi() returns the MU_KEYBD event.
+ * This shows how quickly the AES wakes up when idle.  Run it under an
+ * emulator and watch the host CPU load at the same time.
+ *
+ * Requires an EmuTOS with the Tmrhook() XBIOS extension.
+ *
+ * Compile with:
+ *      m68k-atari-mint-gcc -o EVLAT.PRG -Wall evlat.c -lgem
+ *
+ * Usage: EVLAT.PRG [count]      (the default count is 100)
+ *
+ * Copyright (C) 2025 The EmuTOS development team
+ *
+ * This file is distributed under the GPL, version 2 or at your
+ * option any later version.  See doc/license.txt for details.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <osbind.h>
+#include <gem.h>
+
+#define TH_INSTALL  0
+#define TH_REMOVE   1
+#define TH_200HZ    0x0001
+
+#define KEY         0x002d0078L     /* 'x' */
+
+/* the start of the keyboard IOREC */
+typedef struct {
+    char *buf;
+    short size;
+    volatile short head;
+    volatile short tail;
+} IOREC;
+
+static IOREC *kbd;
+static volatile long fire_at;       /* hz_200 value at which to send the key */
+static volatile long sent_at;       /* hz_200 value when it was sent */
+static volatile short armed;
+
+static long get_hz_200(void)
+{
+    return *(volatile long *)0x4ba;
+}
+
+static long tmrhook(short mode, short arg, void (*func)(void))
+{
+    register long ret __asm__("d0");
+
+    __asm__ volatile
+    (
+        "move.l %3,-(sp)\n\t"
+        "move.w %2,-(sp)\n\t"
+        "move.w %1,-(sp)\n\t"
+        "move.w #0x8e,-(sp)\n\t"
+        "trap   #14\n\t"
+        "lea    10(sp),sp"
+    : "=r"(ret)
+    : "r"(mode), "r"(arg), "r"(func)
+    : "d1", "d2", "a0", "a1", "a2", "cc", "memory"
+    );
+
+    return ret;
+}
+
+/* called from the timer interrupt, in supervisor mode */
+static void send_key(void)
+{
+    short tail;
+
+    if (!armed || get_hz_200() < fire_at)
+        return;
+
+    tail = kbd->tail + 4;
+    if (tail >= kbd->size)
+        tail = 0;
+    if (tail == kbd->head)
+        return;                     /* buffer full, try again */
+
+    *(long *)(kbd->buf + tail) = KEY;
+    kbd->tail = tail;
+    sent_at = get_hz_200();
+    armed = 0;
+}
+
+int main(int argc, char **argv)
+{
+    short msg[8], mx, my, button, kstate, key, clicks, events;
+    long hook, ticks, total = 0, max = 0;
+    int i, count = 100, lost = 0;
+
+    if (argc > 1)
+        count = atoi(argv[1]);
+    if (count <= 0)
+        count = 1;
+
+    if (appl_init() < 0)
+        return 1;
+
+    kbd = (IOREC *)Iorec(1);
+    hook = tmrhook(TH_INSTALL, TH_200HZ, send_key);
+    if (hook < 0 || hook == 0x8e) {
+        form_alert(1, "[3][Tmrhook() is not available][ OK ]");
+        appl_exit();
+        return 1;
+    }
+
+    for (i = 0; i < count; i++) {
+        /* vary the delay, so we don't always start at the same point */
+        fire_at = Supexec(get_hz_200) + 2 + (i & 3);
+        armed = 1;
+
+        events = evnt_multi(MU_KEYBD|MU_TIMER, 0, 0, 0, 0, 0, 0, 0, 0,
+                            0, 0, 0, 0, 0, msg, 1000L,
+                            &mx, &my, &button, &kstate, &key, &clicks);
+        ticks = Supexec(get_hz_200) - sent_at;
+
+        if (!(events & MU_KEYBD) || armed) {
+            armed = 0;
+            lost++;
+            continue;
+        }
+        total += ticks;
+        if (ticks > max)
+            max = ticks;
+    }
+
+    tmrhook(TH_REMOVE, (short)hook, NULL);
+    appl_exit();
+
+    if (count > lost) {
+        printf("%d events: average %ld.%ld ms, max %ld ms\r\n", count - lost,
+                total * 5L / (count - lost), (total * 50L / (count - lost)) % 10,
+                max * 5L);
+    }
+    if (lost)
+        printf("%d events lost (keyboard not owned?)\r\n", lost);
+    Cconin();
+
+    return 0;
+}
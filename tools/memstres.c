@@ -4,6 +4,9 @@
  * Compile with:
  *      m68k-atari-mint-gcc -o MEMSTRES.TOS -Wall memstres.c
  *
+ * Usage: MEMSTRES.TOS [blocks]         random walk, runs forever
+ *        MEMSTRES.TOS -b [blocks]      timed small block benchmark
+ *
  * Copyright 2016 Christian Zietz <czietz@gmx.net>
  *
  * This file is distributed under the GPL, version 2 or at your
@@ -12,6 +15,8 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 #ifdef USE_STDLIB
 void* _Malloc(unsigned long s) {
@@ -116,8 +121,68 @@ int randomwalk(unsigned char p) {
     return ((unsigned char)(qdrand() & 0xFF) < p);
 }
 
+/* Benchmark: time the allocation and release of many small blocks */
+#define MAX_BENCH 4000
+void* g_bench[MAX_BENCH];
+
+long elapsed_ms(clock_t start) {
+    return (long)(clock() - start) * 1000L / CLOCKS_PER_SEC;
+}
+
+int benchmark(int n) {
+    clock_t start;
+    int k, j, got;
+    void *tmp;
+
+    printf("Small block benchmark with %d blocks\r\n", n);
+
+    /* allocate n blocks of 1 to 128 bytes */
+    start = clock();
+    for (got = 0; got < n; got++) {
+        g_bench[got] = (void *)_Malloc((qdrand() >> 8 & 0x7FL) + 1L);
+        if (g_bench[got] == NULL)
+            break;
+    }
+    printf("Alloc          %5d blocks: %6ld ms\r\n", got, elapsed_ms(start));
+    if (got < n)
+        printf("(out of memory after %d blocks)\r\n", got);
+
+    /* free every other block, then allocate it again */
+    start = clock();
+    for (k = 0; k < got; k += 2)
+        _Mfree(g_bench[k]);
+    for (k = 0; k < got; k += 2)
+        g_bench[k] = (void *)_Malloc((qdrand() >> 8 & 0x7FL) + 1L);
+    printf("Free & realloc %5d blocks: %6ld ms\r\n", (got+1)/2, elapsed_ms(start));
+
+    /* shuffle, then free all the blocks in random order */
+    for (k = got - 1; k > 0; k--) {
+        j = (int)((qdrand() >> 8) % (k + 1));
+        tmp = g_bench[k];
+        g_bench[k] = g_bench[j];
+        g_bench[j] = tmp;
+    }
+    start = clock();
+    for (k = 0; k < got; k++) {
+        if (g_bench[k] && (_Mfree(g_bench[k]) != 0))
+            printf("Free %08lx failed\r\n", (unsigned long)g_bench[k]);
+    }
+    printf("Free           %5d blocks: %6ld ms\r\n", got, elapsed_ms(start));
+
+    return 0;
+}
+
 int main(int argc, char* argv[]) {
 
+    if ((argc > 1) && !strcmp(argv[1], "-b")) {
+        int n = (argc > 2) ? atoi(argv[2]) : 2000;
+        if ((n <= 0) || (n > MAX_BENCH)) {
+            printf("Must run with at least 1 and at most %d blocks!\r\n", MAX_BENCH);
+            return 1;
+        }
+        return benchmark(n);
+    }
+
     /* allow the user to give the number of blocks to allocate */
     if (argc < 2) {
         g_nslots = 250;
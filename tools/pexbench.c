@@ -0,0 +1,78 @@
+/*
+ * Quick & dirty Pexec() load time test
+ *
+ * Loads a program repeatedly with Pexec(PE_LOAD), without running it,
+ * and reports the average time taken.  This measures reading the file,
+ * relocating it and clearing its memory.
+ *
+ * Compile with:
+ *      m68k-atari-mint-gcc -o PEXBENCH.TTP -Wall pexbench.c
+ *
+ * Usage: PEXBENCH.TTP program [count]      (the default count is 10)
+ *
+ * Copyright (C) 2025 The EmuTOS development team
+ *
+ * This file is distributed under the GPL, version 2 or at your
+ * option any later version.  See doc/license.txt for details.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <osbind.h>
+
+#define PE_LOAD     3
+
+/* the start of a basepage */
+typedef struct {
+    void *p_lowtpa;
+    void *p_hitpa;
+    void *p_tbase;
+    long p_tlen;
+    void *p_dbase;
+    long p_dlen;
+    void *p_bbase;
+    long p_blen;
+    void *p_dta;
+    void *p_parent;
+    long p_reserved;
+    char *p_env;
+} BASEPAGE_START;
+
+static long get_hz_200(void)
+{
+    return *(volatile long *)0x4ba;
+}
+
+int main(int argc, char **argv)
+{
+    BASEPAGE_START *bp;
+    int i, count = 10;
+    long start, ticks, rc;
+
+    if (argc < 2) {
+        printf("Usage: PEXBENCH program [count]\r\n");
+        return 1;
+    }
+    if (argc > 2)
+        count = atoi(argv[2]);
+    if (count <= 0)
+        count = 1;
+
+    start = Supexec(get_hz_200);
+    for (i = 0; i < count; i++) {
+        rc = Pexec(PE_LOAD, argv[1], "\0", NULL);
+        if (rc < 0) {
+            printf("Pexec() error %ld\r\n", rc);
+            return 1;
+        }
+        bp = (BASEPAGE_START *)rc;
+        Mfree(bp->p_env);
+        Mfree(bp);
+    }
+    ticks = Supexec(get_hz_200) - start;
+
+    printf("%s: %d loads, %ld ms per load\r\n",
+            argv[1], count, ticks * 5L / count);
+
+    return 0;
+}
@@ -0,0 +1,88 @@
+/*
+ * Quick & dirty disk read throughput test
+ *
+ * Reads the first sectors of a drive with Rwabs(), using transfers of
+ * various sizes, and reports the throughput in KB/s.  It was written to
+ * measure the SD card drivers, but works with any drive.
+ *
+ * Compile with:
+ *      m68k-atari-mint-gcc -o SDBENCH.TTP -Wall sdbench.c
+ *
+ * Usage: SDBENCH.TTP [drive letter]    (the default is C)
+ *
+ * Copyright (C) 2025 The EmuTOS development team
+ *
+ * This file is distributed under the GPL, version 2 or at your
+ * option any later version.  See doc/license.txt for details.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <osbind.h>
+
+#define TOTAL_KB    1024L           /* amount to read for each transfer size */
+#define MAX_SECTORS 64              /* largest transfer, in sectors */
+
+static const int sizes[] = { 1, 2, 8, 32, MAX_SECTORS };
+
+static long get_hz_200(void)
+{
+    return *(volatile long *)0x4ba;
+}
+
+int main(int argc, char **argv)
+{
+    int dev = 'C' - 'A';
+    int i, n, count;
+    long recsiz, nrecs, recno, start, ticks, rc;
+    char *buf;
+    short *bpb;
+
+    if (argc > 1)
+        dev = toupper((unsigned char)argv[1][0]) - 'A';
+    if ((dev < 0) || (dev >= 26)) {
+        printf("Invalid drive\r\n");
+        return 1;
+    }
+
+    bpb = (short *)Getbpb(dev);
+    if (!bpb) {
+        printf("Drive %c: is not available\r\n", dev+'A');
+        return 1;
+    }
+    recsiz = bpb[0];                /* bytes per logical sector */
+
+    buf = malloc(MAX_SECTORS * recsiz);
+    if (!buf) {
+        printf("Not enough memory\r\n");
+        return 1;
+    }
+
+    nrecs = TOTAL_KB * 1024L / recsiz;
+    printf("Reading %ld KB from drive %c: (%ld-byte sectors)\r\n",
+            TOTAL_KB, dev+'A', recsiz);
+
+    for (i = 0; i < sizeof(sizes)/sizeof(sizes[0]); i++) {
+        count = sizes[i];
+        start = Supexec(get_hz_200);
+        for (recno = 0; recno < nrecs; recno += count) {
+            n = (nrecs - recno < count) ? (int)(nrecs - recno) : count;
+            rc = Rwabs(0, buf, n, (int)recno, dev);
+            if (rc < 0) {
+                printf("Rwabs() error %ld at sector %ld\r\n", rc, recno);
+                free(buf);
+                return 1;
+            }
+        }
+        ticks = Supexec(get_hz_200) - start;
+        if (ticks <= 0)
+            ticks = 1;
+        printf("%3d sector(s) per read: %5ld KB/s\r\n",
+                count, TOTAL_KB * 200L / ticks);
+    }
+
+    free(buf);
+
+    return 0;
+}
@@ -22,6 +22,7 @@
 #include "intmath.h"
 #include "bdosbind.h"
 #include "tosvars.h"
+#include "vdi_inline.h"
 
 #define FIRST_VDI_HANDLE    1
 #define LAST_VDI_HANDLE     (FIRST_VDI_HANDLE+NUM_VDI_HANDLES-1)
@@ -607,6 +608,7 @@ void vdi_v_clrwk(Vwk * vwk)
         fill = 0x00;
     }
     memset(v_bas_ad, fill, size);
+    mark_screen_dirty(0, 0, V_REZ_HZ - 1, V_REZ_VT - 1);
 }
 
 
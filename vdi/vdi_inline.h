@@ -10,6 +10,10 @@
 #ifndef _VDI_INLINE_H
 #define _VDI_INLINE_H
 
+#if CONF_WITH_A2560_SHADOW_FRAMEBUFFER
+#include "../foenix/shadow_fb.h"
+#endif
+
 /*
  * get_start_addr - return memory address for column x, row y
  *
@@ -53,4 +57,16 @@ static __inline__ UWORD *get_start_addr16(const WORD x, const WORD y)
 }
 #endif
 
+/*
+ * mark_screen_dirty - report the screen area (inclusive) that was drawn to
+ *
+ * with a shadow frame buffer, only the marked tiles are copied to VRAM
+ */
+static __inline__ void mark_screen_dirty(WORD x1, WORD y1, WORD x2, WORD y2)
+{
+#if CONF_WITH_A2560_SHADOW_FRAMEBUFFER
+    a2560_sfb_mark_rect(x1, y1, x2, y2);
+#endif
+}
+
 #endif                          /* _VDI_INLINE_H */
@@ -148,11 +148,18 @@ void vdi_vql_attributes(Vwk * vwk)
  */
 void draw_rect_common(const VwkAttrib *attr, const Rect *rect)
 {
+    mark_screen_dirty(rect->x1, rect->y1, rect->x2, rect->y2);
+
 #if CONF_WITH_VDI_16BIT
     if (TRUECOLOR_MODE)
         swblit_rect_common16(attr, rect);
     else
 #endif
+#if CONF_WITH_CHUNKY8
+    if (CHUNKY8_MODE)
+        swblit_rect_common8(attr, rect);
+    else
+#endif
 #if CONF_WITH_BLITTER
     if (blitter_is_enabled)
     {
@@ -1000,6 +1007,7 @@ void abline(const Line *line, const WORD wrt_mode, UWORD color)
      * optimize drawing of vertical lines
      */
     if (line->x1 == line->x2) {
+        mark_screen_dirty(line->x1, min(line->y1, line->y2), line->x1, max(line->y1, line->y2));
 #if CONF_WITH_VDI_16BIT
         if (TRUECOLOR_MODE)
         {
@@ -1008,6 +1016,14 @@ void abline(const Line *line, const WORD wrt_mode, UWORD color)
         }
         else
 #endif
+#if CONF_WITH_CHUNKY8
+        if (CHUNKY8_MODE)
+        {
+            swblit_vertical_line8(line, wrt_mode, color);
+            return;
+        }
+        else
+#endif
 #if CONF_WITH_BLITTER
         if (blitter_is_enabled)
         {
@@ -1080,10 +1096,16 @@ void abline(const Line *line, const WORD wrt_mode, UWORD color)
     ordered.y1 = y1;
     ordered.x2 = x2;
     ordered.y2 = y2;
+    mark_screen_dirty(x1, min(y1, y2), x2, max(y1, y2));
 #if CONF_WITH_VDI_16BIT
     if (TRUECOLOR_MODE)
         draw_line16(&ordered, wrt_mode, color);
     else
+#endif
+#if CONF_WITH_CHUNKY8
+    if (CHUNKY8_MODE)
+        draw_line8(&ordered, wrt_mode, color);
+    else
 #endif
     draw_line(&ordered, wrt_mode, color);
 }
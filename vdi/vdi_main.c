@@ -12,6 +12,7 @@
 #include "vdi_defs.h"
 #include "lineavars.h"
 #include "asm.h"
+#include "a2560_bios.h"
 
 /* forward prototypes */
 void vdi_screen_driver(void);
@@ -163,6 +164,11 @@ void vdi_screen_driver(void)
     contrl[2] = jmptab->nptsout;
     contrl[4] = jmptab->nintout;
 
+#if CONF_WITH_A2560_SHADOW_FRAMEBUFFER
+    /* The VDI draws the screen as a plain bitmap */
+    a2560_bios_sfb_unwrap();
+#endif
+
     /* Call the appropriate function */
     (*jmptab->op) (vwk);
 
@@ -21,6 +21,8 @@
 #include "has.h"        /* for blitter-related items */
 #include "string.h"     /* for bzero() */
 #include "gemdos.h"     /* for mem alloc & free */
+#include "intmath.h"
+#include "vdi_inline.h"
 
 #ifdef __mcoldfire__
 #define ASM_BLIT_IS_AVAILABLE   0   /* assembler routine does not support ColdFire */
@@ -256,6 +258,78 @@ static void vr_trnfm16(MFDB *src_mfdb, MFDB *dst_mfdb)
 }
 #endif
 
+#if CONF_WITH_CHUNKY8
+/*
+ * convert between 8-plane standard format and chunky device-dependent format
+ */
+static void vr_trnfm8(MFDB *src_mfdb, MFDB *dst_mfdb)
+{
+    UWORD *src, *work;
+    UBYTE *dst, *chunky, *tempbuf = NULL;
+    LONG i, planesize, formsize;
+    UWORD mask;
+    UBYTE bit;
+
+    src = (UWORD *)src_mfdb->fd_addr;
+    dst = (UBYTE *)dst_mfdb->fd_addr;
+    planesize = (LONG)src_mfdb->fd_h * src_mfdb->fd_wdwidth;    /* in words */
+    formsize = planesize * sizeof(WORD) * 8;    /* in bytes */
+
+    /*
+     * as for vr_trnfm16(), an 'in place' transform uses a temp buf
+     */
+    if ((void *)src == (void *)dst)
+    {
+        tempbuf = dos_alloc_anyram(formsize);
+        if (!tempbuf)
+        {
+            KDEBUG(("Cannot allocate temp buf for vr_trnfm()\n"));
+            return;
+        }
+        dst = tempbuf;
+    }
+
+    bzero(dst, formsize);   /* clear out the output */
+
+    if (src_mfdb->fd_stand) /* handle standard -> device-dependent */
+    {
+        dst_mfdb->fd_stand = 0;
+        for (bit = 0x01; bit; bit <<= 1)    /* plane 0 first */
+        {
+            for (i = 0, chunky = dst; i < planesize; i++, src++)
+            {
+                for (mask = 0x8000; mask; mask >>= 1, chunky++)
+                {
+                    if (*src & mask)
+                        *chunky |= bit;
+                }
+            }
+        }
+    }
+    else                    /* handle device-dependent -> standard */
+    {
+        dst_mfdb->fd_stand = 1;
+        for (bit = 0x01, work = (UWORD *)dst; bit; bit <<= 1)
+        {
+            for (i = 0, chunky = (UBYTE *)src; i < planesize; i++, work++)
+            {
+                for (mask = 0x8000; mask; mask >>= 1, chunky++)
+                {
+                    if (*chunky & bit)
+                        *work |= mask;
+                }
+            }
+        }
+    }
+
+    if (tempbuf)
+    {
+        memcpy(dst_mfdb->fd_addr, tempbuf, formsize);
+        dos_free(tempbuf);
+    }
+}
+#endif
+
 /*
  * vdi_vr_trnfm - transform screen bitmaps
  *
@@ -293,6 +367,17 @@ void vdi_vr_trnfm(Vwk * vwk)
         return;
     }
 #endif
+#if CONF_WITH_CHUNKY8
+    /*
+     * in chunky 8bpp modes, the device-dependent format of an 8-plane
+     * form is one byte per pixel, like the screen
+     */
+    if (CHUNKY8_MODE && (src_mfdb->fd_nplanes == 8))
+    {
+        vr_trnfm8(src_mfdb, dst_mfdb);
+        return;
+    }
+#endif
 
     src = src_mfdb->fd_addr;
     dst = dst_mfdb->fd_addr;
@@ -1326,6 +1411,408 @@ static void vrt_cpyfm16(struct blit_frame *info)
 }
 #endif
 
+#if CONF_WITH_CHUNKY8
+/*
+ * copy_row8() - copy a row of chunky pixels, which may overlap
+ *
+ * like memmove(), but never with long moves: the screen may be in VICKY's
+ * VRAM, which doesn't support long writes.  when source and destination
+ * have the same alignment, we move words.
+ */
+static void copy_row8(UBYTE *dst, const UBYTE *src, WORD cols)
+{
+    UWORD *d;
+    const UWORD *s;
+
+    if ((dst <= src) || (dst >= src + cols)) {      /* forwards */
+        if (((LONG)dst ^ (LONG)src) & 1) {
+            while(cols-- > 0)
+                *dst++ = *src++;
+            return;
+        }
+        if ((LONG)dst & 1) {
+            *dst++ = *src++;
+            cols--;
+        }
+        for (d = (UWORD *)dst, s = (const UWORD *)src; cols >= 2; cols -= 2)
+            *d++ = *s++;
+        if (cols > 0)
+            *(UBYTE *)d = *(const UBYTE *)s;
+    } else {                                        /* backwards */
+        dst += cols;
+        src += cols;
+        if (((LONG)dst ^ (LONG)src) & 1) {
+            while(cols-- > 0)
+                *--dst = *--src;
+            return;
+        }
+        if ((LONG)dst & 1) {
+            *--dst = *--src;
+            cols--;
+        }
+        for (d = (UWORD *)dst, s = (const UWORD *)src; cols >= 2; cols -= 2)
+            *--d = *--s;
+        if (cols > 0)
+            *((UBYTE *)d - 1) = *((const UBYTE *)s - 1);
+    }
+}
+
+
+/*
+ * vro_cpyfm8() - handle vro_cpyfm() for chunky 8bpp graphics
+ *
+ * the logic ops all act literally on the pixels (bytes) concerned
+ */
+static void vro_cpyfm8(struct blit_frame *info)
+{
+    UBYTE *src, *dst, *p, *q;
+    WORD src_width, dst_width, next_pixel;
+    WORD mode, rows, cols;
+
+    mode = INTIN[0];
+
+    /*
+     * init pointers & increments
+     */
+    src_width = info->s_nxln;
+    dst_width = info->d_nxln;
+    next_pixel = 1;
+    src = (UBYTE *)info->s_form + ((LONG)info->s_ymin * src_width) + info->s_xmin;
+    dst = (UBYTE *)info->d_form + ((LONG)info->d_ymin * dst_width) + info->d_xmin;
+
+    /*
+     * adjust if potential overlap
+     */
+    if (src < dst) {
+        src = (UBYTE *)info->s_form + ((LONG)info->s_ymax * src_width) + info->s_xmax;
+        dst = (UBYTE *)info->d_form + ((LONG)info->d_ymax * dst_width) + info->d_xmax;
+        src_width = -src_width;
+        dst_width = -dst_width;
+        next_pixel = -1;
+    }
+
+    p = src;
+    q = dst;
+
+    rows = info->s_ymax - info->s_ymin + 1;
+
+    switch(mode) {
+    case BM_ALL_WHITE:  /* D1 = 0 */
+        while(rows-- > 0) {
+            cols = info->s_xmax - info->s_xmin + 1;
+            while(cols-- > 0) {
+                *q = 0;
+                q += next_pixel;
+            }
+            dst += dst_width;
+            q = dst;
+        }
+        break;
+    case BM_S_AND_D:    /* D1 = S AND D */
+        while(rows-- > 0) {
+            cols = info->s_xmax - info->s_xmin + 1;
+            while(cols-- > 0) {
+                *q = *p & *q;
+                p += next_pixel;
+                q += next_pixel;
+            }
+            src += src_width;
+            p = src;
+            dst += dst_width;
+            q = dst;
+        }
+        break;
+    case BM_S_AND_NOTD: /* D1 = S AND (NOT D) */
+        while(rows-- > 0) {
+            cols = info->s_xmax - info->s_xmin + 1;
+            while(cols-- > 0) {
+                *q = *p & ~*q;
+                p += next_pixel;
+                q += next_pixel;
+            }
+            src += src_width;
+            p = src;
+            dst += dst_width;
+            q = dst;
+        }
+        break;
+    case BM_S_ONLY:     /* D1 = S */                /* replace */
+        /*
+         * this is the common case, so we copy whole rows at a time:
+         * copy_row8() handles overlap within a row and uses word moves
+         */
+        cols = info->s_xmax - info->s_xmin + 1;
+        if (next_pixel < 0) {
+            src -= cols - 1;                /* point to start of last row */
+            dst -= cols - 1;
+        }
+        while(rows-- > 0) {
+            copy_row8(dst, src, cols);
+            src += src_width;
+            dst += dst_width;
+        }
+        break;
+    case BM_NOTS_AND_D: /* D1 = (NOT S) AND D */    /* erase */
+        while(rows-- > 0) {
+            cols = info->s_xmax - info->s_xmin + 1;
+            while(cols-- > 0) {
+                *q = ~*p & *q;
+                p += next_pixel;
+                q += next_pixel;
+            }
+            src += src_width;
+            p = src;
+            dst += dst_width;
+            q = dst;
+        }
+        break;
+    case BM_D_ONLY:     /* D1 = D */
+        /* nothing to do */
+        break;
+    case BM_S_XOR_D:    /* D1 = S XOR D */          /* XOR */
+        while(rows-- > 0) {
+            cols = info->s_xmax - info->s_xmin + 1;
+            while(cols-- > 0) {
+                *q = *p ^ *q;
+                p += next_pixel;
+                q += next_pixel;
+            }
+            src += src_width;
+            p = src;
+            dst += dst_width;
+            q = dst;
+        }
+        break;
+    case BM_S_OR_D:     /* D1 = S OR D */           /* transparent */
+        while(rows-- > 0) {
+            cols = info->s_xmax - info->s_xmin + 1;
+            while(cols-- > 0) {
+                *q = *p | *q;
+                p += next_pixel;
+                q += next_pixel;
+            }
+            src += src_width;
+            p = src;
+            dst += dst_width;
+            q = dst;
+        }
+        break;
+    case BM_NOT_SORD:   /* D1 = NOT (S OR D) */
+        while(rows-- > 0) {
+            cols = info->s_xmax - info->s_xmin + 1;
+            while(cols-- > 0) {
+                *q = ~(*p | *q);
+                p += next_pixel;
+                q += next_pixel;
+            }
+            src += src_width;
+            p = src;
+            dst += dst_width;
+            q = dst;
+        }
+        break;
+    case BM_NOT_SXORD:  /* D1 = NOT (S XOR D) */
+        while(rows-- > 0) {
+            cols = info->s_xmax - info->s_xmin + 1;
+            while(cols-- > 0) {
+                *q = ~(*p ^ *q);
+                p += next_pixel;
+                q += next_pixel;
+            }
+            src += src_width;
+            p = src;
+            dst += dst_width;
+            q = dst;
+        }
+        break;
+    case BM_NOT_D:      /* D1 = NOT D */
+        while(rows-- > 0) {
+            cols = info->s_xmax - info->s_xmin + 1;
+            while(cols-- > 0) {
+                *q = ~*q;
+                q += next_pixel;
+            }
+            dst += dst_width;
+            q = dst;
+        }
+        break;
+    case BM_S_OR_NOTD:  /* D1 = S OR (NOT D) */
+        while(rows-- > 0) {
+            cols = info->s_xmax - info->s_xmin + 1;
+            while(cols-- > 0) {
+                *q = *p | ~*q;
+                p += next_pixel;
+                q += next_pixel;
+            }
+            src += src_width;
+            p = src;
+            dst += dst_width;
+            q = dst;
+        }
+        break;
+    case BM_NOT_S:      /* D1 = NOT S */
+        while(rows-- > 0) {
+            cols = info->s_xmax - info->s_xmin + 1;
+            while(cols-- > 0) {
+                *q = ~*p;
+                p += next_pixel;
+                q += next_pixel;
+            }
+            src += src_width;
+            p = src;
+            dst += dst_width;
+            q = dst;
+        }
+        break;
+    case BM_NOTS_OR_D:  /* D1 = (NOT S) OR D */     /* reverse transparent */
+        while(rows-- > 0) {
+            cols = info->s_xmax - info->s_xmin + 1;
+            while(cols-- > 0) {
+                *q = ~*p | *q;
+                p += next_pixel;
+                q += next_pixel;
+            }
+            src += src_width;
+            p = src;
+            dst += dst_width;
+            q = dst;
+        }
+        break;
+    case BM_NOT_SANDD:  /* D1 = NOT (S AND D) */
+        while(rows-- > 0) {
+            cols = info->s_xmax - info->s_xmin + 1;
+            while(cols-- > 0) {
+                *q = ~(*p & *q);
+                p += next_pixel;
+                q += next_pixel;
+            }
+            src += src_width;
+            p = src;
+            dst += dst_width;
+            q = dst;
+        }
+        break;
+    case BM_ALL_BLACK:  /* D1 = 1 */
+        while(rows-- > 0) {
+            cols = info->s_xmax - info->s_xmin + 1;
+            while(cols-- > 0) {
+                *q = 0xff;
+                q += next_pixel;
+            }
+            dst += dst_width;
+            q = dst;
+        }
+        break;
+    }
+}
+
+/*
+ * vrt_cpyfm8() - handle vrt_cpyfm() for chunky 8bpp graphics
+ */
+static void vrt_cpyfm8(struct blit_frame *info)
+{
+    UWORD *src, *p;
+    UBYTE *dst, *q;
+    WORD mode, src_width, src_off, dst_width, x, y;
+    UWORD src_mask, bit_mask;
+    UBYTE fgcol, bgcol;
+
+    mode = INTIN[0];
+
+    fgcol = info->fg_col;       /* already mapped to pixel values */
+    bgcol = info->bg_col;
+
+    /*
+     * init source area variables
+     */
+    src_width = info->s_nxln / sizeof(WORD);/* width in words */
+    src_off = info->s_xmin >> 4;            /* starting x offset in words */
+    bit_mask = src_mask = 0x8000U >> (info->s_xmin&0x000f); /* starting bit mask */
+    p = src = info->s_form + ((LONG)info->s_ymin * src_width) + src_off;
+
+    /*
+     * init destination area variables
+     */
+    dst_width = info->d_nxln;                   /* in bytes */
+    q = dst = (UBYTE *)info->d_form + ((LONG)info->d_ymin * dst_width) + info->d_xmin;
+
+    switch(mode) {
+    case MD_ERASE:
+        for (y = info->s_ymin; y <= info->s_ymax; y++) {
+            for (x = info->s_xmin; x <= info->s_xmax; x++, q++) {
+                if (!(*p & bit_mask))
+                    *q = bgcol;
+                rorw1(bit_mask);
+                if (bit_mask & 0x8000)
+                    p++;
+            }
+            src += src_width;
+            p = src;
+            bit_mask = src_mask;
+            dst += dst_width;
+            q = dst;
+        }
+        break;
+
+    case MD_XOR:
+        for (y = info->s_ymin; y <= info->s_ymax; y++) {
+            for (x = info->s_xmin; x <= info->s_xmax; x++, q++) {
+                if (*p & bit_mask)
+                    *q ^= 0xff;
+                rorw1(bit_mask);
+                if (bit_mask & 0x8000)
+                    p++;
+            }
+            src += src_width;
+            p = src;
+            bit_mask = src_mask;
+            dst += dst_width;
+            q = dst;
+        }
+        break;
+
+    case MD_TRANS:
+        for (y = info->s_ymin; y <= info->s_ymax; y++) {
+            for (x = info->s_xmin; x <= info->s_xmax; x++, q++) {
+                if (*p & bit_mask)
+                    *q = fgcol;
+                rorw1(bit_mask);
+                if (bit_mask & 0x8000)
+                    p++;
+            }
+            src += src_width;
+            p = src;
+            bit_mask = src_mask;
+            dst += dst_width;
+            q = dst;
+        }
+        break;
+
+    case MD_REPLACE:
+        for (y = info->s_ymin; y <= info->s_ymax; y++) {
+            for (x = info->s_xmin; x <= info->s_xmax; x++, q++) {
+                if (*p & bit_mask)
+                    *q = fgcol;
+                else
+                    *q = bgcol;
+                rorw1(bit_mask);
+                if (bit_mask & 0x8000)
+                    p++;
+            }
+            src += src_width;
+            p = src;
+            bit_mask = src_mask;
+            dst += dst_width;
+            q = dst;
+        }
+        break;
+
+    default:
+        return;                     /* unsupported mode */
+    }
+}
+#endif
+
 /* common functionality for vdi_vro_cpyfm, vdi_vrt_cpyfm, linea_raster */
 static void
 cpy_raster(struct raster_t *raster, struct blit_frame *info)
@@ -1352,6 +1839,9 @@ cpy_raster(struct raster_t *raster, struct blit_frame *info)
     if (setup_info(raster, info))
         return;
 
+    if (info->d_form == (UWORD *)v_bas_ad)
+        mark_screen_dirty(info->d_xmin, info->d_ymin, info->d_xmax, info->d_ymax);
+
     if (!raster->transparent) {
 
         /* COPY RASTER OPAQUE */
@@ -1371,6 +1861,13 @@ cpy_raster(struct raster_t *raster, struct blit_frame *info)
             return;
         }
 #endif
+#if CONF_WITH_CHUNKY8
+        if (CHUNKY8_MODE && (info->plane_ct == 8))
+        {
+            vro_cpyfm8(info);           /* chunky version */
+            return;
+        }
+#endif
 
     } else {
 
@@ -1436,6 +1933,13 @@ cpy_raster(struct raster_t *raster, struct blit_frame *info)
             return;
         }
 #endif
+#if CONF_WITH_CHUNKY8
+        if (CHUNKY8_MODE && (info->plane_ct == 8))
+        {
+            vrt_cpyfm8(info);           /* chunky version */
+            return;
+        }
+#endif
 
     }
 
@@ -1528,6 +2032,9 @@ void linea_blit(struct blit_frame *info)
     info->d_xmax = info->d_xmin + info->b_wd - 1;
     info->d_ymax = info->d_ymin + info->b_ht - 1;
 
+    if (info->d_form == (UWORD *)v_bas_ad)
+        mark_screen_dirty(info->d_xmin, info->d_ymin, info->d_xmax, info->d_ymax);
+
     /*
      * call assembler blit routine or C-implementation.  we call the
      * assembler version if we're not on ColdFire and either
@@ -436,6 +436,122 @@ void OPTIMIZE_SMALL swblit_rect_common16(const VwkAttrib *attr, const Rect *rect
 #endif
 
 
+#if CONF_WITH_CHUNKY8
+/*
+ * one 16-pixel row of a fill pattern, as one byte per pixel
+ *
+ * the word view allows us to process 2 pixels at a time: since the screen
+ * is word-aligned and its line length is a multiple of 16 bytes, pixel x
+ * of a line is in word (x>>1)&7 of the row.  we don't use long words: the
+ * screen may be in VICKY's VRAM, which doesn't support long writes.
+ */
+typedef union {
+    UWORD w[8];
+    UBYTE b[16];
+} PATROW8;
+
+/*
+ * pattern_row8 - expand one row of the fill pattern to a byte mask per pixel
+ *
+ * each byte has the bits set for the planes in which the pattern bit is set,
+ * so a pixel's new value is (colour & mask).  for a single-plane pattern
+ * the mask is 0xff or 0x00; for a multi-plane (colour) pattern, each plane
+ * contributes one bit.
+ */
+static void pattern_row8(const VwkAttrib *attr, int patind, PATROW8 *row)
+{
+    UWORD pattern, mask;
+    int i, plane;
+
+    if (!attr->multifill) {
+        pattern = attr->patptr[patind];
+        for (i = 0, mask = 0x8000; i < 16; i++, mask >>= 1)
+            row->b[i] = (pattern & mask) ? 0xff : 0x00;
+        return;
+    }
+
+    for (i = 0; i < 8; i++)
+        row->w[i] = 0;
+    for (plane = 0; plane < 8; plane++, patind += 16) {
+        pattern = attr->patptr[patind];
+        for (i = 0, mask = 0x8000; i < 16; i++, mask >>= 1)
+            if (pattern & mask)
+                row->b[i] |= 1 << plane;
+    }
+}
+
+/*
+ * swblit_rect_common8 - draw one or more horizontal lines via software, chunky 8bpp mode
+ *
+ * each scan line is done in three parts: a single byte up to a word
+ * boundary, then 2 pixels per word, then the leftover byte.  the pattern
+ * row is only expanded when it changes, so solid fills cost just the word
+ * stores.
+ */
+void OPTIMIZE_SMALL swblit_rect_common8(const VwkAttrib *attr, const Rect *rect)
+{
+    const UWORD patmsk = attr->patmsk;
+    const UWORD fill = (UBYTE)attr->color * 0x0101U;
+    UBYTE *addr, *q;
+    UWORD *w;
+    PATROW8 mask, val;
+    int i, x, y, patind, lastind = -1;
+
+    addr = (UBYTE *)get_start_addr(rect->x1, rect->y1);
+
+    for (y = rect->y1; y <= rect->y2; y++, addr += v_lin_wr) {
+        patind = patmsk & y;            /* starting pattern index */
+        if (patind != lastind) {
+            pattern_row8(attr, patind, &mask);
+            if (attr->wrt_mode == WM_ERASE) {   /* erase draws where the pattern is clear */
+                for (i = 0; i < 8; i++)
+                    mask.w[i] = ~mask.w[i];
+            }
+            for (i = 0; i < 8; i++)
+                val.w[i] = fill & mask.w[i];
+            lastind = patind;
+        }
+
+        x = rect->x1;
+        q = addr;
+
+        switch(attr->wrt_mode) {
+        case WM_XOR:            /* xor mode: complement the existing colour */
+            if (x & 1)
+                *q++ ^= mask.b[x++ & 15];
+            for (w = (UWORD *)q; x + 1 <= rect->x2; x += 2)
+                *w++ ^= mask.w[(x >> 1) & 7];
+            q = (UBYTE *)w;
+            if (x <= rect->x2)
+                *q ^= mask.b[x & 15];
+            break;
+        case WM_ERASE:          /* erase (reverse transparent) mode */
+        case WM_TRANS:          /* transparent mode */
+            if (x & 1) {
+                *q = (*q & ~mask.b[x & 15]) | val.b[x & 15];
+                q++, x++;
+            }
+            for (w = (UWORD *)q; x + 1 <= rect->x2; x += 2, w++)
+                *w = (*w & ~mask.w[(x >> 1) & 7]) | val.w[(x >> 1) & 7];
+            q = (UBYTE *)w;
+            if (x <= rect->x2)
+                *q = (*q & ~mask.b[x & 15]) | val.b[x & 15];
+            break;
+        default:                /* replace mode: background is colour 0 */
+            if (x & 1)
+                *q++ = val.b[x++ & 15];
+            for (w = (UWORD *)q; x + 1 <= rect->x2; x += 2)
+                *w++ = val.w[(x >> 1) & 7];
+            q = (UBYTE *)w;
+            if (x <= rect->x2)
+                *q = val.b[x & 15];
+            break;
+        }
+    }
+}
+#endif
+
+
 /*
  * swblit_rect_common - draw one or more horizontal lines via software
  *
@@ -825,6 +941,155 @@ void draw_line16(const Line *line, WORD wrt_mode, UWORD color)
 #endif
 
 
+#if CONF_WITH_CHUNKY8
+/*
+ * draw_line8 - draw a line (general purpose) in chunky 8bpp graphics
+ *
+ * see draw_line() below for further info
+ */
+void draw_line8(const Line *line, WORD wrt_mode, UWORD color)
+{
+    UBYTE *addr;
+    UBYTE fgcol;
+    UWORD linemask;
+    WORD dx, dy, yinc;
+    WORD eps, e1, e2;       /* epsilon, epsilon 1, epsilon 2 */
+    WORD loopcnt;
+
+    dx = line->x2 - line->x1;
+    dy = line->y2 - line->y1;
+    yinc = v_lin_wr;            /* in bytes */
+
+    if (dy < 0) {
+        dy = -dy;               /* make dy absolute */
+        yinc = -yinc;           /* subtract a line */
+    }
+
+    addr = (UBYTE *)get_start_addr(line->x1, line->y1); /* init address counter */
+    fgcol = color;
+
+    linemask = LN_MASK;
+
+    if (dx >= dy) {
+        e1 = 2*dy;
+        eps = -dx;
+        e2 = 2*dx;
+
+        switch(wrt_mode) {
+        case WM_ERASE:      /* reverse transparent  */
+            for (loopcnt = dx; loopcnt >= 0; loopcnt--) {
+                rolw1(linemask);        /* get next bit of line style */
+                if (!(linemask&0x0001))
+                    *addr = fgcol;
+                addr++;
+                eps += e1;
+                if (eps >= 0 ) {
+                    eps -= e2;
+                    addr += yinc;       /* increment y */
+                }
+            }
+            break;
+        case WM_XOR:        /* xor */
+            for (loopcnt = dx; loopcnt >= 0; loopcnt--) {
+                rolw1(linemask);        /* get next bit of line style */
+                if (linemask&0x0001)
+                    *addr ^= 0xff;
+                addr++;
+                eps += e1;
+                if (eps >= 0 ) {
+                    eps -= e2;
+                    addr += yinc;       /* increment y */
+                }
+            }
+            break;
+        case WM_TRANS:      /* transparent */
+            for (loopcnt = dx; loopcnt >= 0; loopcnt--) {
+                rolw1(linemask);        /* get next bit of line style */
+                if (linemask&0x0001)
+                    *addr = fgcol;
+                addr++;
+                eps += e1;
+                if (eps >= 0 ) {
+                    eps -= e2;
+                    addr += yinc;       /* increment y */
+                }
+            }
+            break;
+        case WM_REPLACE:    /* replace */
+            for (loopcnt = dx; loopcnt >= 0; loopcnt--) {
+                rolw1(linemask);        /* get next bit of line style */
+                *addr++ = (linemask&0x0001) ? fgcol : 0;
+                eps += e1;
+                if (eps >= 0 ) {
+                    eps -= e2;
+                    addr += yinc;       /* increment y */
+                }
+            }
+        }
+    } else {        /* dx < dy */
+        e1 = 2*dx;
+        eps = -dy;
+        e2 = 2*dy;
+
+        switch(wrt_mode) {
+        case WM_ERASE:      /* reverse transparent */
+            for (loopcnt = dy; loopcnt >= 0; loopcnt--) {
+                rolw1(linemask);        /* get next bit of line style */
+                if (!(linemask&0x0001))
+                    *addr = fgcol;
+                addr += yinc;
+                eps += e1;
+                if (eps >= 0 ) {
+                    eps -= e2;
+                    addr++;
+                }
+            }
+            break;
+        case WM_XOR:        /* xor */
+            for (loopcnt = dy; loopcnt >= 0; loopcnt--) {
+                rolw1(linemask);        /* get next bit of line style */
+                if (linemask&0x0001)
+                    *addr ^= 0xff;
+                addr += yinc;
+                eps += e1;
+                if (eps >= 0 ) {
+                    eps -= e2;
+                    addr++;
+                }
+            }
+            break;
+        case WM_TRANS:      /* transparent */
+            for (loopcnt = dy; loopcnt >= 0; loopcnt--) {
+                rolw1(linemask);        /* get next bit of line style */
+                if (linemask&0x0001)
+                    *addr = fgcol;
+                addr += yinc;
+                eps += e1;
+                if (eps >= 0 ) {
+                    eps -= e2;
+                    addr++;
+                }
+            }
+            break;
+        case WM_REPLACE:    /* replace */
+            for (loopcnt = dy; loopcnt >= 0; loopcnt--) {
+                rolw1(linemask);        /* get next bit of line style */
+                *addr = (linemask&0x0001) ? fgcol : 0;
+                addr += yinc;
+                eps += e1;
+                if (eps >= 0 ) {
+                    eps -= e2;
+                    addr++;
+                }
+            }
+        }
+    }
+
+    LN_MASK = linemask;
+}
+#endif
+
+
 /*
  * draw_line - draw a line (general purpose)
  *
@@ -1199,6 +1464,71 @@ void swblit_vertical_line16(const Line *line, WORD wrt_mode, UWORD color)
 }
 #endif
 
+#if CONF_WITH_CHUNKY8
+/*
+ * swblit_vertical_line8 - draw a vertical line in chunky 8bpp graphics
+ */
+void swblit_vertical_line8(const Line *line, WORD wrt_mode, UWORD color)
+{
+    UBYTE *addr;
+    UBYTE fgcol;
+    WORD dy;                    /* length of line */
+    WORD yinc;                  /* in/decrease for each y step */
+    WORD loopcnt;
+    UWORD linemask;
+
+    /* calculate increase value for y to add to actual address */
+    dy = line->y2 - line->y1;
+    yinc = v_lin_wr;            /* one line of bytes */
+
+    if (dy < 0) {
+        dy = -dy;               /* make dy absolute */
+        yinc = -yinc;           /* sub one line of bytes */
+    }
+
+    addr = (UBYTE *)get_start_addr(line->x1, line->y1); /* init address counter */
+    fgcol = color;
+
+    linemask = LN_MASK;
+
+    switch(wrt_mode) {
+    case WM_ERASE:          /* reverse transparent */
+        for (loopcnt = dy; loopcnt >= 0; loopcnt--) {
+            rolw1(linemask);        /* get next bit of line style */
+            if (!(linemask & 0x0001))
+                *addr = fgcol;
+            addr += yinc;
+        }
+        break;
+    case WM_XOR:            /* xor */
+        for (loopcnt = dy; loopcnt >= 0; loopcnt--) {
+            rolw1(linemask);        /* get next bit of line style */
+            if (linemask & 0x0001)
+                *addr ^= 0xff;
+            addr += yinc;
+        }
+        break;
+    case WM_TRANS:          /* transparent */
+        for (loopcnt = dy; loopcnt >= 0; loopcnt--) {
+            rolw1(linemask);        /* get next bit of line style */
+            if (linemask & 0x0001)
+                *addr = fgcol;
+            addr += yinc;
+        }
+        break;
+    case WM_REPLACE:        /* replace */
+        for (loopcnt = dy; loopcnt >= 0; loopcnt--) {
+            rolw1(linemask);        /* get next bit of line style */
+            *addr = (linemask & 0x0001) ? fgcol : 0;
+            addr += yinc;
+        }
+    }
+
+    LN_MASK = linemask;
+}
+#endif
+
+
 /*
  * vertical_line - draw a vertical line
  *
@@ -25,17 +25,26 @@ void hwblit_rect_common(const VwkAttrib *attr, const Rect *rect);
 #if CONF_WITH_VDI_16BIT
 void OPTIMIZE_SMALL swblit_rect_common16(const VwkAttrib *attr, const Rect *rect);
 #endif
+#if CONF_WITH_CHUNKY8
+void OPTIMIZE_SMALL swblit_rect_common8(const VwkAttrib *attr, const Rect *rect);
+#endif
 void OPTIMIZE_SMALL swblit_rect_common(const VwkAttrib *attr, const Rect *rect);
 
 #if CONF_WITH_VDI_16BIT
 void draw_line16(const Line *line, WORD wrt_mode, UWORD color);
 #endif
+#if CONF_WITH_CHUNKY8
+void draw_line8(const Line *line, WORD wrt_mode, UWORD color);
+#endif
 void draw_line(const Line *line, WORD wrt_mode, UWORD color);
 
 #if CONF_WITH_VDI_VERTLINE
 #if CONF_WITH_VDI_16BIT
 void swblit_vertical_line16(const Line *line, WORD wrt_mode, UWORD color);
 #endif
+#if CONF_WITH_CHUNKY8
+void swblit_vertical_line8(const Line *line, WORD wrt_mode, UWORD color);
+#endif
 void vertical_line(const Line *line, WORD wrt_mode, UWORD color);
 #endif
 
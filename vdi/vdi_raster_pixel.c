@@ -29,9 +29,6 @@
  UWORD
  get_color (UWORD mask, UWORD * addr)
  {
- #if CONF_WITH_CHUNKY8
-     return ((UBYTE*)addr)[mask]; /* mask is really x */
- #else
      UWORD color = 0;                    /* clear the pixel value accumulator. */
      WORD plane = v_planes;
  
@@ -47,7 +44,6 @@
      }
  
      return color;       /* this is the color we are searching for */
- #endif    
  }
 
 
@@ -81,11 +77,12 @@ pixelread(const WORD x, const WORD y)
     addr = get_start_addr(x, y);
 
 #if CONF_WITH_CHUNKY8
-    mask = x;
-#else
+    if (CHUNKY8_MODE)
+        return *(UBYTE *)addr;          /* the byte is the colour index */
+#endif
+
     addr += v_planes;                   /* start at highest-order bit_plane */
     mask = 0x8000 >> (x&0xf);           /* initial bit position in WORD */
-#endif
 
     return get_color(mask, addr);       /* return the composed color value */
 }
@@ -115,6 +112,9 @@ pixelread(const WORD x, const WORD y)
  pixelput(const WORD x, const WORD y)
  {
      UWORD *addr;
+     UWORD color;
+     UWORD mask;
+     int plane;
   
  #if CONF_WITH_VDI_16BIT
      if (TRUECOLOR_MODE)
@@ -138,13 +138,14 @@ pixelread(const WORD x, const WORD y)
      if (addr < (UWORD*)v_bas_ad || addr >= get_start_addr(V_REZ_HZ, V_REZ_VT)) {
          return;
      }
+     mark_screen_dirty(x, y, x, y);
  
  #if CONF_WITH_CHUNKY8
-     *((UBYTE*)addr) = (UBYTE)(INTIN[0]);
- #else
-     UWORD color;
-     UWORD mask;
-     int plane;
+     if (CHUNKY8_MODE) {
+         *(UBYTE *)addr = (UBYTE)INTIN[0];   /* store colour index */
+         return;
+     }
+ #endif
  
      mask = 0x8000 >> (x&0xf);   /* initial bit position in WORD */
      color = INTIN[0];           /* device dependent encoded color bits */
@@ -156,7 +157,6 @@ pixelread(const WORD x, const WORD y)
              *addr++ &= ~mask;
          color >>= 1;
      }
- #endif    
  }
  
 
@@ -239,6 +239,74 @@ WORD end_pts16(const VwkClip *clip, WORD x, WORD y, UWORD search_color, BOOL see
 
 
 
+#if CONF_WITH_CHUNKY8
+/*
+ * search_to_right8() - chunky 8bpp version of search_to_right()
+ */
+static UWORD search_to_right8(const VwkClip *clip, WORD x, const UBYTE search, const UBYTE *addr)
+{
+    /*
+     * scan upwards until pixel of different colour found
+     */
+    for ( ; x <= clip->xmx_clip; x++)
+    {
+        if (*addr++ != search)
+            break;
+    }
+
+    return x - 1;
+}
+
+
+
+/*
+ * search_to_left8() - chunky 8bpp version of search_to_left()
+ */
+static UWORD search_to_left8(const VwkClip *clip, WORD x, const UBYTE search, const UBYTE *addr)
+{
+    /*
+     * scan downwards until pixel of different colour found
+     */
+    for ( ; x >= clip->xmn_clip; x--)
+    {
+        if (*addr-- != search)
+            break;
+    }
+
+    return x + 1;
+}
+
+
+
+/*
+ * end_pts8() - chunky 8bpp version of end_pts()
+ */
+WORD end_pts8(const VwkClip *clip, WORD x, WORD y, UWORD search_color, BOOL seed_type, WORD *xleftout, WORD *xrightout)
+{
+    UBYTE color;
+    UBYTE *addr;
+
+    /*
+     * convert x,y to start address and get colour
+     */
+    addr = (UBYTE *)get_start_addr(x, y);
+    color = *addr;
+
+    /*
+     * get left and right end
+     */
+    *xrightout = search_to_right8(clip, x, color, addr);
+    *xleftout = search_to_left8(clip, x, color, addr);
+
+    if (color != search_color)
+        return seed_type ^ 1;   /* return segment not of search color */
+
+    return seed_type ^ 0;       /* return segment is of search color */
+}
+#endif
+
+
+
 UWORD
 search_to_right (const VwkClip * clip, WORD x, UWORD mask, const UWORD search_col, UWORD * addr)
 {
@@ -246,13 +314,10 @@ search_to_right (const VwkClip * clip, WORD x, UWORD mask, const UWORD search_co
     while( x++ < clip->xmx_clip ) {
         UWORD color;
 
-#if CONF_WITH_CHUNKY8
-#else
         /* need to jump over interleaved bit_plane? */
         rorw1(mask);    /* rotate right */
         if ( mask & 0x8000 )
             addr += v_planes;
-#endif
         /* search, while pixel color != search color */
         color = get_color(mask, addr);
         if ( search_col != color ) {
@@ -273,13 +338,10 @@ search_to_left (const VwkClip * clip, WORD x, UWORD mask, const UWORD search_col
     while (x-- > clip->xmn_clip) {
         UWORD color;
 
-#if CONF_WITH_CHUNKY8
-#else
         /* need to jump over interleaved bit_plane? */
         rolw1(mask);    /* rotate left */
         if ( mask & 0x0001 )
             addr -= v_planes;
-#endif
 
         /* search, while pixel color != search color */
         color = get_color(mask, addr);
@@ -326,13 +388,17 @@ end_pts(const VwkClip *clip, WORD x, WORD y, UWORD search_color, BOOL seed_type,
     }
 #endif
 
+#if CONF_WITH_CHUNKY8
+    if (CHUNKY8_MODE)
+    {
+        return end_pts8(clip, x, y, search_color, seed_type, xleftout, xrightout);
+    }
+#endif
+
     /* convert x,y to start address and bit mask */
     addr = get_start_addr(x, y);
-#if CONF_WITH_CHUNKY8    
-#else    
     addr += v_planes;                   /* start at highest-order bit_plane */
     mask = 0x8000 >> (x & 0x000f);   /* fetch the pixel mask. */
-#endif
 
     /* get search color and the left and right end */
     color = get_color (mask, addr);
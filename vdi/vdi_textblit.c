@@ -836,6 +836,72 @@ static void direct_screen_blit16(WORD count, WORD *str)
 #endif
 
 
+#if CONF_WITH_CHUNKY8
+/*
+ * expand 2 bits of a glyph to a mask of 2 chunky pixels
+ */
+static const UWORD pair_mask8[4] = { 0x0000, 0x00ff, 0xff00, 0xffff };
+
+/*
+ * output a character string directly to the chunky 8bpp screen
+ *
+ * see direct_screen_blit() for details of usage.  since DESTX is a
+ * multiple of 8, each row of a glyph is exactly four words of screen.
+ * we don't use long words: the screen may be in VICKY's VRAM, which
+ * doesn't support long writes.
+ */
+static void direct_screen_blit8(WORD count, WORD *str)
+{
+    WORD height, mode, n, i;
+    WORD src_width, dst_width;
+    UWORD fill, m, bits;
+    UBYTE *src, *p;
+    UWORD *dst, *save_dst, *q;
+
+    height = DELY;
+    mode = WRT_MODE;
+    src_width = FWIDTH;
+    dst_width = v_lin_wr / sizeof(UWORD);
+
+    fill = (UBYTE)TEXTFG * 0x0101U;
+
+    dst = (UWORD *)get_start_addr(DESTX, DESTY);
+
+    for ( ; count > 0; count--)
+    {
+        src = (UBYTE *)FBASE + *str++;
+        save_dst = dst;
+
+        for (n = height, p = src, q = dst; n > 0; n--, p += src_width, q += dst_width)
+        {
+            for (i = 0, bits = *p; i < 4; i++, bits <<= 2)
+            {
+                m = pair_mask8[(bits >> 6) & 3];
+
+                switch(mode) {
+                default:    /* WM_REPLACE */
+                    q[i] = fill & m;
+                    break;
+                case WM_TRANS:
+                    q[i] = (q[i] & ~m) | (fill & m);
+                    break;
+                case WM_XOR:
+                    q[i] ^= m;
+                    break;
+                case WM_ERASE:
+                    /* see the comments in direct_screen_blit16() */
+                    q[i] = (q[i] & m) | (fill & ~m);
+                    break;
+                }
+            }
+        }
+
+        dst = save_dst + 4;
+    }
+}
+#endif
+
+
 /*
  * output a character string directly to the screen
  *
@@ -864,6 +930,15 @@ void direct_screen_blit(WORD count, WORD *str)
         return;
     }
 #endif
+    mark_screen_dirty(DESTX, DESTY, DESTX + count * 8 - 1, DESTY + height - 1);
+
+#if CONF_WITH_CHUNKY8
+    if (CHUNKY8_MODE)
+    {
+        direct_screen_blit8(count, str);
+        return;
+    }
+#endif
 
     dst = (UBYTE *)get_start_addr(DESTX, DESTY);
 
@@ -1186,6 +1261,227 @@ static void screen_blit16(LOCALVARS *vars)
 #endif
 
 
+#if CONF_WITH_CHUNKY8
+/*
+ * output a glyph to the chunky 8bpp screen
+ *
+ * this is the same as screen_blit16(), but with a byte per pixel
+ */
+static void screen_blit8(LOCALVARS *vars)
+{
+    UWORD *p;
+    UBYTE *src, *dst, *q;
+    UBYTE fgcol;
+    WORD h, w, skew, skew_start;
+    UWORD src_mask, mask, skew_mask;
+
+    /*
+     * set skew-related values
+     *
+     * NOTE: we can't test for skewed text using vars->STYLE, since
+     * pre_blit() clears F_SKEW and F_THICKEN after it has processed them.
+     */
+    skew = LOFF + ROFF;
+    skew_mask = (UWORD)vars->skew_msk;
+    skew_start = vars->height;
+
+    /*
+     * the following adjustments are for skewed+outlined text, and make
+     * the output almost the same as produced by TOS4.
+     *
+     * 1. since the source of skewed and/or outlined text must be an
+     *    intermediate buffer, SOURCEX *must* be 0, and we force that.
+     *    NOTE: in versions of TOS prior to TOS4 (& in TOS4 non-TC
+     *    resolutions), this adjustment is not made.  As a result, text
+     *    output is typically clipped.
+     *
+     * 2. a negative value for the nominal destination position is OK,
+     *    because outlining has adjusted the starting position of characters
+     *    leftwards.  however, such values are prohibited by do_clip(),
+     *    which adjusts var->DESTX.  we adjust it back here ...
+     *    NOTE: this situation can only happen at the beginning of a
+     *    screen line.
+     *
+     * 3. for bigger fonts, skewing must not start at the bottom of the
+     *    buffer, otherwise parts of the outline are clipped too agressively.
+     *    at the moment, this fix is a bit of a kludge, though it works well
+     *    enough.
+     */
+    if (skew && (vars->STYLE&F_OUTLINE))
+    {
+        if (SOURCEX)
+        {
+            KDEBUG(("SOURCEX (was %d) forced to zero for intermediate buffer\n",SOURCEX));
+            SOURCEX = 0;
+            vars->tsdad = 0;    /* this was set from SOURCEX in screen_blit() */
+        }
+
+        if (DESTX < 0)
+        {
+            KDEBUG(("vars->DESTX (was %d) set to DESTX (%d)\n",vars->DESTX,DESTX));
+            vars->DESTX = DESTX;
+        }
+        if (vars->height > 8)       /* not a 6-point font */
+            skew_start -= OUTLINE_THICKNESS;
+    }
+
+    /*
+     * set up source stuff
+     */
+    src = vars->sform;
+    src_mask = 0x8000 >> vars->tsdad;
+
+    /*
+     * set up destination stuff
+     */
+    vars->dform = v_bas_ad;
+    vars->dform += vars->DESTX;                     /* add x coordinate part of addr */
+    vars->dform += (UWORD)(vars->DESTY+vars->DELY-1) * (ULONG)v_lin_wr; /* add y coordinate part of addr */
+    vars->d_next = -v_lin_wr;
+    dst = vars->dform;
+
+    /*
+     * set up colours
+     */
+    fgcol = vars->forecol;
+
+    switch(vars->WRT_MODE) {
+    /*
+     * when called via lineA, modes 4-19 (corresponding to BitBlt modes 0-15)
+     * are theoretically possible.  however, at this time we do not support them.
+     */
+    default:    /* WM_REPLACE */
+        for (h = vars->height; h > 0; h--, src += vars->s_next, dst += vars->d_next)
+        {
+            p = (UWORD *)src;
+            q = dst;
+            for (w = vars->width, mask = src_mask; w > 0; w--)
+            {
+                *q++ = (*p & mask) ? fgcol : 0;
+                rorw1(mask);
+                if (mask == 0x8000)
+                    p++;
+            }
+            /*
+             * special handling for skewed text: since the character cells
+             * are effectively slanted, we must shift the starting position
+             * of a cell rightwards as we go up the character.
+             */
+            if (skew && (h <= skew_start))  /* OK to shift box for skewed text? */
+            {
+                rolw1(skew_mask);
+                if (skew_mask & 0x8000)
+                {
+                    rorw1(src_mask);
+                    if (src_mask == 0x8000)
+                        src++;
+                    dst++;
+                }
+            }
+        }
+        break;
+    case WM_TRANS:
+        for (h = vars->height; h > 0; h--, src += vars->s_next, dst += vars->d_next)
+        {
+            p = (UWORD *)src;
+            q = dst;
+            for (w = vars->width, mask = src_mask; w > 0; w--)
+            {
+                if (*p & mask)
+                    *q = fgcol;
+                q++;
+                rorw1(mask);
+                if (mask == 0x8000)
+                    p++;
+            }
+            /*
+             * see comments for WM_REPLACE (above) for an explanation of
+             * the following
+             */
+            if (skew && (h <= skew_start))  /* OK to shift box for skewed text? */
+            {
+                rolw1(skew_mask);
+                if (skew_mask & 0x8000)
+                {
+                    rorw1(src_mask);
+                    if (src_mask == 0x8000)
+                        src++;
+                    dst++;
+                }
+            }
+        }
+        break;
+    case WM_XOR:
+        for (h = vars->height; h > 0; h--, src += vars->s_next, dst += vars->d_next)
+        {
+            p = (UWORD *)src;
+            q = dst;
+            for (w = vars->width, mask = src_mask; w > 0; w--)
+            {
+                if (*p & mask)
+                    *q ^= 0xff;
+                q++;
+                rorw1(mask);
+                if (mask == 0x8000)
+                    p++;
+            }
+            /*
+             * see comments for WM_REPLACE (above) for an explanation of
+             * the following
+             */
+            if (skew && (h <= skew_start))  /* OK to shift box for skewed text? */
+            {
+                rolw1(skew_mask);
+                if (skew_mask & 0x8000)
+                {
+                    rorw1(src_mask);
+                    if (src_mask == 0x8000)
+                        src++;
+                    dst++;
+                }
+            }
+        }
+        break;
+    case WM_ERASE:
+        for (h = vars->height; h > 0; h--, src += vars->s_next, dst += vars->d_next)
+        {
+            p = (UWORD *)src;
+            q = dst;
+            for (w = vars->width, mask = src_mask; w > 0; w--)
+            {
+                /*
+                 * behaviour here differs from TOS 4.04 - for further info,
+                 * see the comments in direct_screen_blit16()
+                 */
+                if (!(*p & mask))
+                    *q = fgcol;
+                q++;
+                rorw1(mask);
+                if (mask == 0x8000)
+                    p++;
+            }
+            /*
+             * see comments for WM_REPLACE (above) for an explanation of
+             * the following
+             */
+            if (skew && (h <= skew_start))  /* OK to shift box for skewed text? */
+            {
+                rolw1(skew_mask);
+                if (skew_mask & 0x8000)
+                {
+                    rorw1(src_mask);
+                    if (src_mask == 0x8000)
+                        src++;
+                    dst++;
+                }
+            }
+        }
+        break;
+    }
+}
+#endif
+
+
 /*
  * output a glyph to the screen
  *
@@ -1213,6 +1509,10 @@ static void screen_blit(LOCALVARS *vars)
     vars->sform += offset;
     vars->s_next = -vars->s_next;   /* we draw from the bottom up */
 
+    /* skewed text extends to the right of the cell */
+    mark_screen_dirty(vars->DESTX, vars->DESTY,
+                      vars->DESTX + vars->width + LOFF + ROFF - 1, vars->DESTY + vars->height - 1);
+
 #if CONF_WITH_VDI_16BIT
     if (TRUECOLOR_MODE)
     {
@@ -1220,6 +1520,13 @@ static void screen_blit(LOCALVARS *vars)
         return;
     }
 #endif
+#if CONF_WITH_CHUNKY8
+    if (CHUNKY8_MODE)
+    {
+        screen_blit8(vars);
+        return;
+    }
+#endif
 
     /*
      * calculate the screen address
@@ -1365,7 +1672,7 @@ void text_blt(void)
      * so we can manipulate it before the actual screen blit
      *
      * we copy in the following situations:
-     *  (in 16-bit mode) if (skewing OR thickening OR outlining), OR
+     *  (in 16-bit or chunky mode) if (skewing OR thickening OR outlining), OR
      *  if outlining, OR
      *     rotating AND (skewing OR thickening), OR
      *     skewing AND clipping-is-required,
@@ -1375,6 +1682,11 @@ void text_blt(void)
     if (TRUECOLOR_MODE && (vars.STYLE & (F_SKEW|F_THICKEN|F_OUTLINE)))
         need_preblit = TRUE;
     else
+#endif
+#if CONF_WITH_CHUNKY8
+    if (CHUNKY8_MODE && (vars.STYLE & (F_SKEW|F_THICKEN|F_OUTLINE)))
+        need_preblit = TRUE;
+    else
 #endif
     if (vars.STYLE & F_OUTLINE)
         need_preblit = TRUE;